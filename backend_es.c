@@ -0,0 +1,577 @@
+#include "kernel.h"
+#include "backend_es.h"
+
+/* Sin liburing: io_uring_setup/enter/register por syscall() y los anillos mapeados a mano.
+   Lo encolado viaja en el siguiente io_uring_enter, normalmente el que duerme el quantum. */
+
+#define ENTRADAS_URING 64
+#define MAX_ESPERAS_URING 64
+#define MAX_SONDEOS_URING 8
+#define MAX_ESCRITURAS_URING 32
+/* IORING_OP_WAITID es de Linux 6.7; las cabeceras instaladas pueden ser anteriores. */
+#define OP_URING_WAITID 50
+
+typedef enum
+{
+    DATO_URING_TEMPORIZADOR = 1,
+    DATO_URING_ESPERA,
+    DATO_URING_SONDEO,
+    DATO_URING_ESCRITURA,
+    DATO_URING_CIERRE
+} TipoDatoUring;
+
+typedef struct
+{
+    pid_t pid;
+    int en_vuelo;
+    int terminado;
+    siginfo_t info;
+} EsperaUring;
+
+typedef struct
+{
+    int fd;
+    int en_vuelo;
+    int listo;
+} SondeoUring;
+
+/* Una escritura diferida: writev + close enlazados sobre un fd y un buffer que le pertenecen.
+   Si el writev se queda corto el close llega cancelado y se encola el resto. */
+typedef struct
+{
+    int ocupada;
+    int fd;
+    char *buffer;
+    struct iovec partes[2];
+    off_t posicion;
+    size_t pendiente;
+    int error;
+    char ruta[64];
+    const char *contexto;
+} EscrituraUring;
+
+typedef struct
+{
+    int fd;
+    unsigned entradas_sq;
+    unsigned *sq_cabeza, *sq_cola, *sq_mascara, *sq_indices;
+    unsigned *cq_cabeza, *cq_cola, *cq_mascara;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    int con_waitid;
+
+    /* Las finalizaciones de un ciclo anterior llevan otra generación y se descartan. */
+    unsigned generacion;
+    EsperaUring esperas[MAX_ESPERAS_URING];
+    SondeoUring sondeos[MAX_SONDEOS_URING];
+
+    struct __kernel_timespec objetivo;
+    unsigned temporizador;
+    unsigned temporizador_vencido;
+
+    EscrituraUring escrituras[MAX_ESCRITURAS_URING];
+    int escrituras_en_vuelo;
+} AnilloUring;
+
+BackendES backend_es = BACKEND_ES_CLASICO;
+static AnilloUring anillo_uring;
+long llamadas_es_ciclo = 0;
+
+uint64_t dato_uring(TipoDatoUring tipo, unsigned indice)
+{
+    return ((uint64_t)tipo << 56) | ((uint64_t)(anillo_uring.generacion & 0xffffff) << 32) | indice;
+}
+
+int iniciar_backend_uring()
+{
+    AnilloUring *a = &anillo_uring;
+    struct io_uring_params p;
+
+    memset(a, 0, sizeof(AnilloUring));
+    memset(&p, 0, sizeof(p));
+    a->fd = syscall(__NR_io_uring_setup, ENTRADAS_URING, &p);
+    if (a->fd < 0)
+        return -1;
+
+    size_t tam_sq = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t tam_cq = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if ((p.features & IORING_FEAT_SINGLE_MMAP) && tam_cq > tam_sq)
+        tam_sq = tam_cq;
+
+    char *sq = mmap(NULL, tam_sq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, a->fd, IORING_OFF_SQ_RING);
+    char *cq = (p.features & IORING_FEAT_SINGLE_MMAP)
+                   ? sq
+                   : mmap(NULL, tam_cq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, a->fd, IORING_OFF_CQ_RING);
+    a->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, a->fd, IORING_OFF_SQES);
+    if (sq == MAP_FAILED || cq == MAP_FAILED || a->sqes == MAP_FAILED)
+    {
+        close(a->fd);
+        return -1;
+    }
+
+    a->entradas_sq = p.sq_entries;
+    a->sq_cabeza = (unsigned *)(sq + p.sq_off.head);
+    a->sq_cola = (unsigned *)(sq + p.sq_off.tail);
+    a->sq_mascara = (unsigned *)(sq + p.sq_off.ring_mask);
+    a->sq_indices = (unsigned *)(sq + p.sq_off.array);
+    a->cq_cabeza = (unsigned *)(cq + p.cq_off.head);
+    a->cq_cola = (unsigned *)(cq + p.cq_off.tail);
+    a->cq_mascara = (unsigned *)(cq + p.cq_off.ring_mask);
+    a->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    /* Sin la sonda (Linux < 5.6) tampoco están las operaciones que hacen falta. */
+    struct io_uring_probe *sonda = calloc(1, sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op));
+    if (!sonda || syscall(__NR_io_uring_register, a->fd, IORING_REGISTER_PROBE, sonda, 256) < 0)
+    {
+        free(sonda);
+        close(a->fd);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    const int necesarias[] = {IORING_OP_WRITE, IORING_OP_WRITEV, IORING_OP_CLOSE, IORING_OP_POLL_ADD, IORING_OP_TIMEOUT};
+    for (size_t i = 0; i < sizeof(necesarias) / sizeof(necesarias[0]); i++)
+    {
+        if (necesarias[i] > sonda->last_op || !(sonda->ops[necesarias[i]].flags & IO_URING_OP_SUPPORTED))
+        {
+            free(sonda);
+            close(a->fd);
+            errno = ENOSYS;
+            return -1;
+        }
+    }
+    a->con_waitid = OP_URING_WAITID <= sonda->last_op && (sonda->ops[OP_URING_WAITID].flags & IO_URING_OP_SUPPORTED);
+    free(sonda);
+    return 0;
+}
+
+void iniciar_backend_es()
+{
+    if (backend_es != BACKEND_ES_URING)
+        return;
+
+    if (iniciar_backend_uring() == -1)
+    {
+        printf(COLOR_ERROR "[Control Central] AVISO: " ANSI_RESET "io_uring no disponible (%s); se usa el camino de E/S clásico.\n",
+               strerror(errno));
+        backend_es = BACKEND_ES_CLASICO;
+        return;
+    }
+
+    printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Backend de E/S: io_uring (%u entradas, esperas de huéspedes %s).\n",
+           anillo_uring.entradas_sq, anillo_uring.con_waitid ? "con IORING_OP_WAITID" : "con wait4: el kernel no tiene WAITID");
+}
+
+unsigned sqes_sin_enviar()
+{
+    return *anillo_uring.sq_cola - __atomic_load_n(anillo_uring.sq_cabeza, __ATOMIC_ACQUIRE);
+}
+
+int entrar_uring(unsigned esperar)
+{
+    int r = syscall(__NR_io_uring_enter, anillo_uring.fd, sqes_sin_enviar(), esperar,
+                    esperar ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    return (r < 0 && errno == EINTR) ? 0 : r;
+}
+
+struct io_uring_sqe *sqe_uring(uint8_t operacion, uint64_t dato)
+{
+    AnilloUring *a = &anillo_uring;
+
+    if (sqes_sin_enviar() == a->entradas_sq)
+        entrar_uring(0);
+
+    unsigned cola = *a->sq_cola;
+    unsigned indice = cola & *a->sq_mascara;
+    struct io_uring_sqe *sqe = &a->sqes[indice];
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    sqe->opcode = operacion;
+    sqe->user_data = dato;
+    a->sq_indices[indice] = indice;
+    __atomic_store_n(a->sq_cola, cola + 1, __ATOMIC_RELEASE);
+    return sqe;
+}
+
+/* writev y close de la escritura 'indice', enlazados: el close solo corre si el writev
+   escribió todo. Los dos SQE tienen que viajar en el mismo enter para que el enlace valga. */
+void encolar_escritura_uring(int indice)
+{
+    AnilloUring *a = &anillo_uring;
+    EscrituraUring *e = &a->escrituras[indice];
+
+    if (a->entradas_sq - sqes_sin_enviar() < 2)
+        entrar_uring(0);
+
+    struct io_uring_sqe *sqe = sqe_uring(IORING_OP_WRITEV, ((uint64_t)DATO_URING_ESCRITURA << 56) | indice);
+    sqe->fd = e->fd;
+    sqe->addr = (unsigned long)(e->partes[0].iov_len > 0 ? e->partes : e->partes + 1);
+    sqe->len = e->partes[0].iov_len > 0 ? 2 : 1;
+    sqe->off = e->posicion;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe = sqe_uring(IORING_OP_CLOSE, ((uint64_t)DATO_URING_CIERRE << 56) | indice);
+    sqe->fd = e->fd;
+}
+
+void avanzar_escritura_uring(EscrituraUring *e, size_t escritos)
+{
+    e->pendiente -= escritos;
+    if (e->posicion != (off_t)-1)
+        e->posicion += escritos;
+    for (int i = 0; i < 2 && escritos > 0; i++)
+    {
+        size_t parte = escritos < e->partes[i].iov_len ? escritos : e->partes[i].iov_len;
+        e->partes[i].iov_base = (char *)e->partes[i].iov_base + parte;
+        e->partes[i].iov_len -= parte;
+        escritos -= parte;
+    }
+}
+
+void cerrar_escritura_uring(int indice, int resultado)
+{
+    AnilloUring *a = &anillo_uring;
+    EscrituraUring *e = &a->escrituras[indice];
+
+    if (resultado == -ECANCELED && !e->error && e->pendiente > 0)
+    {
+        encolar_escritura_uring(indice);
+        return;
+    }
+    if (resultado == -ECANCELED)
+        close(e->fd);
+    else if (resultado < 0 && !e->error)
+        e->error = -resultado;
+
+    if (e->error)
+        fprintf(stderr, COLOR_ERROR "%s: %s\n" ANSI_RESET, e->contexto, strerror(e->error));
+    free(e->buffer);
+    memset(e, 0, sizeof(EscrituraUring));
+    a->escrituras_en_vuelo--;
+}
+
+void procesar_completados_uring()
+{
+    AnilloUring *a = &anillo_uring;
+    unsigned cabeza = *a->cq_cabeza;
+
+    while (cabeza != __atomic_load_n(a->cq_cola, __ATOMIC_ACQUIRE))
+    {
+        const struct io_uring_cqe *cqe = &a->cqes[cabeza & *a->cq_mascara];
+        TipoDatoUring tipo = cqe->user_data >> 56;
+        unsigned generacion = (cqe->user_data >> 32) & 0xffffff;
+        unsigned indice = cqe->user_data & 0xffffffff;
+        int vigente = generacion == (a->generacion & 0xffffff);
+
+        switch (tipo)
+        {
+        case DATO_URING_TEMPORIZADOR:
+            a->temporizador_vencido = indice;
+            break;
+        case DATO_URING_ESPERA:
+            if (vigente && indice < MAX_ESPERAS_URING)
+            {
+                a->esperas[indice].en_vuelo = 0;
+                a->esperas[indice].terminado = 1;
+            }
+            break;
+        case DATO_URING_SONDEO:
+            if (vigente && indice < MAX_SONDEOS_URING)
+            {
+                a->sondeos[indice].en_vuelo = 0;
+                a->sondeos[indice].listo = 1;
+            }
+            break;
+        case DATO_URING_ESCRITURA:
+            if (indice < MAX_ESCRITURAS_URING && cqe->res < 0)
+                a->escrituras[indice].error = -cqe->res;
+            else if (indice < MAX_ESCRITURAS_URING)
+                avanzar_escritura_uring(&a->escrituras[indice], cqe->res);
+            break;
+        case DATO_URING_CIERRE:
+            if (indice < MAX_ESCRITURAS_URING)
+                cerrar_escritura_uring(indice, cqe->res);
+            break;
+        }
+        cabeza++;
+    }
+    __atomic_store_n(a->cq_cabeza, cabeza, __ATOMIC_RELEASE);
+}
+
+void reiniciar_backend_es()
+{
+    llamadas_es_ciclo = 0;
+    if (backend_es != BACKEND_ES_URING)
+        return;
+
+    procesar_completados_uring();
+    anillo_uring.generacion++;
+    memset(anillo_uring.esperas, 0, sizeof(anillo_uring.esperas));
+    memset(anillo_uring.sondeos, 0, sizeof(anillo_uring.sondeos));
+}
+
+void dormir_hasta_uring(double instante)
+{
+    AnilloUring *a = &anillo_uring;
+    unsigned id = ++a->temporizador;
+
+    a->objetivo.tv_sec = (long long)instante;
+    a->objetivo.tv_nsec = (long long)((instante - a->objetivo.tv_sec) * 1000000000.0);
+    struct io_uring_sqe *sqe = sqe_uring(IORING_OP_TIMEOUT, ((uint64_t)DATO_URING_TEMPORIZADOR << 56) | id);
+    sqe->addr = (unsigned long)&a->objetivo;
+    sqe->len = 1;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;
+
+    while (a->temporizador_vencido != id)
+    {
+        if (entrar_uring(1) < 0)
+        {
+            perror(COLOR_ERROR "io_uring_enter" ANSI_RESET);
+            exit(1);
+        }
+        procesar_completados_uring();
+    }
+}
+
+int escribir_todo_es(int fd, const char *datos, size_t largo)
+{
+    while (largo > 0)
+    {
+        llamadas_es_ciclo++;
+        ssize_t escritos = write(fd, datos, largo);
+        if (escritos == -1 && errno == EINTR)
+            continue;
+        if (escritos == -1)
+            return -1;
+
+        datos += escritos;
+        largo -= escritos;
+    }
+    return 0;
+}
+
+void enviar_escrituras_es()
+{
+    if (backend_es != BACKEND_ES_URING || sqes_sin_enviar() == 0)
+        return;
+    llamadas_es_ciclo++;
+    entrar_uring(0);
+}
+
+void vaciar_escrituras_es()
+{
+    if (backend_es != BACKEND_ES_URING)
+        return;
+    while (anillo_uring.escrituras_en_vuelo > 0)
+    {
+        llamadas_es_ciclo++;
+        if (entrar_uring(1) < 0)
+        {
+            perror(COLOR_ERROR "io_uring_enter" ANSI_RESET);
+            exit(1);
+        }
+        procesar_completados_uring();
+    }
+}
+
+EscrituraUring *reservar_escritura_uring(const char *ruta)
+{
+    AnilloUring *a = &anillo_uring;
+
+    for (int i = 0; ruta && i < MAX_ESCRITURAS_URING; i++)
+        if (a->escrituras[i].ocupada && strcmp(a->escrituras[i].ruta, ruta) == 0)
+        {
+            vaciar_escrituras_es();
+            break;
+        }
+    if (a->escrituras_en_vuelo == MAX_ESCRITURAS_URING)
+        vaciar_escrituras_es();
+
+    int i = 0;
+    while (a->escrituras[i].ocupada)
+        i++;
+    a->escrituras[i].ocupada = 1;
+    a->escrituras_en_vuelo++;
+    return &a->escrituras[i];
+}
+
+/* Se queda con 'datos' (de malloc) y con fd. */
+void escribir_y_cerrar_es(int fd, char *datos, size_t largo, const char *contexto)
+{
+    if (backend_es != BACKEND_ES_URING)
+    {
+        if (escribir_todo_es(fd, datos, largo) == -1)
+            perror(contexto);
+        llamadas_es_ciclo++;
+        close(fd);
+        free(datos);
+        return;
+    }
+
+    EscrituraUring *e = reservar_escritura_uring(NULL);
+    e->fd = fd;
+    e->buffer = datos;
+    e->partes[1] = (struct iovec){.iov_base = datos, .iov_len = largo};
+    e->posicion = (off_t)-1;
+    e->pendiente = largo;
+    e->contexto = contexto;
+    encolar_escritura_uring(e - anillo_uring.escrituras);
+}
+
+/* Sobrescribe el "\n]" final; se queda con 'elemento' (de malloc). */
+int anexar_json_es(const char *ruta, char *elemento, size_t largo, const char *contexto)
+{
+    EscrituraUring *e = backend_es == BACKEND_ES_URING ? reservar_escritura_uring(ruta) : NULL;
+    int fd = open(ruta, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    struct stat st;
+
+    llamadas_es_ciclo += 2;
+    if (fd == -1 || fstat(fd, &st) == -1)
+    {
+        if (fd != -1)
+            close(fd);
+        if (e)
+        {
+            memset(e, 0, sizeof(EscrituraUring));
+            anillo_uring.escrituras_en_vuelo--;
+        }
+        free(elemento);
+        return -1;
+    }
+
+    struct iovec partes[2];
+    off_t posicion = st.st_size;
+    partes[0].iov_base = (void *)"";
+    if (st.st_size == 0)
+        partes[0].iov_base = (void *)"[\n";
+    else if (st.st_size > 2)
+    {
+        partes[0].iov_base = (void *)",\n";
+        posicion = st.st_size - 2;
+    }
+    partes[0].iov_len = strlen(partes[0].iov_base);
+    partes[1].iov_base = elemento;
+    partes[1].iov_len = largo;
+
+    if (e)
+    {
+        e->fd = fd;
+        e->buffer = elemento;
+        memcpy(e->partes, partes, sizeof(partes));
+        e->posicion = posicion;
+        e->pendiente = partes[0].iov_len + largo;
+        snprintf(e->ruta, sizeof(e->ruta), "%s", ruta);
+        e->contexto = contexto;
+        encolar_escritura_uring(e - anillo_uring.escrituras);
+        return 0;
+    }
+
+    ssize_t escritos = pwritev(fd, partes, 2, posicion);
+    llamadas_es_ciclo += 2;
+    close(fd);
+    free(elemento);
+    return escritos == (ssize_t)(partes[0].iov_len + largo) ? 0 : -1;
+}
+
+SondeoUring *sondeo_uring(int fd)
+{
+    SondeoUring *libre = NULL;
+
+    for (int i = 0; i < MAX_SONDEOS_URING; i++)
+    {
+        SondeoUring *s = &anillo_uring.sondeos[i];
+        if (s->fd == fd && (s->en_vuelo || s->listo))
+            return s;
+        if (!libre && !s->en_vuelo && !s->listo)
+            libre = s;
+    }
+    if (libre)
+    {
+        libre->fd = fd;
+        libre->listo = 1;
+    }
+    return libre;
+}
+
+/* Con io_uring solo se llama a read cuando un sondeo avisó de datos; una lectura corta
+   vacía el pipe y rearma el sondeo. */
+ssize_t leer_es(int fd, void *buffer, size_t largo)
+{
+    SondeoUring *s = backend_es == BACKEND_ES_URING ? sondeo_uring(fd) : NULL;
+
+    if (s && !s->listo)
+    {
+        if (sqes_sin_enviar() > 0)
+        {
+            llamadas_es_ciclo++;
+            entrar_uring(0);
+        }
+        procesar_completados_uring();
+        if (!s->listo)
+        {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+
+    llamadas_es_ciclo++;
+    ssize_t leidos = read(fd, buffer, largo);
+
+    if (s && (leidos == -1 || (leidos > 0 && (size_t)leidos < largo)))
+    {
+        s->listo = 0;
+        s->en_vuelo = 1;
+        struct io_uring_sqe *sqe = sqe_uring(IORING_OP_POLL_ADD, dato_uring(DATO_URING_SONDEO, s - anillo_uring.sondeos));
+        sqe->fd = fd;
+        sqe->poll32_events = POLLIN;
+    }
+    return leidos;
+}
+
+/* Con IORING_OP_WAITID, wait4 solo recoge el estado y el rusage. */
+pid_t sondear_hijo(pid_t pid, int *status, struct rusage *uso)
+{
+    EsperaUring *e = NULL;
+
+    if (backend_es == BACKEND_ES_URING && anillo_uring.con_waitid)
+    {
+        EsperaUring *libre = NULL;
+        for (int i = 0; i < MAX_ESPERAS_URING && !e; i++)
+        {
+            if (anillo_uring.esperas[i].pid == pid)
+                e = &anillo_uring.esperas[i];
+            else if (!libre && anillo_uring.esperas[i].pid == 0)
+                libre = &anillo_uring.esperas[i];
+        }
+
+        if (!e && libre)
+        {
+            e = libre;
+            e->pid = pid;
+            e->en_vuelo = 1;
+            e->terminado = 0;
+            struct io_uring_sqe *sqe = sqe_uring(OP_URING_WAITID, dato_uring(DATO_URING_ESPERA, e - anillo_uring.esperas));
+            sqe->fd = pid;
+            sqe->len = P_PID;
+            sqe->file_index = WEXITED | WNOWAIT;
+            sqe->addr2 = (unsigned long)&e->info;
+        }
+
+        if (e)
+        {
+            if (!e->terminado && sqes_sin_enviar() > 0)
+            {
+                llamadas_es_ciclo++;
+                entrar_uring(0);
+            }
+            procesar_completados_uring();
+            if (!e->terminado)
+                return 0;
+        }
+    }
+
+    llamadas_es_ciclo++;
+    pid_t terminado = wait4(pid, status, WNOHANG, uso);
+    if (e && terminado != 0)
+        e->pid = 0;
+    return terminado;
+}
@@ -0,0 +1,24 @@
+#ifndef BACKEND_ES_H
+#define BACKEND_ES_H
+
+typedef enum
+{
+    BACKEND_ES_CLASICO,
+    BACKEND_ES_URING
+} BackendES;
+
+extern BackendES backend_es;
+extern long llamadas_es_ciclo;
+
+void iniciar_backend_es();
+void reiniciar_backend_es();
+void dormir_hasta_uring(double instante);
+int escribir_todo_es(int fd, const char *datos, size_t largo);
+void enviar_escrituras_es();
+void vaciar_escrituras_es();
+void escribir_y_cerrar_es(int fd, char *datos, size_t largo, const char *contexto);
+int anexar_json_es(const char *ruta, char *elemento, size_t largo, const char *contexto);
+ssize_t leer_es(int fd, void *buffer, size_t largo);
+pid_t sondear_hijo(pid_t pid, int *status, struct rusage *uso);
+
+#endif
@@ -0,0 +1,424 @@
+/* Microbenchmarks de las primitivas del orquestador.
+   Incluye kernel.c sin su main para medir las mismas funciones que usan los escenarios.
+
+   make bench_kernel
+   ./bench_kernel [repeticiones] [sensores] (desde la raíz del repositorio) */
+
+#define KERNEL_SIN_MAIN
+#include "kernel.c"
+
+#define REPETICIONES_POR_DEFECTO 200
+#define BYTES_PIPE_P1_P3 4096
+
+static const char *RUTAS_HUESPEDES[] = {
+    "./code/escenariosBasicos/proceso1",
+    "./code/escenariosBasicos/proceso2",
+    "./code/escenariosBasicos/proceso3",
+    "./code/escenariosSyscall/proceso1",
+    "./code/escenariosSyscall/proceso2",
+    "./code/escenariosSyscall/proceso3"};
+
+/* El argumento con que los lanza el kernel (o su padre en la cadena de llamadas al sistema):
+   P2 recibe la decisión del Escudo y el P3 de la cadena la lectura que le pasa P1. */
+static const char *ARGUMENTOS_HUESPEDES[] = {NULL, "0", NULL, NULL, "0", "75"};
+
+static const long LINEAS_TRAZA[] = {1000, 100000, 1000000};
+
+static char directorio_temporal[] = "/tmp/bench_kernel_XXXXXX";
+
+double nanosegundos()
+{
+    return tiempo_monotonico() * 1e9;
+}
+
+void mostrar_resultado_bench(const char *nombre, const EstadisticaOnline *e)
+{
+    if (e->muestras == 0)
+    {
+        printf("| %-52s | %-7s | %-14s | %-14s | %-14s | %-14s |\n", nombre, "-", "-", "-", "-", "-");
+        return;
+    }
+    printf("| %-52s | %-7ld | %-14.0f | %-14.0f | %-14.0f | %-14.0f |\n", nombre, e->muestras,
+           percentil_estadistica(e, 0.50), percentil_estadistica(e, 0.90),
+           percentil_estadistica(e, 0.99), e->maximo);
+    fflush(stdout);
+}
+
+/* Lanza QEMU con stdin/stdout redirigidos. Todos los pipes del benchmark son O_CLOEXEC,
+   así que el huésped solo hereda sus extremos y el aviso de exec se cierra al completarse. */
+pid_t lanzar_huesped_bench(const char *ruta, const char *argumento, int fd_entrada, int fd_salida)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        int nulo = open("/dev/null", O_RDWR);
+        dup2(fd_entrada >= 0 ? fd_entrada : nulo, STDIN_FILENO);
+        dup2(fd_salida >= 0 ? fd_salida : nulo, STDOUT_FILENO);
+
+        char *argv[] = {"qemu-riscv32", (char *)ruta, (char *)argumento, NULL};
+        execvp("qemu-riscv32", argv);
+        _exit(127);
+    }
+    return pid;
+}
+
+void bench_fork_exec(int repeticiones)
+{
+    char nombre[96];
+
+    for (size_t h = 0; h < sizeof(RUTAS_HUESPEDES) / sizeof(RUTAS_HUESPEDES[0]); h++)
+    {
+        EstadisticaOnline exec_listo, hasta_salida;
+        iniciar_estadistica(&exec_listo, 1.0);
+        iniciar_estadistica(&hasta_salida, 1.0);
+
+        for (int r = 0; r < repeticiones; r++)
+        {
+            int aviso[2];
+            if (pipe2(aviso, O_CLOEXEC) == -1)
+                break;
+
+            double inicio = nanosegundos();
+            pid_t pid = lanzar_huesped_bench(RUTAS_HUESPEDES[h], ARGUMENTOS_HUESPEDES[h], -1, -1);
+            close(aviso[1]);
+
+            char c;
+            read(aviso[0], &c, 1);
+            double ejecutado = nanosegundos();
+            close(aviso[0]);
+
+            int status;
+            waitpid(pid, &status, 0);
+            double fin = nanosegundos();
+
+            if (!WIFEXITED(status) || WEXITSTATUS(status) == 127)
+                break;
+
+            registrar_estadistica(&exec_listo, ejecutado - inicio);
+            registrar_estadistica(&hasta_salida, fin - inicio);
+        }
+
+        snprintf(nombre, sizeof(nombre), "fork+exec %s", RUTAS_HUESPEDES[h] + 7);
+        mostrar_resultado_bench(nombre, &exec_listo);
+        snprintf(nombre, sizeof(nombre), "fork+exec+salida %s", RUTAS_HUESPEDES[h] + 7);
+        mostrar_resultado_bench(nombre, &hasta_salida);
+    }
+}
+
+/* La capa de lanzamiento del kernel: clone(CLONE_VM | CLONE_VFORK) vuelve con el exec
+   hecho; un huésped retenido se mide desde que se abre su compuerta hasta el exec. */
+void bench_lanzar_huesped(int repeticiones)
+{
+    EstadisticaOnline directo, retenido;
+    iniciar_estadistica(&directo, 1.0);
+    iniciar_estadistica(&retenido, 1.0);
+
+    int nulo = open("/dev/null", O_RDWR | O_CLOEXEC);
+    char *argv[] = {"qemu-riscv32", (char *)RUTAS_HUESPEDES[1], (char *)ARGUMENTOS_HUESPEDES[1], NULL};
+
+    for (int r = 0; r < repeticiones; r++)
+    {
+        ArranqueHuesped arranque = {.entrada = nulo, .salida = nulo, .nucleo = -1};
+        int status;
+
+        double inicio = nanosegundos();
+        pid_t pid = lanzar_huesped(argv, &arranque, NULL);
+        registrar_estadistica(&directo, nanosegundos() - inicio);
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            break;
+
+        arranque.retenido = 1;
+        pid = lanzar_huesped(argv, &arranque, NULL);
+        inicio = nanosegundos();
+        liberar_huesped(pid);
+        registrar_estadistica(&retenido, nanosegundos() - inicio);
+        waitpid(pid, NULL, 0);
+    }
+
+    close(nulo);
+    mostrar_resultado_bench("lanzar_huesped hasta exec (clone VM|VFORK)", &directo);
+    mostrar_resultado_bench("lanzar_huesped retenido: compuerta -> exec", &retenido);
+}
+
+/* SIGSTOP -> parada observada (WUNTRACED) -> SIGCONT -> reanudación observada (WCONTINUED).
+   P1 tiene la entrada abierta pero vacía: se mide sobre un huésped bloqueado en read. */
+void bench_stop_cont(int repeticiones)
+{
+    EstadisticaOnline ida_vuelta;
+    iniciar_estadistica(&ida_vuelta, 1.0);
+
+    int entrada[2];
+    if (pipe2(entrada, O_CLOEXEC) == -1)
+        return;
+
+    pid_t pid = lanzar_huesped_bench(RUTAS_HUESPEDES[0], NULL, entrada[0], -1);
+    close(entrada[0]);
+    usleep(200000);
+
+    for (int r = 0; r < repeticiones; r++)
+    {
+        int status;
+        double inicio = nanosegundos();
+        kill(pid, SIGSTOP);
+        if (waitpid(pid, &status, WUNTRACED) != pid || !WIFSTOPPED(status))
+            break;
+        kill(pid, SIGCONT);
+        if (waitpid(pid, &status, WCONTINUED) != pid || !WIFCONTINUED(status))
+            break;
+        registrar_estadistica(&ida_vuelta, nanosegundos() - inicio);
+    }
+
+    close(entrada[1]);
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    mostrar_resultado_bench("SIGSTOP+SIGCONT ida y vuelta (P1 bloqueado en read)", &ida_vuelta);
+}
+
+/* Bytes que recorren P1 -> P3 hasta volver al kernel, en ns por byte. */
+void bench_pipe_p1_p3(int repeticiones)
+{
+    EstadisticaOnline por_byte;
+    iniciar_estadistica(&por_byte, 1000.0);
+
+    char datos[BYTES_PIPE_P1_P3];
+    for (int i = 0; i < BYTES_PIPE_P1_P3; i++)
+        datos[i] = (i % 4 == 3) ? '\n' : '0' + i % 10;
+
+    int veces = repeticiones < 20 ? repeticiones : 20;
+    for (int r = 0; r < veces; r++)
+    {
+        int entrada[2], intermedio[2], salida[2];
+        if (pipe2(entrada, O_CLOEXEC) == -1 || pipe2(intermedio, O_CLOEXEC) == -1 || pipe2(salida, O_CLOEXEC) == -1)
+            return;
+
+        double inicio = nanosegundos();
+        pid_t p1 = lanzar_huesped_bench(RUTAS_HUESPEDES[0], NULL, entrada[0], intermedio[1]);
+        pid_t p3 = lanzar_huesped_bench(RUTAS_HUESPEDES[2], NULL, intermedio[0], salida[1]);
+        close(entrada[0]);
+        close(intermedio[0]);
+        close(intermedio[1]);
+        close(salida[1]);
+
+        write(entrada[1], datos, sizeof(datos));
+        close(entrada[1]);
+
+        char buffer[4096];
+        long recibidos = 0;
+        ssize_t n;
+        while ((n = read(salida[0], buffer, sizeof(buffer))) > 0)
+            recibidos += n;
+        double fin = nanosegundos();
+        close(salida[0]);
+
+        waitpid(p1, NULL, 0);
+        waitpid(p3, NULL, 0);
+        if (recibidos > 0)
+            registrar_estadistica(&por_byte, (fin - inicio) / recibidos);
+    }
+
+    mostrar_resultado_bench("tubería P1 -> P3 (ns/byte, incluye arranque)", &por_byte);
+}
+
+void bench_obtener_pc(int repeticiones)
+{
+    char ruta[128], nombre[96];
+
+    for (size_t t = 0; t < sizeof(LINEAS_TRAZA) / sizeof(LINEAS_TRAZA[0]); t++)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/traza_%ld.log", directorio_temporal, LINEAS_TRAZA[t]);
+        FILE *fp = fopen(ruta, "w");
+        if (!fp)
+            return;
+        for (long l = 0; l < LINEAS_TRAZA[t]; l++)
+        {
+            if (l % 9 == 0)
+                fprintf(fp, " pc       %08lx\n", 0x10000 + l * 4);
+            else
+                fprintf(fp, " x%-7ld %08lx x%-7ld %08lx\n", l % 32, l, (l + 1) % 32, l + 1);
+        }
+        fclose(fp);
+
+        EstadisticaOnline coste;
+        iniciar_estadistica(&coste, 1.0);
+        for (int r = 0; r < repeticiones; r++)
+        {
+            double inicio = nanosegundos();
+            obtener_pc_riscv(ruta);
+            registrar_estadistica(&coste, nanosegundos() - inicio);
+        }
+
+        snprintf(nombre, sizeof(nombre), "obtener_pc_riscv (%ld líneas)", LINEAS_TRAZA[t]);
+        mostrar_resultado_bench(nombre, &coste);
+        unlink(ruta);
+    }
+}
+
+void bench_alimentador(int repeticiones)
+{
+    EstadisticaOnline por_byte;
+    iniciar_estadistica(&por_byte, 1000.0);
+
+    struct stat info;
+    if (stat("medidas.txt", &info) == -1 || info.st_size == 0)
+    {
+        mostrar_resultado_bench("enviar_contenido_archivo_a_pipe (sin medidas.txt)", &por_byte);
+        return;
+    }
+
+    for (int r = 0; r < repeticiones; r++)
+    {
+        int tubo[2];
+        if (pipe(tubo) == -1)
+            return;
+
+        pid_t lector = fork();
+        if (lector == 0)
+        {
+            char buffer[4096];
+            close(tubo[1]);
+            while (read(tubo[0], buffer, sizeof(buffer)) > 0)
+                ;
+            _exit(0);
+        }
+        close(tubo[0]);
+
+        iniciar_traza_lecturas();
+        double inicio = nanosegundos();
+        enviar_contenido_archivo_a_pipe(tubo[1], "medidas.txt");
+        registrar_estadistica(&por_byte, (nanosegundos() - inicio) / info.st_size);
+
+        waitpid(lector, NULL, 0);
+    }
+
+    mostrar_resultado_bench("enviar_contenido_archivo_a_pipe (ns/byte)", &por_byte);
+}
+
+/* Exporta un bloque de CICLOS_POR_REPORTE ciclos sintéticos; el coste se reparte por ciclo. */
+void bench_exportar_json(int repeticiones)
+{
+    EstadisticaOnline por_ciclo;
+    iniciar_estadistica(&por_ciclo, 1.0);
+
+    char original[4096];
+    if (!getcwd(original, sizeof(original)) || chdir(directorio_temporal) == -1)
+        return;
+
+    /* Los mensajes de las funciones de exportación no forman parte de la medida. */
+    fflush(stdout);
+    int salida_original = dup(STDOUT_FILENO);
+    int nulo = open("/dev/null", O_WRONLY);
+    dup2(nulo, STDOUT_FILENO);
+    close(nulo);
+
+    escenario_actual = 2;
+    for (int r = 0; r < repeticiones; r++)
+    {
+        unlink("metricas_mision_2.json");
+        unlink("metricas_total_2.json");
+
+        for (int c = 0; c < CICLOS_POR_REPORTE; c++)
+        {
+            CicloResultado *res = &resultados_ciclos[c];
+            memset(res, 0, sizeof(CicloResultado));
+            res->ciclo = c + 1;
+            res->escenario = escenario_actual;
+            res->tiempo_total_ciclo = 40.0 + c;
+            res->p1_stats.time_real = res->p3_stats.time_real = 30.0;
+            res->p2_stats.time_real = 0.02;
+        }
+        indice_resultados = CICLOS_POR_REPORTE;
+
+        double inicio = nanosegundos();
+        exportar_resultados_a_json();
+        exportar_reporte_acumulado_a_json();
+        registrar_estadistica(&por_ciclo, (nanosegundos() - inicio) / CICLOS_POR_REPORTE);
+    }
+    indice_resultados = 0;
+
+    fflush(stdout);
+    dup2(salida_original, STDOUT_FILENO);
+    close(salida_original);
+
+    unlink("metricas_mision_2.json");
+    unlink("metricas_total_2.json");
+    if (chdir(original) == -1)
+        perror("chdir");
+
+    mostrar_resultado_bench("exportación JSON (por ciclo)", &por_ciclo);
+}
+
+/* Escalado del abanico de sensores (-f): el mismo ciclo que el escenario 2 con 1, 2, 4...
+   tuberías sobre medidas.txt hasta max_sensores, con la regla por defecto. */
+void bench_abanico_sensores(int max_sensores)
+{
+    static ResultadoAbanico resultado;
+
+    printf("\n--- Escalado del abanico de sensores (una ejecución por tamaño) ---\n");
+    printf("| %-8s | %-10s | %-11s | %-12s | %-12s | %-12s | %-12s | %-11s | %-12s |\n", "Sensores", "Ciclo (s)",
+           "Lanzam. (s)", "Registros/s", "Lat. p50 ms", "Lat. p99 ms", "Escudo p99", "Actuaciones", "CPU kern. µs");
+    printf("|----------|------------|-------------|--------------|--------------|--------------|--------------|-------------|--------------|\n");
+    fflush(stdout);
+
+    for (int n = 1; n <= max_sensores; n *= 2)
+    {
+        /* Los mensajes del kernel y del Escudo no forman parte de la tabla. */
+        int salida_original = dup(STDOUT_FILENO);
+        int nulo = open("/dev/null", O_WRONLY);
+        dup2(nulo, STDOUT_FILENO);
+        close(nulo);
+
+        num_sensores = n;
+        ejecutar_abanico_sensores(&resultado);
+
+        fflush(stdout);
+        dup2(salida_original, STDOUT_FILENO);
+        close(salida_original);
+
+        printf("| %-8d | %-10.3f | %-11.3f | %-12.1f | %-12.3f | %-12.3f | %-12.3f | %-11d | %-12.1f |\n",
+               n, resultado.tiempo, resultado.lanzamiento,
+               resultado.tiempo > 0.0 ? resultado.registros / resultado.tiempo : 0.0,
+               percentil_estadistica(&resultado.latencia_sensor, 0.50) * 1000.0,
+               percentil_estadistica(&resultado.latencia_sensor, 0.99) * 1000.0,
+               percentil_estadistica(&resultado.latencia_decision, 0.99) * 1000.0, resultado.actuaciones,
+               resultado.registros > 0 ? resultado.cpu_kernel / resultado.registros * 1e6 : 0.0);
+        fflush(stdout);
+        liberar_abanico(&resultado);
+    }
+    num_sensores = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int repeticiones = (argc > 1) ? atoi(argv[1]) : REPETICIONES_POR_DEFECTO;
+    if (repeticiones <= 0)
+        repeticiones = REPETICIONES_POR_DEFECTO;
+    int max_sensores = (argc > 2) ? atoi(argv[2]) : MAX_SENSORES;
+    if (max_sensores <= 0 || max_sensores > MAX_SENSORES)
+        max_sensores = MAX_SENSORES;
+
+    if (!mkdtemp(directorio_temporal))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    inicializar_estadisticas();
+
+    printf(COLOR_TABLE "\n--- Microbenchmarks del orquestador (%d repeticiones, ns/op) ---\n", repeticiones);
+    printf("| %-52s | %-7s | %-14s | %-14s | %-14s | %-14s |\n", "Primitiva", "Ops", "p50", "p90", "p99", "Máx");
+    printf("|------------------------------------------------------|---------|----------------|----------------|----------------|----------------|\n");
+
+    bench_fork_exec(repeticiones);
+    bench_lanzar_huesped(repeticiones);
+    bench_stop_cont(repeticiones);
+    bench_pipe_p1_p3(repeticiones);
+    bench_obtener_pc(repeticiones);
+    bench_alimentador(repeticiones);
+    bench_exportar_json(repeticiones);
+    bench_abanico_sensores(max_sensores);
+
+    printf(ANSI_RESET);
+    rmdir(directorio_temporal);
+    return 0;
+}
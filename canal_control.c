@@ -0,0 +1,276 @@
+#include "kernel.h"
+#include "canal_control.h"
+
+/* Los quantums entran en la siguiente frontera de quantum; política, escenario e intervalo,
+   al terminar el ciclo en curso. */
+
+#define MAX_CLIENTES_CONTROL 4
+
+typedef struct
+{
+    int fd;
+    char linea[256];
+    size_t largo;
+} ClienteControl;
+
+const char *NOMBRES_POLITICAS[] = {"rr", "edf", "gang", "datos"};
+static const char *NOMBRES_NIVELES_LOG[] = {"resumen", "normal", "detalle"};
+
+int fd_control = -1;
+static const char *ruta_control = NULL;
+static ClienteControl clientes_control[MAX_CLIENTES_CONTROL];
+CambiosControl cambios_control = {.politica = -1};
+
+void iniciar_canal_control(const char *ruta)
+{
+    struct sockaddr_un direccion = {0};
+
+    if (strlen(ruta) >= sizeof(direccion.sun_path))
+    {
+        fprintf(stderr, COLOR_ERROR "[Centro de Control] ERROR: ruta del canal de control demasiado larga: %s\n" ANSI_RESET, ruta);
+        exit(1);
+    }
+
+    fd_control = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_control == -1)
+    {
+        perror("socket");
+        exit(1);
+    }
+
+    direccion.sun_family = AF_UNIX;
+    snprintf(direccion.sun_path, sizeof(direccion.sun_path), "%s", ruta);
+    unlink(ruta);
+    if (bind(fd_control, (struct sockaddr *)&direccion, sizeof(direccion)) == -1 || listen(fd_control, MAX_CLIENTES_CONTROL) == -1)
+    {
+        perror("bind/listen (canal de control)");
+        exit(1);
+    }
+
+    for (int i = 0; i < MAX_CLIENTES_CONTROL; i++)
+        clientes_control[i].fd = -1;
+    ruta_control = ruta;
+
+    printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Canal de control en %s\n", ruta);
+}
+
+void responder_control(ClienteControl *cliente, const char *formato, ...)
+{
+    char respuesta[512];
+    va_list args;
+
+    va_start(args, formato);
+    int n = vsnprintf(respuesta, sizeof(respuesta) - 1, formato, args);
+    va_end(args);
+    if (n < 0)
+        return;
+    if (n > (int)sizeof(respuesta) - 2)
+        n = sizeof(respuesta) - 2;
+    respuesta[n++] = '\n';
+    send(cliente->fd, respuesta, n, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+int nodo_control_valido(const char *nombre)
+{
+    if (strcmp(nombre, "p1") == 0 || strcmp(nombre, "p3") == 0)
+        return 1;
+    for (int e = 1; e <= 4; e++)
+        for (int i = 0; topologias[e] && i < topologias[e]->num_nodos; i++)
+            if (strcmp(topologias[e]->nodos[i].nombre, nombre) == 0)
+                return 1;
+    return 0;
+}
+
+void ejecutar_comando_control(ClienteControl *cliente, char *linea)
+{
+    char comando[32] = "", argumento[16] = "", valor[32] = "";
+    int campos = sscanf(linea, "%31s %15s %31s", comando, argumento, valor);
+    char *fin;
+
+    if (campos <= 0)
+        return;
+
+    if (strcmp(comando, "quantum") == 0 && campos == 3)
+    {
+        double q = strtod(valor, &fin);
+        if (*fin != '\0' || q <= 0.0 || !nodo_control_valido(argumento))
+        {
+            responder_control(cliente, "ERROR quantum NODO SEGUNDOS (NODO: p1, p3 o un nodo de una topología cargada)");
+            return;
+        }
+
+        int i = 0;
+        while (i < cambios_control.num_quantums && strcmp(cambios_control.nodos[i], argumento) != 0)
+            i++;
+        if (i == MAX_NODOS_TOPOLOGIA + 2)
+        {
+            responder_control(cliente, "ERROR demasiados quantums pendientes");
+            return;
+        }
+        snprintf(cambios_control.nodos[i], sizeof(cambios_control.nodos[i]), "%s", argumento);
+        cambios_control.quantums[i] = q;
+        if (i == cambios_control.num_quantums)
+            cambios_control.num_quantums++;
+        responder_control(cliente, "OK quantum de %s = %.3f s desde el próximo turno", argumento, q);
+    }
+    else if (strcmp(comando, "politica") == 0 && campos == 2)
+    {
+        int p = -1;
+        for (int i = 0; i < 4; i++)
+            if (strcmp(argumento, NOMBRES_POLITICAS[i]) == 0)
+                p = i;
+        if (p < 0)
+        {
+            responder_control(cliente, "ERROR politica rr|edf|gang|datos");
+            return;
+        }
+        cambios_control.politica = p;
+        responder_control(cliente, "OK política %s al terminar el ciclo en curso", argumento);
+    }
+    else if (strcmp(comando, "escenario") == 0 && campos == 2)
+    {
+        int e = (int)strtol(argumento, &fin, 10);
+        if (*fin != '\0' || e < 1 || e > 4)
+        {
+            responder_control(cliente, "ERROR escenario 1-4");
+            return;
+        }
+        cambios_control.escenario = e;
+        responder_control(cliente, "OK escenario %d al terminar el ciclo en curso", e);
+    }
+    else if (strcmp(comando, "intervalo") == 0 && campos == 2)
+    {
+        double s = strtod(argumento, &fin);
+        if (*fin != '\0' || s < 0.0)
+        {
+            responder_control(cliente, "ERROR intervalo SEGUNDOS");
+            return;
+        }
+        cambios_control.intervalo_ciclo = s;
+        cambios_control.hay_intervalo = 1;
+        responder_control(cliente, "OK intervalo entre ciclos %.3f s desde el próximo ciclo", s);
+    }
+    else if (strcmp(comando, "log") == 0 && campos == 2)
+    {
+        int n = -1;
+        for (int i = 0; i < 3; i++)
+            if (strcmp(argumento, NOMBRES_NIVELES_LOG[i]) == 0)
+                n = i;
+        if (n < 0)
+        {
+            responder_control(cliente, "ERROR log resumen|normal|detalle");
+            return;
+        }
+        nivel_log = n;
+        responder_control(cliente, "OK log %s", argumento);
+    }
+    else if (strcmp(comando, "estado") == 0 && campos == 1)
+    {
+        responder_control(cliente, "OK escenario=%d ciclo=%d politica=%s quantum_p1=%.3f quantum_p3=%.3f intervalo=%.3f log=%s pendientes=%s",
+                          escenario_actual, ciclo_actual, NOMBRES_POLITICAS[politica_actual], quantum_p1_rr, quantum_p3_rr,
+                          intervalo_ciclo, NOMBRES_NIVELES_LOG[nivel_log],
+                          (cambios_control.num_quantums || cambios_control.escenario || cambios_control.politica >= 0 ||
+                           cambios_control.hay_intervalo) ? "si" : "no");
+    }
+    else
+    {
+        responder_control(cliente, "ERROR comando desconocido: %s", comando);
+    }
+}
+
+void cerrar_cliente_control(ClienteControl *cliente)
+{
+    close(cliente->fd);
+    memset(cliente, 0, sizeof(ClienteControl));
+    cliente->fd = -1;
+}
+
+void atender_control()
+{
+    if (fd_control == -1)
+        return;
+
+    int nuevo;
+    while ((nuevo = accept4(fd_control, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        int libre = -1;
+        for (int i = 0; i < MAX_CLIENTES_CONTROL && libre == -1; i++)
+            if (clientes_control[i].fd == -1)
+                libre = i;
+
+        if (libre == -1)
+        {
+            close(nuevo);
+            continue;
+        }
+        clientes_control[libre].fd = nuevo;
+    }
+
+    for (int i = 0; i < MAX_CLIENTES_CONTROL; i++)
+    {
+        ClienteControl *cliente = &clientes_control[i];
+        if (cliente->fd == -1)
+            continue;
+
+        ssize_t n = recv(cliente->fd, cliente->linea + cliente->largo, sizeof(cliente->linea) - 1 - cliente->largo, 0);
+        if (n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            cerrar_cliente_control(cliente);
+            continue;
+        }
+        if (n < 0)
+            continue;
+
+        cliente->largo += n;
+        cliente->linea[cliente->largo] = '\0';
+
+        char *salto;
+        while ((salto = strchr(cliente->linea, '\n')) != NULL)
+        {
+            *salto = '\0';
+            ejecutar_comando_control(cliente, cliente->linea);
+            cliente->largo -= salto + 1 - cliente->linea;
+            memmove(cliente->linea, salto + 1, cliente->largo + 1);
+        }
+        if (cliente->largo == sizeof(cliente->linea) - 1)
+        {
+            responder_control(cliente, "ERROR línea demasiado larga");
+            cerrar_cliente_control(cliente);
+        }
+    }
+}
+
+void atender_canales()
+{
+    FASE_KERNEL(FASE_CANALES);
+    atender_metricas();
+    atender_control();
+}
+
+void aplicar_quantums_control()
+{
+    Topologia *t = escenario_actual >= 1 && escenario_actual <= 4 ? topologias[escenario_actual] : NULL;
+
+    for (int i = 0; i < cambios_control.num_quantums; i++)
+    {
+        const char *nombre = cambios_control.nodos[i];
+        double q = cambios_control.quantums[i];
+
+        if (strcmp(nombre, "p1") == 0)
+            quantum_p1_rr = q;
+        else if (strcmp(nombre, "p3") == 0)
+            quantum_p3_rr = q;
+        for (int n = 0; t && n < t->num_nodos; n++)
+            if (strcmp(t->nodos[n].nombre, nombre) == 0)
+                t->nodos[n].quantum = q;
+
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Canal de control: quantum de %s = %.3f s.\n", nombre, q);
+    }
+    cambios_control.num_quantums = 0;
+}
+
+double quantum_turno_rr(int slot)
+{
+    aplicar_quantums_control();
+    return slot == 0 ? quantum_p1_rr : quantum_p3_rr;
+}
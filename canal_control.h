@@ -0,0 +1,26 @@
+#ifndef CANAL_CONTROL_H
+#define CANAL_CONTROL_H
+
+#include "topologia.h"
+
+typedef struct
+{
+    char nodos[MAX_NODOS_TOPOLOGIA + 2][16];
+    double quantums[MAX_NODOS_TOPOLOGIA + 2];
+    int num_quantums;
+    int escenario;
+    int politica;
+    int hay_intervalo;
+    double intervalo_ciclo;
+} CambiosControl;
+
+extern const char *NOMBRES_POLITICAS[];
+extern int fd_control;
+extern CambiosControl cambios_control;
+
+void iniciar_canal_control(const char *ruta);
+void atender_canales();
+void aplicar_quantums_control();
+double quantum_turno_rr(int slot);
+
+#endif
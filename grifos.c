@@ -0,0 +1,316 @@
+#include "kernel.h"
+#include "grifos.h"
+
+/* Al capturar, tee(2) duplica cada trozo hacia el consumidor y splice(2) lo mueve al
+   archivo sin pasar por memoria de usuario. El reloj de la grabación arranca con el
+   primer byte del productor. */
+
+#define MAX_GRIFOS 16
+#define TAM_TROZO_GRIFO 65536
+#define TIMEOUT_GRIFO 1.0
+#define MAGIA_CAPTURA_GRIFO "KGRIFO1\n"
+
+typedef struct
+{
+    double instante;
+    uint64_t bytes;
+} CabeceraTrozoGrifo;
+
+typedef struct
+{
+    int en_uso;
+    int terminado;
+    int reproduciendo;
+    int ciclo;
+    const char *nombre;
+    char ruta[256];
+    pthread_t hilo;
+
+    int fd_origen;
+    int fd_destino;
+    int fd_archivo;
+    int fd_nulo;
+
+    long trozos;
+    long long bytes;
+    long long bytes_descartados;
+    double retraso_maximo;
+} Grifo;
+
+const char *prefijo_captura = NULL;
+const char *prefijo_reproduccion = NULL;
+double velocidad_reproduccion = 1.0;
+static Grifo grifos[MAX_GRIFOS];
+static pthread_mutex_t cerrojo_grifos = PTHREAD_MUTEX_INITIALIZER;
+
+int mover_con_splice(int fd_entrada, loff_t *desplazamiento, int fd_salida, size_t bytes)
+{
+    while (bytes > 0)
+    {
+        ssize_t n = splice(fd_entrada, desplazamiento, fd_salida, NULL, bytes, SPLICE_F_MOVE);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+        bytes -= n;
+    }
+    return 0;
+}
+
+void *capturar_grifo(void *arg)
+{
+    Grifo *g = arg;
+
+    while (1)
+    {
+        ssize_t n;
+        if (g->fd_destino >= 0)
+        {
+            n = tee(g->fd_origen, g->fd_destino, TAM_TROZO_GRIFO, 0);
+            if (n == -1 && errno == EINTR)
+                continue;
+            if (n == -1 && errno == EPIPE)
+            {
+                /* El consumidor ya no lee: se sigue capturando lo que escriba el productor. */
+                close(g->fd_destino);
+                g->fd_destino = -1;
+                continue;
+            }
+        }
+        else
+        {
+            struct pollfd pfd = {.fd = g->fd_origen, .events = POLLIN};
+            if (poll(&pfd, 1, -1) == -1 && errno == EINTR)
+                continue;
+            n = bytes_pendientes(g->fd_origen);
+        }
+        if (n <= 0)
+            break;
+
+        CabeceraTrozoGrifo cabecera = {.instante = tiempo_monotonico(), .bytes = n};
+        if (write(g->fd_archivo, &cabecera, sizeof(cabecera)) != sizeof(cabecera) ||
+            mover_con_splice(g->fd_origen, NULL, g->fd_archivo, n) == -1)
+            break;
+        g->trozos++;
+        g->bytes += n;
+    }
+
+    if (g->fd_destino >= 0)
+        close(g->fd_destino);
+    close(g->fd_origen);
+    close(g->fd_archivo);
+    __atomic_store_n(&g->terminado, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int leer_cabecera_grifo(Grifo *g, loff_t desplazamiento, CabeceraTrozoGrifo *cabecera)
+{
+    return pread(g->fd_archivo, cabecera, sizeof(*cabecera), desplazamiento) == sizeof(*cabecera);
+}
+
+void *reproducir_grifo(void *arg)
+{
+    Grifo *g = arg;
+    CabeceraTrozoGrifo cabecera;
+    loff_t desplazamiento = strlen(MAGIA_CAPTURA_GRIFO);
+    int quedan_trozos = leer_cabecera_grifo(g, desplazamiento, &cabecera);
+    double inicio_grabacion = quedan_trozos ? cabecera.instante : 0.0;
+    double ancla = -1.0;
+
+    while (g->fd_origen >= 0 || quedan_trozos)
+    {
+        double ahora = tiempo_monotonico();
+        double vencimiento = ancla;
+        if (quedan_trozos && ancla >= 0.0 && velocidad_reproduccion > 0.0)
+            vencimiento = ancla + (cabecera.instante - inicio_grabacion) / velocidad_reproduccion;
+
+        int espera = -1;
+        if (quedan_trozos && ancla >= 0.0)
+            espera = vencimiento > ahora ? (int)((vencimiento - ahora) * 1000.0) + 1 : 0;
+
+        if (g->fd_origen >= 0)
+        {
+            struct pollfd pfd = {.fd = g->fd_origen, .events = POLLIN};
+            if (poll(&pfd, 1, espera) > 0)
+            {
+                ssize_t n = splice(g->fd_origen, NULL, g->fd_nulo, NULL, TAM_TROZO_GRIFO, SPLICE_F_MOVE);
+                if (n > 0)
+                    g->bytes_descartados += n;
+                else if (n == 0 || errno != EINTR)
+                {
+                    close(g->fd_origen);
+                    g->fd_origen = -1;
+                }
+                if (ancla < 0.0)
+                    ancla = tiempo_monotonico();
+            }
+        }
+        else if (ancla < 0.0)
+            ancla = tiempo_monotonico();
+        else if (espera > 0)
+            poll(NULL, 0, espera);
+
+        while (quedan_trozos && ancla >= 0.0)
+        {
+            ahora = tiempo_monotonico();
+            vencimiento = ancla;
+            if (velocidad_reproduccion > 0.0)
+                vencimiento += (cabecera.instante - inicio_grabacion) / velocidad_reproduccion;
+            if (ahora < vencimiento)
+                break;
+
+            desplazamiento += sizeof(cabecera);
+            if (mover_con_splice(g->fd_archivo, &desplazamiento, g->fd_destino, cabecera.bytes) == -1)
+            {
+                quedan_trozos = 0;
+                break;
+            }
+            if (ahora - vencimiento > g->retraso_maximo)
+                g->retraso_maximo = ahora - vencimiento;
+            g->trozos++;
+            g->bytes += cabecera.bytes;
+            quedan_trozos = leer_cabecera_grifo(g, desplazamiento, &cabecera);
+        }
+
+        /* Grabación agotada: el consumidor ve EOF aunque el productor siga escribiendo. */
+        if (!quedan_trozos && g->fd_destino >= 0)
+        {
+            close(g->fd_destino);
+            g->fd_destino = -1;
+        }
+    }
+
+    close(g->fd_archivo);
+    close(g->fd_nulo);
+    __atomic_store_n(&g->terminado, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+int abrir_archivo_grifo(Grifo *g)
+{
+    char magia[sizeof(MAGIA_CAPTURA_GRIFO)] = {0};
+    size_t largo = strlen(MAGIA_CAPTURA_GRIFO);
+
+    if (!g->reproduciendo)
+    {
+        g->fd_archivo = open(g->ruta, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        return g->fd_archivo != -1 && write(g->fd_archivo, MAGIA_CAPTURA_GRIFO, largo) == (ssize_t)largo;
+    }
+
+    g->fd_archivo = open(g->ruta, O_RDONLY | O_CLOEXEC);
+    g->fd_nulo = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    return g->fd_archivo != -1 && g->fd_nulo != -1 && read(g->fd_archivo, magia, largo) == (ssize_t)largo &&
+           memcmp(magia, MAGIA_CAPTURA_GRIFO, largo) == 0;
+}
+
+const char *texto_velocidad_reproduccion()
+{
+    static char texto[32];
+    if (velocidad_reproduccion > 0.0)
+        snprintf(texto, sizeof(texto), "a velocidad %.2fx", velocidad_reproduccion);
+    else
+        snprintf(texto, sizeof(texto), "sin pausas");
+    return texto;
+}
+
+/* Si no se puede interponer, la tubería queda directa. */
+void interponer_grifo(int tuberia[2], const char *nombre)
+{
+    if (!prefijo_captura && !prefijo_reproduccion)
+        return;
+
+    pthread_mutex_lock(&cerrojo_grifos);
+    Grifo *g = NULL;
+    for (int i = 0; i < MAX_GRIFOS && !g; i++)
+        if (!grifos[i].en_uso)
+            g = &grifos[i];
+    if (g)
+    {
+        memset(g, 0, sizeof(Grifo));
+        g->en_uso = 1;
+    }
+    pthread_mutex_unlock(&cerrojo_grifos);
+    if (!g)
+    {
+        printf(COLOR_ERROR "[Control Central] AVISO: " ANSI_RESET "Sin grifos libres; la tubería %s queda directa.\n", nombre);
+        return;
+    }
+
+    g->nombre = nombre;
+    g->ciclo = ciclo_actual;
+    g->reproduciendo = prefijo_reproduccion != NULL;
+    g->fd_archivo = g->fd_nulo = -1;
+    if (g->reproduciendo)
+        snprintf(g->ruta, sizeof(g->ruta), "%s_%s.cap", prefijo_reproduccion, nombre);
+    else
+        snprintf(g->ruta, sizeof(g->ruta), "%s_%d_%s.cap", prefijo_captura, ciclo_actual, nombre);
+
+    int nueva[2];
+    errno = 0;
+    if (!abrir_archivo_grifo(g) || pipe2(nueva, O_CLOEXEC) == -1)
+    {
+        printf(COLOR_ERROR "[Control Central] AVISO: " ANSI_RESET "No se pudo usar '%s' (%s); la tubería %s queda directa.\n",
+               g->ruta, strerror(errno ? errno : EINVAL), nombre);
+        if (g->fd_archivo != -1)
+            close(g->fd_archivo);
+        if (g->fd_nulo != -1)
+            close(g->fd_nulo);
+        __atomic_store_n(&g->en_uso, 0, __ATOMIC_RELEASE);
+        return;
+    }
+    g->fd_origen = tuberia[0];
+    g->fd_destino = nueva[1];
+    tuberia[0] = nueva[0];
+
+    /* Las señales del kernel (SIGCHLD, SIGTSTP...) no deben interrumpir al grifo, y un
+       SIGPIPE del consumidor se ve como EPIPE. */
+    sigset_t todas, anterior;
+    sigfillset(&todas);
+    pthread_sigmask(SIG_BLOCK, &todas, &anterior);
+    if (pthread_create(&g->hilo, NULL, g->reproduciendo ? reproducir_grifo : capturar_grifo, g) != 0)
+    {
+        perror("pthread_create");
+        exit(1);
+    }
+    pthread_sigmask(SIG_SETMASK, &anterior, NULL);
+    pthread_detach(g->hilo);
+}
+
+void interponer_grifos(int p1_a_p3[2], int p3_a_kernel[2])
+{
+    interponer_grifo(p1_a_p3, "p1_p3");
+    interponer_grifo(p3_a_kernel, "p3_kernel");
+}
+
+/* La captura de una pareja descartada no corresponde a ningún ciclo y se borra. */
+void informar_grifos(int descartados)
+{
+    for (int i = 0; i < MAX_GRIFOS; i++)
+    {
+        Grifo *g = &grifos[i];
+        if (!__atomic_load_n(&g->en_uso, __ATOMIC_ACQUIRE))
+            continue;
+
+        double limite = tiempo_monotonico() + TIMEOUT_GRIFO;
+        while (!__atomic_load_n(&g->terminado, __ATOMIC_ACQUIRE) && tiempo_monotonico() < limite)
+            usleep(1000);
+        if (!__atomic_load_n(&g->terminado, __ATOMIC_ACQUIRE))
+            continue;
+
+        if (descartados)
+        {
+            if (!g->reproduciendo)
+                unlink(g->ruta);
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Grifo %s prelanzado para el ciclo #%d descartado%s.\n",
+                   g->nombre, g->ciclo, g->reproduciendo ? "" : " junto con su captura");
+        }
+        else if (g->reproduciendo)
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Grifo %s (ciclo #%d): %ld trozos, %lld B reproducidos de '%s' %s (retraso máx. %.3f ms); %lld B del productor descartados.\n",
+                   g->nombre, g->ciclo, g->trozos, g->bytes, g->ruta, texto_velocidad_reproduccion(),
+                   g->retraso_maximo * 1000.0, g->bytes_descartados);
+        else
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Grifo %s (ciclo #%d): %ld trozos, %lld B capturados en '%s'.\n",
+                   g->nombre, g->ciclo, g->trozos, g->bytes, g->ruta);
+        __atomic_store_n(&g->en_uso, 0, __ATOMIC_RELEASE);
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef GRIFOS_H
+#define GRIFOS_H
+
+extern const char *prefijo_captura;
+extern const char *prefijo_reproduccion;
+extern double velocidad_reproduccion;
+
+const char *texto_velocidad_reproduccion();
+void interponer_grifos(int p1_a_p3[2], int p3_a_kernel[2]);
+void informar_grifos(int descartados);
+
+#endif
@@ -1,56 +1,53 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <unistd.h>
-#include <sys/wait.h>
-#include <sys/time.h>
-#include <sys/resource.h>
-#include <signal.h>
-#include <string.h>
-#include <fcntl.h>
-#include <ctype.h>
-#include <time.h>
-
-#define ANSI_RESET "\x1B[0m"
-#define ANSI_RED "\x1B[31m"
-#define ANSI_GREEN "\x1B[32m"
-#define ANSI_YELLOW "\x1B[33m"
-#define ANSI_BLUE "\x1B[34m"
-#define ANSI_MAGENTA "\x1B[35m"
-#define ANSI_CYAN "\x1B[36m"
-#define ANSI_WHITE "\x1B[37m"
-#define ANSI_BR_RED "\x1B[91m"
-#define ANSI_BR_GREEN "\x1B[92m"
-#define ANSI_BR_YELLOW "\x1B[93m"
-#define ANSI_BR_CYAN "\x1B[96m"
-
-#define COLOR_KERNEL ANSI_CYAN
-#define COLOR_YELLOW ANSI_YELLOW
-#define COLOR_P1 ANSI_BR_GREEN
-#define COLOR_P2 ANSI_YELLOW
-#define COLOR_P3 ANSI_BLUE
-#define COLOR_ERROR ANSI_BR_RED
-#define COLOR_TABLE ANSI_WHITE
-#define COLOR_CICLO ANSI_BR_YELLOW
-#define COLOR_ACUMULADO ANSI_MAGENTA
+#include "kernel.h"
+#include "backend_es.h"
+#include "canal_control.h"
+#include "perfilador.h"
+#include "grifos.h"
+#include "topologia.h"
+#include "simulador.h"
+
+typedef enum
+{
+    TRAMO_KERNEL = 0,
+    TRAMO_ALIMENTADOR,
+    TRAMO_LANZAMIENTO,
+    TRAMO_SENIALES,
+    TRAMO_TUBERIA,
+    TRAMO_TRAZAS,
+    TRAMO_CONSOLA,
+    TRAMO_JSON,
+    NUM_TRAMOS_KERNEL
+} TramoKernel;
+
+#define NUM_NODOS_RUTA (NUM_TRAMOS_KERNEL + 8)
 
 typedef struct
 {
+    double tiempo_real;
+    double cpu_usuario;
+    double cpu_sistema;
+    long fallos_menores;
+    long fallos_mayores;
+    long cambios_voluntarios;
+    long cambios_involuntarios;
+    double tiempo_fases;
+    long activaciones;
+    double sobrecoste_temporizadores;
+    ContadorFase fases[NUM_FASES];
+} CosteOrquestador;
 
-    double time_real;
-    long ru_utime_sec, ru_utime_usec;
-    long ru_stime_sec, ru_stime_usec;
-    long ru_maxrss;
-    int exit_status;
-
-    int num_pausas;
-    double tiempo_pausado_total;
-    double tiempo_ejecucion_efectiva;
-    double quantum_dado_total;
-    double quantum_usado_total;
-    int cambios_contexto_voluntario;
-    int cambios_contexto_involuntario;
-    int seniales_recibidas[64];
-} ProcesoStats;
+typedef struct
+{
+    int lecturas;
+    int actuadas;
+    int criticas;
+    double extremo_medio;
+    double extremo_max;
+    double critica_max;
+    int registros_p3;
+    int registros_perdidos;
+    int registros_fuera_de_orden;
+} ResumenLatencia;
 
 typedef struct
 {
@@ -59,9 +56,14 @@ typedef struct
     double tiempo_total_ciclo;
     double speedup;
     double tiempo_muerto_kernel;
+    double throughput;
+    double indice_jain;
     ProcesoStats p1_stats;
     ProcesoStats p2_stats;
     ProcesoStats p3_stats;
+    ResumenLatencia latencia;
+    double ruta_critica[NUM_NODOS_RUTA];
+    CosteOrquestador coste;
 } CicloResultado;
 
 typedef struct
@@ -75,19 +77,206 @@ typedef struct
 
 #define CICLOS_POR_REPORTE 5
 
+typedef enum
+{
+    REGLA_MAX = 0,
+    REGLA_CUALQUIERA,
+    REGLA_QUORUM
+} ReglaAbanico;
+
+static const char *NOMBRES_REGLAS_ABANICO[] = {"max", "cualquiera", "quorum"};
+
+/* Segundos; un periodo 0 es una tarea esporádica, liberada por evento. */
+typedef struct
+{
+    double periodo;
+    double plazo_relativo;
+    double presupuesto;
+} ParametrosEdf;
+
+static const ParametrosEdf EDF_P1 = {16.0, 16.0, 10.0};
+static const ParametrosEdf EDF_P2 = {0.0, 1.0, 0.0};
+static const ParametrosEdf EDF_P3 = {16.0, 16.0, 5.0};
+
+typedef enum
+{
+    TRAMO_RECEPTOR = 0,
+    TRAMO_ANALIZADOR,
+    TRAMO_ESCUDO,
+    TRAMO_EXTREMO,
+    TRAMO_EXTREMO_CRITICO,
+    NUM_TRAMOS
+} TramoLatencia;
+
+static const char *NOMBRES_TRAMOS[NUM_TRAMOS] = {
+    "entrada_a_salida_p1",
+    "salida_p1_a_salida_p3",
+    "salida_p3_a_actuacion",
+    "extremo_a_extremo",
+    "extremo_a_extremo_critico"};
+
+typedef enum
+{
+    METRICA_CPU = 0,
+    METRICA_UTILIZACION_QUANTUM,
+    METRICA_MEMORIA_PICO,
+    NUM_METRICAS_PROCESO
+} MetricaProceso;
+
+static const char *NOMBRES_METRICAS_PROCESO[NUM_METRICAS_PROCESO] = {
+    "cpu",
+    "utilizacion_quantum",
+    "memoria_pico_kb"};
+
+typedef struct
+{
+    double cpu;
+    double quantum_dado;
+    double quantum_usado;
+    long cambios_voluntarios;
+    long cambios_involuntarios;
+    long pausas;
+    long instancias;
+} TotalesProceso;
+
+typedef struct
+{
+    EstadisticaOnline tiempo_ciclo;
+    EstadisticaOnline tiempo_muerto;
+    EstadisticaOnline cpu_kernel;
+    EstadisticaOnline sobrepaso_quantum;
+    EstadisticaOnline lanzamiento;
+    EstadisticaOnline arranque;
+    EstadisticaOnline proceso[3][NUM_METRICAS_PROCESO];
+    TotalesProceso totales[3];
+    long registros_p3;
+    long registros_perdidos;
+    long registros_fuera_de_orden;
+} EstadisticasEscenario;
+
+TrazaLecturas traza_lecturas;
+
+#define MAX_EVENTOS_LINEA_TIEMPO 65536
+#define PISTA_KERNEL 0
+
+typedef enum
+{
+    EVENTO_LANZAMIENTO = 0,
+    EVENTO_SIGCONT,
+    EVENTO_SIGSTOP,
+    EVENTO_SALIDA,
+    EVENTO_LECTURA_P3,
+    EVENTO_QUANTUM
+} TipoEventoLinea;
+
+typedef struct
+{
+    double instante;
+    double duracion;
+    pid_t pid;
+    int pista;
+    TipoEventoLinea tipo;
+    int dato;
+} EventoLinea;
+
+/* En memoria compartida: los hijos anotan su propio exec antes de reemplazar su imagen. */
+typedef struct
+{
+    int num_eventos;
+    int perdidos;
+    EventoLinea eventos[MAX_EVENTOS_LINEA_TIEMPO];
+} LineaTiempo;
+
+static LineaTiempo *linea_tiempo = NULL;
+static EstadisticaOnline latencias_escenario[5][NUM_TRAMOS];
+static EstadisticasEscenario estadisticas_escenario[5];
+static EstadisticaOnline duracion_alimentador;
+static EstadisticaOnline duracion_escaneo_traza;
+static ResumenLatencia resumen_latencia_ciclo;
+
+PoliticaPlanificacion politica_actual = POLITICA_RR;
+NivelLog nivel_log = NIVEL_LOG_NORMAL;
+
+/* 0 = solo medidas.txt. Sin -a K, el quorum es la mayoría. */
+static int num_sensores = 0;
+static ReglaAbanico regla_abanico = REGLA_MAX;
+static int quorum_abanico = 0;
+double quantum_p1_rr = 10.0;
+double quantum_p3_rr = 5.0;
+double intervalo_ciclo = 5.0;
+static volatile sig_atomic_t reinicio_solicitado = 0;
+static PaginaTelemetria *telemetria = NULL;
+
+static int modo_rt = 0;
+static int nucleo_rt = -1;
+static cpu_set_t nucleos_huespedes;
+
+#define QUANTUM_GANG 10
+
+#define MAX_DESCENDIENTES 1024
+#define INTERVALO_DESCENDIENTES_MS 10
+#define TIMEOUT_DESCENDIENTES 10
+
+#define MAX_CLIENTES_METRICAS 8
+#define TIMEOUT_CLIENTE_METRICAS 2.0
+
+#define MAX_HUESPEDES_RETENIDOS 16
+#define TAM_PILA_LANZAMIENTO (64 * 1024)
+#define TIMEOUT_ARRANQUE 2.0
+#define INTERVALO_MENU_MS 100
+
+#define ESTADOS_ANILLO_TRAZA 64
+#define PALABRAS_MEDIAS_ESTADO_TRAZA 8
+#define RANURAS_ESTADO_TRAZA 32
+
+#define MAX_SENSORES 256
+
+#define PRIORIDAD_RT 80
+#define PILA_PREASIGNADA_RT (512 * 1024)
+
+static int estados_anillo_traza = ESTADOS_ANILLO_TRAZA;
+
+typedef struct
+{
+    pid_t pid;
+    pid_t ppid;
+    int pidfd;
+    char ruta[128];
+    struct timeval inicio;
+    struct timeval fin;
+    struct rusage instantanea;
+    struct rusage absorbido;
+    int activo;
+} Descendiente;
+
+typedef struct
+{
+    Descendiente lista[MAX_DESCENDIENTES];
+    int num_descendientes;
+    int activo;
+    double ultimo_sondeo;
+    int reapeados_kernel;
+    int reapeados_padre;
+    int sin_identificar;
+    struct rusage uso_otros;
+} RegistroDescendientes;
+
+static RegistroDescendientes registro_descendientes;
+#define MAX_NUCLEOS 256
+#define MAX_COLA_NUCLEO 16
+
 static CicloResultado resultados_ciclos[CICLOS_POR_REPORTE];
 static int indice_resultados = 0;
 
 static AcumuladorMetricas acumulador_global = {0};
 
-static int escenario_actual = 0;
-static int ciclo_actual = 1;
+int escenario_actual = 0;
+int ciclo_actual = 1;
 
 static struct rusage usage_p1, usage_p2, usage_p3;
 static pid_t pid_p1 = 0, pid_p2 = 0, pid_p3 = 0;
-static struct timeval p1_start, p2_start, p3_start, ciclo_start;
+static struct timeval p1_start, p2_start, p3_start;
 static double time_p1 = 0, time_p2 = 0, time_p3 = 0;
-static double tiempo_escenario_2 = 0.0;
 static ProcesoStats p1_full_stats, p2_full_stats, p3_full_stats;
 
 void copiar_rusage_a_stats(struct rusage *usage, double wall_time, ProcesoStats *stats, int exit_status_code)
@@ -106,925 +295,4913 @@ void copiar_rusage_a_stats(struct rusage *usage, double wall_time, ProcesoStats
     stats->exit_status = exit_status_code;
 }
 
-void guardar_stats_proceso(const char *nombre_proceso, pid_t pid, double wall_time, struct rusage *usage, int status)
-{
-    int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
-
-    if (strstr(nombre_proceso, "proceso1"))
-    {
-        usage_p1 = *usage;
-        pid_p1 = pid;
-        time_p1 = wall_time;
-        copiar_rusage_a_stats(usage, wall_time, &p1_full_stats, exit_code);
-    }
-    else if (strstr(nombre_proceso, "proceso2"))
-    {
-        usage_p2 = *usage;
-        pid_p2 = pid;
-        time_p2 = wall_time;
-        copiar_rusage_a_stats(usage, wall_time, &p2_full_stats, exit_code);
-    }
-    else if (strstr(nombre_proceso, "proceso3"))
-    {
-        usage_p3 = *usage;
-        pid_p3 = pid;
-        time_p3 = wall_time;
-        copiar_rusage_a_stats(usage, wall_time, &p3_full_stats, exit_code);
-    }
-}
-
 double timeval_diff(struct timeval *start, struct timeval *end)
 {
     return (end->tv_sec - start->tv_sec) +
            (end->tv_usec - start->tv_usec) / 1000000.0;
 }
 
-void inicializar_stats(ProcesoStats *stats)
+double cpu_rusage(const struct rusage *uso)
 {
-    memset(stats, 0, sizeof(ProcesoStats));
+    return uso->ru_utime.tv_sec + uso->ru_utime.tv_usec / 1000000.0 +
+           uso->ru_stime.tv_sec + uso->ru_stime.tv_usec / 1000000.0;
 }
 
-void inicializar_ciclo()
+double tiempo_monotonico()
 {
-    pid_p1 = pid_p2 = pid_p3 = 0;
-    time_p1 = time_p2 = time_p3 = 0.0;
-    memset(&usage_p1, 0, sizeof(struct rusage));
-    memset(&usage_p2, 0, sizeof(struct rusage));
-    memset(&usage_p3, 0, sizeof(struct rusage));
-    inicializar_stats(&p1_full_stats);
-    inicializar_stats(&p2_full_stats);
-    inicializar_stats(&p3_full_stats);
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
 }
 
-const char *nombre_legible(const char *nombre)
+/* Solo en el hilo principal; el tiempo propio descuenta las fases anidadas. */
+
+#define MUESTRAS_CALIBRADO_FASES 10000
+
+static struct rusage uso_kernel_inicio;
+static double inicio_coste_orquestador = 0.0;
+static CosteOrquestador coste_ciclo;
+
+#ifndef KERNEL_SIN_FASES
+static const char *NOMBRES_FASES[NUM_FASES] = {
+    "inicio_ciclo", "alimentador", "lanzamiento", "seniales", "lectura_p3", "escaneo_traza", "anillo_traza",
+    "telemetria", "canales", "latencias", "tabla_recursos", "informe_consola", "estadisticas", "exportar_json",
+    "linea_tiempo", "perfil"};
+
+ContadorFase contadores_fase[NUM_FASES];
+uint64_t hijos_fase[MAX_PROFUNDIDAD_FASES];
+int profundidad_fase = 0;
+long activaciones_fase = 0;
+static double coste_temporizador_ns = 0.0;
+
+void calibrar_temporizadores_fase()
 {
-    if (strstr(nombre, "proceso1"))
-        return "Receptor de Señal";
-    if (strstr(nombre, "proceso2"))
-        return "Control Escudo";
-    if (strstr(nombre, "proceso3"))
-        return "Analizador Espectral";
-    return nombre;
+    uint64_t inicio = reloj_fase_ns();
+    for (int i = 0; i < MUESTRAS_CALIBRADO_FASES; i++)
+    {
+        FASE_KERNEL(NUM_FASES);
+    }
+    coste_temporizador_ns = (double)(reloj_fase_ns() - inicio) / MUESTRAS_CALIBRADO_FASES;
 }
-
-const char *color_proceso(const char *nombre)
+#else
+void calibrar_temporizadores_fase()
 {
-    if (strstr(nombre, "proceso1"))
-        return COLOR_P1;
-    if (strstr(nombre, "proceso2"))
-        return COLOR_P2;
-    if (strstr(nombre, "proceso3"))
-        return COLOR_P3;
-    return ANSI_WHITE;
 }
+#endif
 
-void proceso_terminado(const char *nombre_proceso, pid_t pid)
+void comenzar_coste_orquestador()
 {
-    printf("\n" COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) ha completado su tarea." ANSI_RESET "\n",
-           color_proceso(nombre_proceso), nombre_legible(nombre_proceso), pid);
-    fflush(stdout);
+    getrusage(RUSAGE_SELF, &uso_kernel_inicio);
+    inicio_coste_orquestador = tiempo_monotonico();
+#ifndef KERNEL_SIN_FASES
+    memset(contadores_fase, 0, sizeof(contadores_fase));
+    activaciones_fase = 0;
+#endif
 }
 
-void print_fila_tabla(const char *nombre, pid_t pid, double wall_time, struct rusage *usage)
+void medir_coste_orquestador(CosteOrquestador *c)
 {
-    printf("%s| %-20s | %-7d | %-11.6f | %ld.%06ld s | %ld.%06ld s | %-15ld |" ANSI_RESET "\n",
-           color_proceso(nombre),
-           nombre_legible(nombre), pid,
-           wall_time,
-           usage->ru_utime.tv_sec, usage->ru_utime.tv_usec,
-           usage->ru_stime.tv_sec, usage->ru_stime.tv_usec,
-           usage->ru_maxrss);
+    struct rusage ahora;
+    getrusage(RUSAGE_SELF, &ahora);
+
+    memset(c, 0, sizeof(CosteOrquestador));
+    c->tiempo_real = tiempo_monotonico() - inicio_coste_orquestador;
+    c->cpu_usuario = timeval_diff(&uso_kernel_inicio.ru_utime, &ahora.ru_utime);
+    c->cpu_sistema = timeval_diff(&uso_kernel_inicio.ru_stime, &ahora.ru_stime);
+    c->fallos_menores = ahora.ru_minflt - uso_kernel_inicio.ru_minflt;
+    c->fallos_mayores = ahora.ru_majflt - uso_kernel_inicio.ru_majflt;
+    c->cambios_voluntarios = ahora.ru_nvcsw - uso_kernel_inicio.ru_nvcsw;
+    c->cambios_involuntarios = ahora.ru_nivcsw - uso_kernel_inicio.ru_nivcsw;
+#ifndef KERNEL_SIN_FASES
+    memcpy(c->fases, contadores_fase, sizeof(c->fases));
+    for (int f = 0; f < NUM_FASES; f++)
+        c->tiempo_fases += contadores_fase[f].propio_ns / 1e9;
+    c->activaciones = activaciones_fase;
+    c->sobrecoste_temporizadores = activaciones_fase * coste_temporizador_ns / 1e9;
+#endif
 }
 
-void mostrar_tabla_recursos()
+void mostrar_coste_orquestador()
 {
-    printf(COLOR_TABLE "\n--- Resumen de Recursos del Ciclo ---\n");
-    printf("| Proceso              | PID     | T. Real (s) | CPU Usuario | CPU Sistema | Memoria Pico (KB) |\n");
-    printf("|----------------------|---------|-------------|-------------|-------------|-------------------|\n" ANSI_RESET);
-
-    if (pid_p1 > 0)
-        print_fila_tabla("./proceso1", pid_p1, time_p1, &usage_p1);
-    if (pid_p2 > 0)
-        print_fila_tabla("./proceso2", pid_p2, time_p2, &usage_p2);
-    if (pid_p3 > 0)
-        print_fila_tabla("./proceso3", pid_p3, time_p3, &usage_p3);
-
-    printf(COLOR_TABLE "|----------------------|---------|-------------|-------------|-------------|-------------------|\n" ANSI_RESET);
-    fflush(stdout);
+    CosteOrquestador c;
+    medir_coste_orquestador(&c);
+    double cpu = c.cpu_usuario + c.cpu_sistema;
+
+    printf(COLOR_TABLE "\n--- Coste del orquestador (ciclo + informe, %.3f s) ---\n", c.tiempo_real);
+#ifndef KERNEL_SIN_FASES
+    printf("| %-16s | %-9s | %-11s | %-11s | %-11s |\n", "Fase", "Llamadas", "Total (ms)", "Propio (ms)", "Max (ms)");
+    int mostradas[NUM_FASES] = {0};
+    while (1)
+    {
+        int mejor = -1;
+        for (int f = 0; f < NUM_FASES; f++)
+            if (!mostradas[f] && c.fases[f].llamadas > 0 && (mejor < 0 || c.fases[f].propio_ns > c.fases[mejor].propio_ns))
+                mejor = f;
+        if (mejor < 0)
+            break;
+        mostradas[mejor] = 1;
+        printf("| %-16s | %-9ld | %-11.3f | %-11.3f | %-11.3f |\n", NOMBRES_FASES[mejor], c.fases[mejor].llamadas,
+               c.fases[mejor].total_ns / 1e6, c.fases[mejor].propio_ns / 1e6, c.fases[mejor].max_ns / 1e6);
+    }
+    printf("  - Fases: %.3f ms propios en %ld activaciones; sobrecoste estimado de los temporizadores %.3f ms (%.0f ns c/u)\n",
+           c.tiempo_fases * 1e3, c.activaciones, c.sobrecoste_temporizadores * 1e3, coste_temporizador_ns);
+#endif
+    printf("  - CPU del kernel: %.6f s usuario + %.6f s sistema = %.6f s (%.2f%% del tiempo real) | fallos menores %ld, mayores %ld | cambios de contexto %ld vol. / %ld invol.\n" ANSI_RESET,
+           c.cpu_usuario, c.cpu_sistema, cpu, c.tiempo_real > 0.0 ? 100.0 * cpu / c.tiempo_real : 0.0,
+           c.fallos_menores, c.fallos_mayores, c.cambios_voluntarios, c.cambios_involuntarios);
 }
 
-void mostrar_metricas_extra(ProcesoStats *stats)
+void escribir_json_coste_orquestador(FILE *fp, const CosteOrquestador *c)
 {
-    if (stats->time_real == 0.0)
-        return;
-
-    printf(COLOR_TABLE "\n  [METRICAS AVANZADAS]\n");
-    printf("  - T. Ejecución Efectiva (CPU): %.6f s\n", stats->tiempo_ejecucion_efectiva);
-    printf("  - Cambios de Contexto (Vol/Inv): %d / %d\n", stats->cambios_contexto_voluntario, stats->cambios_contexto_involuntario);
-
-    if (stats->num_pausas > 0)
+    fprintf(fp, "\t\t\"coste_orquestador\": {\"cpu_usuario\": %.6f, \"cpu_sistema\": %.6f, \"fallos_menores\": %ld, \"fallos_mayores\": %ld, "
+                "\"cambios_voluntarios\": %ld, \"cambios_involuntarios\": %ld",
+            c->cpu_usuario, c->cpu_sistema, c->fallos_menores, c->fallos_mayores, c->cambios_voluntarios, c->cambios_involuntarios);
+#ifndef KERNEL_SIN_FASES
+    fprintf(fp, ", \"tiempo_fases\": %.6f, \"activaciones\": %ld, \"sobrecoste_temporizadores\": %.6f, \"fases\": {",
+            c->tiempo_fases, c->activaciones, c->sobrecoste_temporizadores);
+    int primera = 1;
+    for (int f = 0; f < NUM_FASES; f++)
     {
-        printf("  - Pausas Totales: %d\n", stats->num_pausas);
-        printf("  - T. Pausado Total (Wall): %.6f s\n", stats->tiempo_pausado_total);
-        printf("  - Quantum Dado/Usado: %.2f s / %.2f s\n", stats->quantum_dado_total, stats->quantum_usado_total);
+        if (c->fases[f].llamadas == 0)
+            continue;
+        fprintf(fp, "%s\"%s\": {\"llamadas\": %ld, \"total\": %.6f, \"propio\": %.6f, \"max\": %.6f}", primera ? "" : ", ",
+                NOMBRES_FASES[f], c->fases[f].llamadas, c->fases[f].total_ns / 1e9, c->fases[f].propio_ns / 1e9,
+                c->fases[f].max_ns / 1e9);
+        primera = 0;
     }
+    fprintf(fp, "}");
+#endif
+    fprintf(fp, "},\n");
+}
 
-    const char *estado;
-    if (WIFEXITED(stats->exit_status))
-        estado = "TERMINADO_EXIT";
-    else if (WIFSIGNALED(stats->exit_status))
-        estado = "TERMINADO_SENAL";
-    else
-        estado = "NO_TERMINADO";
-
-    printf("  - Estado Final: %s (Status: %d)\n" ANSI_RESET, estado, stats->exit_status);
+void inicializar_stats(ProcesoStats *stats)
+{
+    memset(stats, 0, sizeof(ProcesoStats));
 }
 
-void esperar_proceso(pid_t pid, const char *nombre_proceso, int timeout_sec, struct timeval *start_time)
+int indice_hdr(double valor, double escala)
 {
-    int status;
-    struct rusage usage;
-    struct timeval end_time;
-    double wall_time = 0.0;
-    int kill_signal = 0;
+    double escalado = valor * escala;
+    if (escalado < 1.0)
+        return 0;
 
-    if (timeout_sec > 0)
-    {
-        for (int remaining = timeout_sec; remaining > 0; remaining--)
-        {
-            pid_t terminado = wait4(pid, &status, WNOHANG, &usage);
-            if (terminado == pid)
-            {
-                gettimeofday(&end_time, NULL);
-                wall_time = timeval_diff(start_time, &end_time);
-                proceso_terminado(nombre_proceso, pid);
-                goto guardar_stats;
-            }
-            sleep(1);
-        }
+    unsigned long v = (unsigned long)escalado;
+    if (v < HDR_SUBCUBETAS)
+        return (int)v;
 
-        printf(COLOR_ERROR "[Control Central] ALERTA: " ANSI_RESET "%s%s (PID %d) no responde. Forzando terminación (SIGKILL)..." ANSI_RESET "\n",
-               color_proceso(nombre_proceso), nombre_legible(nombre_proceso), pid);
-        kill(pid, SIGKILL);
-        kill_signal = SIGKILL;
-        wait4(pid, &status, 0, &usage);
-        gettimeofday(&end_time, NULL);
-        wall_time = timeval_diff(start_time, &end_time);
-        proceso_terminado(nombre_proceso, pid);
-    }
-    {
-        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Esperando finalización de %s%s (PID %d)..." ANSI_RESET "\n",
-               color_proceso(nombre_proceso), nombre_legible(nombre_proceso), pid);
-        fflush(stdout);
+    int bit_alto = 63 - __builtin_clzl(v);
+    int desplazamiento = bit_alto - HDR_BITS_SUBCUBETA;
+    int indice = (desplazamiento + 1) * HDR_SUBCUBETAS + (int)((v >> desplazamiento) & (HDR_SUBCUBETAS - 1));
+    return indice < HDR_NUM_CUBETAS ? indice : HDR_NUM_CUBETAS - 1;
+}
 
-        wait4(pid, &status, 0, &usage);
+double valor_cubeta_hdr(int indice, double escala)
+{
+    if (indice < HDR_SUBCUBETAS)
+        return indice / escala;
 
-        gettimeofday(&end_time, NULL);
-        wall_time = timeval_diff(start_time, &end_time);
+    int desplazamiento = indice / HDR_SUBCUBETAS - 1;
+    unsigned long base = (unsigned long)(HDR_SUBCUBETAS + indice % HDR_SUBCUBETAS) << desplazamiento;
+    return (base + ((1UL << desplazamiento) - 1) / 2.0) / escala;
+}
 
-        fflush(stdout);
-        proceso_terminado(nombre_proceso, pid);
-    }
+void iniciar_estadistica(EstadisticaOnline *e, double escala)
+{
+    memset(e, 0, sizeof(EstadisticaOnline));
+    e->escala = escala;
+}
 
-guardar_stats:
-    guardar_stats_proceso(nombre_proceso, pid, wall_time, &usage, status);
+void registrar_estadistica(EstadisticaOnline *e, double valor)
+{
+    e->muestras++;
+    double delta = valor - e->media;
+    e->media += delta / e->muestras;
+    e->m2 += delta * (valor - e->media);
 
-    if (strstr(nombre_proceso, "proceso1"))
-        p1_full_stats.seniales_recibidas[kill_signal]++;
-    if (strstr(nombre_proceso, "proceso2"))
-        p2_full_stats.seniales_recibidas[kill_signal]++;
-    if (strstr(nombre_proceso, "proceso3"))
-        p3_full_stats.seniales_recibidas[kill_signal]++;
+    if (e->muestras == 1 || valor < e->minimo)
+        e->minimo = valor;
+    if (e->muestras == 1 || valor > e->maximo)
+        e->maximo = valor;
 
-    if (escenario_actual == 1)
+    e->cubetas[indice_hdr(valor, e->escala)]++;
+}
+
+/* Newton, para no enlazar con libm. */
+double raiz_cuadrada(double x)
+{
+    if (x <= 0.0)
+        return 0.0;
+
+    double r = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; i++)
     {
-        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Mostrando métricas adicionales para %s%s:\n",
-               color_proceso(nombre_proceso), nombre_legible(nombre_proceso));
-        if (strstr(nombre_proceso, "proceso1"))
-            mostrar_metricas_extra(&p1_full_stats);
-        if (strstr(nombre_proceso, "proceso2"))
-            mostrar_metricas_extra(&p2_full_stats);
-        if (strstr(nombre_proceso, "proceso3"))
-            mostrar_metricas_extra(&p3_full_stats);
+        double siguiente = 0.5 * (r + x / r);
+        if (siguiente >= r)
+            break;
+        r = siguiente;
     }
+    return r;
 }
 
-void lanzar_hijo_exec(char *const argv[])
+double desviacion_estadistica(const EstadisticaOnline *e)
 {
-    execvp("qemu-riscv32", argv);
-    perror(COLOR_ERROR "Error al iniciar componente de software" ANSI_RESET);
-    exit(1);
+    return e->muestras > 1 ? raiz_cuadrada(e->m2 / (e->muestras - 1)) : 0.0;
 }
 
-int leer_datos_p3(int pipe_fd)
+double percentil_estadistica(const EstadisticaOnline *e, double fraccion)
 {
-    char buffer[128];
-
-    ssize_t bytes = read(pipe_fd, buffer, sizeof(buffer) - 1);
-    int valor = 0;
-
-    if (bytes > 0)
+    if (e->muestras == 0)
+        return 0.0;
+
+    double rango = fraccion * e->muestras;
+    long objetivo = (long)rango;
+    if (objetivo < rango)
+        objetivo++;
+    long acumulado = 0;
+    if (objetivo < 1)
+        objetivo = 1;
+
+    for (int i = 0; i < HDR_NUM_CUBETAS; i++)
     {
-        buffer[bytes] = '\0';
-
-        for (int i = 0; i < bytes; i++)
+        acumulado += e->cubetas[i];
+        if (acumulado >= objetivo)
         {
-            if (buffer[i] == '\n')
-                buffer[i] = ' ';
+            double valor = valor_cubeta_hdr(i, e->escala);
+            if (valor < e->minimo)
+                return e->minimo;
+            return valor > e->maximo ? e->maximo : valor;
         }
+    }
+    return e->maximo;
+}
 
-        if (bytes > 0 && buffer[bytes - 1] == ' ')
-            buffer[bytes - 1] = '\0';
-
-        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Análisis recibido de %s%s" COLOR_KERNEL ": [%s]" ANSI_RESET "\n",
-               color_proceso("./proceso3"), nombre_legible("./proceso3"), buffer);
-
-        valor = atoi(buffer);
+void inicializar_estadisticas()
+{
+    for (int esc = 0; esc < 5; esc++)
+    {
+        for (int t = 0; t < NUM_TRAMOS; t++)
+            iniciar_estadistica(&latencias_escenario[esc][t], ESCALA_SEGUNDOS);
+
+        EstadisticasEscenario *est = &estadisticas_escenario[esc];
+        iniciar_estadistica(&est->tiempo_ciclo, ESCALA_SEGUNDOS);
+        iniciar_estadistica(&est->tiempo_muerto, ESCALA_SEGUNDOS);
+        iniciar_estadistica(&est->cpu_kernel, ESCALA_SEGUNDOS);
+        iniciar_estadistica(&est->sobrepaso_quantum, ESCALA_NANOSEGUNDOS);
+        iniciar_estadistica(&est->lanzamiento, ESCALA_NANOSEGUNDOS);
+        iniciar_estadistica(&est->arranque, ESCALA_NANOSEGUNDOS);
+        for (int p = 0; p < 3; p++)
+        {
+            iniciar_estadistica(&est->proceso[p][METRICA_CPU], ESCALA_SEGUNDOS);
+            iniciar_estadistica(&est->proceso[p][METRICA_UTILIZACION_QUANTUM], ESCALA_FRACCION);
+            iniciar_estadistica(&est->proceso[p][METRICA_MEMORIA_PICO], ESCALA_KB);
+        }
     }
 
-    return valor;
+    iniciar_estadistica(&duracion_alimentador, ESCALA_SEGUNDOS);
+    iniciar_estadistica(&duracion_escaneo_traza, ESCALA_SEGUNDOS);
 }
 
-void enviar_contenido_archivo_a_pipe(int pipe_fd_escritura, const char *archivo)
+void iniciar_telemetria()
 {
-    FILE *fp = fopen(archivo, "r");
-    if (!fp)
+    int fd = shm_open(TELEMETRIA_NOMBRE, O_CREAT | O_RDWR, 0644);
+    if (fd == -1 || ftruncate(fd, sizeof(PaginaTelemetria)) == -1)
     {
-        fprintf(stderr, COLOR_ERROR "[Control Central] ERROR: No se puede abrir el archivo de señal %s\n" ANSI_RESET, archivo);
+        perror(COLOR_ERROR "Telemetría no disponible" ANSI_RESET);
+        if (fd != -1)
+            close(fd);
         return;
     }
 
-    char datos_leidos;
-    while ((datos_leidos = fgetc(fp)) != EOF)
-        write(pipe_fd_escritura, &datos_leidos, 1);
+    void *mapa = mmap(NULL, sizeof(PaginaTelemetria), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapa == MAP_FAILED)
+    {
+        perror(COLOR_ERROR "Telemetría no disponible" ANSI_RESET);
+        return;
+    }
 
-    fclose(fp);
+    /* La secuencia se conserva: un monitor que siga abierto de una ejecución anterior
+       no debe ver una versión repetida. */
+    telemetria = mapa;
+    telemetria_comenzar_escritura(telemetria);
+    uint32_t secuencia = telemetria->secuencia;
+    memset(telemetria, 0, sizeof(PaginaTelemetria));
+    telemetria->secuencia = secuencia;
+    telemetria->magia = TELEMETRIA_MAGIA;
+    telemetria->version = TELEMETRIA_VERSION;
+    telemetria->tam_pagina = sizeof(PaginaTelemetria);
+    telemetria->pid_kernel = getpid();
+    telemetria->politica = politica_actual;
+    telemetria->instante_publicacion = tiempo_monotonico();
+    telemetria_terminar_escritura(telemetria);
 }
 
-unsigned long obtener_pc_riscv(const char *ruta_log)
+int slot_telemetria(const ProcesoStats *stats)
 {
-    char comando[256];
-
-    snprintf(comando, sizeof(comando), "tail -n 200 %s", ruta_log);
-
-    FILE *fp = popen(comando, "r");
-    if (!fp)
+    if (stats == &p1_full_stats)
         return 0;
+    if (stats == &p2_full_stats)
+        return 1;
+    if (stats == &p3_full_stats)
+        return 2;
+    return -1;
+}
 
-    char linea[256];
-    unsigned long ultimo_pc = 0;
+ProcesoStats *stats_por_slot(int slot)
+{
+    ProcesoStats *stats[3] = {&p1_full_stats, &p2_full_stats, &p3_full_stats};
+    return slot >= 0 && slot < 3 ? stats[slot] : NULL;
+}
 
-    while (fgets(linea, sizeof(linea), fp))
-    {
+int slot_telemetria_por_nombre(const char *nombre_proceso)
+{
+    if (strstr(nombre_proceso, "proceso1"))
+        return 0;
+    if (strstr(nombre_proceso, "proceso2"))
+        return 1;
+    if (strstr(nombre_proceso, "proceso3"))
+        return 2;
+    return -1;
+}
 
-        for (int i = 0; linea[i]; i++)
-            linea[i] = tolower(linea[i]);
+ProcesoStats *stats_por_programa(const char *ruta)
+{
+    static ProcesoStats stats_externos;
 
-        char *ptr = linea;
-        while ((ptr = strstr(ptr, "pc")) != NULL)
-        {
+    switch (slot_telemetria_por_nombre(ruta))
+    {
+    case 0:
+        return &p1_full_stats;
+    case 1:
+        return &p2_full_stats;
+    case 2:
+        return &p3_full_stats;
+    default:
+        return &stats_externos;
+    }
+}
 
-            int inicio_valido = (ptr == linea) || !isalnum(*(ptr - 1));
+void publicar_estado_proceso(int slot, pid_t pid, EstadoTelemetria estado, double quantum)
+{
+    FASE_KERNEL(FASE_TELEMETRIA);
+    if (slot >= 0 && estado != TEL_TERMINADO)
+        grabacion_rafagas.pids[slot] = pid;
 
-            int fin_valido = !isalnum(*(ptr + 2));
+    if (!telemetria || slot < 0)
+        return;
 
-            if (inicio_valido && fin_valido)
-            {
+    double ahora = tiempo_monotonico();
+    telemetria_comenzar_escritura(telemetria);
+    TelemetriaProceso *proc = &telemetria->procesos[slot];
+    if (estado == TEL_DETENIDO && proc->estado != TEL_DETENIDO)
+        proc->pausas++;
+    if (estado == TEL_EJECUTANDO && proc->estado == TEL_DETENIDO)
+        proc->reanudaciones++;
+    if (estado == TEL_EJECUTANDO && quantum > 0.0)
+    {
+        proc->quantum_actual = quantum;
+        proc->quantum_dado_total += quantum;
+    }
+    if (proc->pid != pid || proc->estado != (uint32_t)estado)
+        proc->instante_estado = ahora;
+    proc->pid = pid;
+    proc->estado = estado;
+    telemetria->instante_publicacion = ahora;
+    telemetria_terminar_escritura(telemetria);
+}
 
-                char *num_ptr = ptr + 2;
+void publicar_pc_proceso(const ProcesoStats *stats, unsigned long pc)
+{
+    FASE_KERNEL(FASE_TELEMETRIA);
+    int slot = slot_telemetria(stats);
+    if (!telemetria || slot < 0)
+        return;
 
-                while (*num_ptr && !isxdigit(*num_ptr))
-                    num_ptr++;
+    telemetria_comenzar_escritura(telemetria);
+    telemetria->procesos[slot].ultimo_pc = pc;
+    telemetria->instante_publicacion = tiempo_monotonico();
+    telemetria_terminar_escritura(telemetria);
+}
 
-                if (*num_ptr)
-                {
-                    ultimo_pc = strtoul(num_ptr, NULL, 16);
-                }
-            }
+void publicar_inicio_ciclo()
+{
+    FASE_KERNEL(FASE_TELEMETRIA);
+    if (!telemetria)
+        return;
 
-            ptr += 2;
-        }
+    telemetria_comenzar_escritura(telemetria);
+    telemetria->escenario = escenario_actual;
+    telemetria->ciclo = ciclo_actual;
+    telemetria->politica = politica_actual;
+    for (int p = 0; p < 3; p++)
+    {
+        TelemetriaProceso *proc = &telemetria->procesos[p];
+        proc->pid = 0;
+        proc->estado = TEL_INACTIVO;
+        proc->pausas = proc->reanudaciones = 0;
+        proc->quantum_actual = proc->quantum_dado_total = 0.0;
+        proc->ultimo_pc = 0;
     }
-
-    pclose(fp);
-    return ultimo_pc;
+    telemetria->instante_publicacion = tiempo_monotonico();
+    telemetria_terminar_escritura(telemetria);
 }
 
-void ejecutar_escenario_1()
+void publicar_fin_ciclo(double tiempo_total_ciclo)
 {
-    pid_t pid1, pid2, pid3;
-    const int TIMEOUT_P3 = 10;
-
-    int datos_pipe_p3[2];
-    int p1_input_pipe[2];
-    int p1_to_p3_pipe[2];
+    FASE_KERNEL(FASE_TELEMETRIA);
+    if (!telemetria || escenario_actual < 1 || escenario_actual > 4)
+        return;
 
-    if (pipe(datos_pipe_p3) == -1)
+    EstadisticasEscenario *est = &estadisticas_escenario[escenario_actual];
+    EstadisticaOnline *extremo = &latencias_escenario[escenario_actual][TRAMO_EXTREMO];
+
+    telemetria_comenzar_escritura(telemetria);
+    telemetria->ciclos_completados++;
+    telemetria->tiempo_ciclo_ultimo = tiempo_total_ciclo;
+    telemetria->tiempo_ciclo_media = est->tiempo_ciclo.media;
+    telemetria->tiempo_ciclo_p99 = percentil_estadistica(&est->tiempo_ciclo, 0.99);
+    telemetria->tiempo_muerto_media = est->tiempo_muerto.media;
+    telemetria->latencia_extremo_p50 = percentil_estadistica(extremo, 0.50);
+    telemetria->latencia_extremo_p99 = percentil_estadistica(extremo, 0.99);
+    for (int p = 0; p < 3; p++)
     {
-        perror(COLOR_ERROR "pipe datos_pipe_p3" ANSI_RESET);
-        exit(1);
+        telemetria->procesos[p].cpu_media = est->proceso[p][METRICA_CPU].media;
+        telemetria->procesos[p].utilizacion_quantum_media = est->proceso[p][METRICA_UTILIZACION_QUANTUM].media;
     }
+    telemetria->instante_publicacion = tiempo_monotonico();
+    telemetria_terminar_escritura(telemetria);
+}
 
-    if (pipe(p1_input_pipe) == -1)
+void iniciar_linea_tiempo()
+{
+    void *mapa = mmap(NULL, sizeof(LineaTiempo), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mapa == MAP_FAILED)
     {
-        perror(COLOR_ERROR "pipe p1_input_pipe" ANSI_RESET);
-        exit(1);
+        perror(COLOR_ERROR "Línea de tiempo no disponible" ANSI_RESET);
+        return;
     }
+    linea_tiempo = mapa;
+}
 
-    if (pipe(p1_to_p3_pipe) == -1)
+/* Pista 0 es el kernel; 1-3 son P1, P2 y P3 (ranura de telemetría + 1), -1 otro huésped. */
+void trazar_evento(TipoEventoLinea tipo, pid_t pid, int pista, double instante, double duracion, int dato)
+{
+    if (!linea_tiempo)
+        return;
+
+    int i = __atomic_fetch_add(&linea_tiempo->num_eventos, 1, __ATOMIC_RELAXED);
+    if (i >= MAX_EVENTOS_LINEA_TIEMPO)
     {
-        perror(COLOR_ERROR "pipe p1_to_p3_pipe" ANSI_RESET);
-        exit(1);
+        __atomic_fetch_add(&linea_tiempo->perdidos, 1, __ATOMIC_RELAXED);
+        return;
     }
+    linea_tiempo->eventos[i] = (EventoLinea){instante, duracion, pid, pista, tipo, dato};
+}
 
-    gettimeofday(&p1_start, NULL);
+/* Cada cambio de tramo o de huéspedes en ejecución cierra un segmento; el tiempo sin
+   tramo ni huésped en ejecución es kernel sin clasificar. */
 
-    if ((pid1 = fork()) == 0)
-    {
-        close(p1_input_pipe[1]);
-        dup2(p1_input_pipe[0], STDIN_FILENO);
-        close(p1_input_pipe[0]);
+#define MAX_SEGMENTOS_RUTA 4096
+#define MAX_ESLABONES_RUTA 12
+#define UMBRAL_ESLABON_RUTA 0.01
 
-        close(p1_to_p3_pipe[0]);
-        dup2(p1_to_p3_pipe[1], STDOUT_FILENO);
-        close(p1_to_p3_pipe[1]);
+static const char *NOMBRES_NODOS_RUTA[NUM_NODOS_RUTA] = {
+    "kernel (sin clasificar)", "alimentador", "lanzamiento", "señales", "tubería P3->kernel", "trazas", "consola",
+    "exportación JSON", "-", "espera P1", "espera P2", "espera P1+P2", "espera P3", "espera P1+P3", "espera P2+P3",
+    "espera P1+P2+P3"};
 
-        close(datos_pipe_p3[0]);
-        close(datos_pipe_p3[1]);
+typedef struct
+{
+    int nodo;
+    double duracion;
+} SegmentoRuta;
 
-        char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso1", NULL};
-        lanzar_hijo_exec(argv);
-    }
+typedef struct
+{
+    int activa;
+    pthread_t hilo;
+    TramoKernel tramo;
+    int corriendo;
+    double inicio_ventana;
+    double inicio_segmento;
+    double fin_ciclo;
+    double total[NUM_NODOS_RUTA];
+    double total_ciclo[NUM_NODOS_RUTA];
+    int segmentos_por_nodo[NUM_NODOS_RUTA];
+    SegmentoRuta segmentos[MAX_SEGMENTOS_RUTA];
+    int num_segmentos;
+    int segmentos_perdidos;
+} RutaCritica;
+
+static RutaCritica ruta_critica = {.tramo = TRAMO_KERNEL};
+
+/* Solo cuenta el hilo principal: los hilos auxiliares (perfilador, grifos) no acotan el ciclo. */
+int es_hilo_ruta_critica()
+{
+    return ruta_critica.hilo && pthread_equal(pthread_self(), ruta_critica.hilo);
+}
 
-    close(p1_input_pipe[0]);
-    close(p1_to_p3_pipe[1]);
+int nodo_ruta_actual()
+{
+    if (ruta_critica.tramo != TRAMO_KERNEL || ruta_critica.corriendo == 0)
+        return ruta_critica.tramo;
+    return NUM_TRAMOS_KERNEL + ruta_critica.corriendo;
+}
 
-    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
-    close(p1_input_pipe[1]);
+void avanzar_ruta_critica()
+{
+    RutaCritica *r = &ruta_critica;
+    if (!r->activa)
+        return;
 
-    gettimeofday(&p2_start, NULL);
+    double ahora = tiempo_monotonico();
+    double duracion = ahora - r->inicio_segmento;
+    int nodo = nodo_ruta_actual();
+    r->inicio_segmento = ahora;
+    if (duracion <= 0.0)
+        return;
 
-    if ((pid2 = fork()) == 0)
+    r->total[nodo] += duracion;
+    if (r->num_segmentos > 0 && r->segmentos[r->num_segmentos - 1].nodo == nodo)
+        r->segmentos[r->num_segmentos - 1].duracion += duracion;
+    else if (r->num_segmentos < MAX_SEGMENTOS_RUTA)
     {
-        close(datos_pipe_p3[0]);
-        close(datos_pipe_p3[1]);
-        close(p1_input_pipe[0]);
-        close(p1_input_pipe[1]);
-        close(p1_to_p3_pipe[0]);
-        close(p1_to_p3_pipe[1]);
-
-        char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", NULL};
-        lanzar_hijo_exec(argv);
+        r->segmentos[r->num_segmentos++] = (SegmentoRuta){nodo, duracion};
+        r->segmentos_por_nodo[nodo]++;
     }
+    else
+        r->segmentos_perdidos++;
+}
 
-    gettimeofday(&p3_start, NULL);
+/* Devuelve el tramo en curso para restaurarlo con salir_tramo: los tramos se anidan y el
+   tiempo se atribuye al más interno. */
+TramoKernel entrar_tramo(TramoKernel tramo)
+{
+    if (!es_hilo_ruta_critica())
+        return tramo;
+    TramoKernel previo = ruta_critica.tramo;
+    avanzar_ruta_critica();
+    ruta_critica.tramo = tramo;
+    return previo;
+}
 
-    if ((pid3 = fork()) == 0)
-    {
-        close(datos_pipe_p3[0]);
-        dup2(datos_pipe_p3[1], STDOUT_FILENO);
-        close(datos_pipe_p3[1]);
+void salir_tramo(TramoKernel previo)
+{
+    entrar_tramo(previo);
+}
 
-        close(p1_to_p3_pipe[1]);
-        dup2(p1_to_p3_pipe[0], STDIN_FILENO);
-        close(p1_to_p3_pipe[0]);
+void marcar_huesped_corriendo(int slot, int corriendo)
+{
+    if (slot < 0 || slot > 2 || !es_hilo_ruta_critica())
+        return;
+    avanzar_ruta_critica();
+    if (corriendo)
+        ruta_critica.corriendo |= 1 << slot;
+    else
+        ruta_critica.corriendo &= ~(1 << slot);
+}
 
-        close(p1_input_pipe[0]);
-        close(p1_input_pipe[1]);
+void iniciar_ruta_critica()
+{
+    ruta_critica.hilo = pthread_self();
+}
 
-        char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso3", NULL};
-        lanzar_hijo_exec(argv);
-    }
+void comenzar_ruta_critica()
+{
+    RutaCritica *r = &ruta_critica;
+    memset(r->total, 0, sizeof(r->total));
+    memset(r->total_ciclo, 0, sizeof(r->total_ciclo));
+    memset(r->segmentos_por_nodo, 0, sizeof(r->segmentos_por_nodo));
+    r->num_segmentos = r->segmentos_perdidos = 0;
+    r->corriendo = 0;
+    r->inicio_ventana = r->inicio_segmento = tiempo_monotonico();
+    r->fin_ciclo = 0.0;
+    r->activa = es_hilo_ruta_critica();
+}
 
-    close(datos_pipe_p3[1]);
-    close(p1_to_p3_pipe[0]);
+void cerrar_ciclo_ruta_critica()
+{
+    RutaCritica *r = &ruta_critica;
+    if (!r->activa)
+        return;
+    avanzar_ruta_critica();
+    memcpy(r->total_ciclo, r->total, sizeof(r->total));
+    r->fin_ciclo = tiempo_monotonico();
+}
 
-    kill(pid2, SIGSTOP);
-    p2_full_stats.seniales_recibidas[SIGSTOP]++;
-    p2_full_stats.num_pausas++;
-    kill(pid3, SIGSTOP);
-    p3_full_stats.seniales_recibidas[SIGSTOP]++;
-    p3_full_stats.num_pausas++;
+double tiempo_kernel_ruta(const double *totales)
+{
+    double suma = 0.0;
+    for (int n = 0; n < NUM_TRAMOS_KERNEL; n++)
+        suma += totales[n];
+    return suma;
+}
 
-    esperar_proceso(pid1, "./code/escenariosBasicos/proceso1", 0, &p1_start);
-    close(p1_to_p3_pipe[0]);
+int nodo_limitante(const double *totales)
+{
+    int limitante = 0;
+    for (int n = 1; n < NUM_NODOS_RUTA; n++)
+        if (totales[n] > totales[limitante])
+            limitante = n;
+    return limitante;
+}
 
-    struct timeval p1_end, p2_activacion;
-    gettimeofday(&p1_end, NULL);
-    p2_full_stats.tiempo_pausado_total += timeval_diff(&p2_start, &p1_end);
+/* Ancho de columna para printf con nombres UTF-8: cada byte de continuación no ocupa celda. */
+int ancho_columna_utf8(const char *texto, int ancho)
+{
+    for (; *texto; texto++)
+        if (((unsigned char)*texto & 0xC0) == 0x80)
+            ancho++;
+    return ancho;
+}
 
-    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Receptor (P1) terminó. Activando %s%s" COLOR_KERNEL "..." ANSI_RESET "\n", color_proceso("proceso2"), nombre_legible("proceso2"));
+void mostrar_ruta_critica()
+{
+    RutaCritica *r = &ruta_critica;
+    if (!r->activa)
+        return;
+    avanzar_ruta_critica();
+    r->activa = 0;
 
-    gettimeofday(&p2_activacion, NULL);
-    kill(pid2, SIGCONT);
-    p2_full_stats.seniales_recibidas[SIGCONT]++;
-    esperar_proceso(pid2, "./code/escenariosBasicos/proceso2", 0, &p2_activacion);
+    double ventana = r->inicio_segmento - r->inicio_ventana;
+    double ciclo = r->fin_ciclo > 0.0 ? r->fin_ciclo - r->inicio_ventana : ventana;
+    if (ventana <= 0.0)
+        return;
 
-    struct timeval p2_end, p3_activacion;
-    gettimeofday(&p2_end, NULL);
-    p3_full_stats.tiempo_pausado_total += timeval_diff(&p3_start, &p2_end);
+    printf(COLOR_TABLE "\n--- Ruta crítica del ciclo (%.3f s: ciclo %.3f s + informe %.3f s) ---\n", ventana, ciclo, ventana - ciclo);
 
-    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Escudo (P2) terminó. Activando %s%s" COLOR_KERNEL "..." ANSI_RESET "\n", color_proceso("proceso3"), nombre_legible("proceso3"));
+    printf("  ");
+    int eslabones = 0, omitidos = 0, ultimo = -1;
+    double acumulado = 0.0;
+    for (int s = 0; s <= r->num_segmentos; s++)
+    {
+        const SegmentoRuta *seg = s < r->num_segmentos ? &r->segmentos[s] : NULL;
+        if (seg && seg->duracion < UMBRAL_ESLABON_RUTA * ventana)
+            continue;
+        if (seg && seg->nodo == ultimo)
+        {
+            acumulado += seg->duracion;
+            continue;
+        }
+        if (ultimo >= 0)
+        {
+            if (eslabones < MAX_ESLABONES_RUTA)
+                printf("%s%s %.3f s", eslabones > 0 ? " -> " : "", NOMBRES_NODOS_RUTA[ultimo], acumulado);
+            else
+                omitidos++;
+            eslabones++;
+        }
+        if (seg)
+        {
+            ultimo = seg->nodo;
+            acumulado = seg->duracion;
+        }
+    }
+    if (omitidos > 0)
+        printf(" -> ... (+%d)", omitidos);
+    printf("\n");
 
-    gettimeofday(&p3_activacion, NULL);
-    kill(pid3, SIGCONT);
-    p3_full_stats.seniales_recibidas[SIGCONT]++;
-    esperar_proceso(pid3, "./code/escenariosBasicos/proceso3", 0, &p3_activacion);
+    printf("| %-24s | %-10s | %-7s | %-9s |\n", "Nodo", "Tiempo (s)", "%", "Segmentos");
+    double restantes[NUM_NODOS_RUTA];
+    memcpy(restantes, r->total, sizeof(restantes));
+    while (1)
+    {
+        int nodo = nodo_limitante(restantes);
+        if (restantes[nodo] <= 0.0)
+            break;
+        printf("| %-*s | %-10.6f | %-7.2f | %-9d |\n", ancho_columna_utf8(NOMBRES_NODOS_RUTA[nodo], 24),
+               NOMBRES_NODOS_RUTA[nodo], r->total[nodo],
+               100.0 * r->total[nodo] / ventana, r->segmentos_por_nodo[nodo]);
+        restantes[nodo] = 0.0;
+    }
 
-    leer_datos_p3(datos_pipe_p3[0]);
+    int limitante = nodo_limitante(r->total_ciclo);
+    printf("  - Acota el ciclo: %s (%.1f%%) | Kernel en el ciclo: %.6f s, en el informe: %.6f s%s\n" ANSI_RESET,
+           NOMBRES_NODOS_RUTA[limitante], ciclo > 0.0 ? 100.0 * r->total_ciclo[limitante] / ciclo : 0.0,
+           tiempo_kernel_ruta(r->total_ciclo), tiempo_kernel_ruta(r->total) - tiempo_kernel_ruta(r->total_ciclo),
+           r->segmentos_perdidos > 0 ? " (cadena truncada)" : "");
 }
 
-void ejecutar_escenario_2()
+void escribir_json_ruta_critica(FILE *fp, const double *totales)
 {
-    pid_t pid1, pid2, pid3;
-    const int QUANTUM_P1 = 10;
-    const int QUANTUM_P3 = 5;
+    fprintf(fp, "\t\t\"ruta_critica\": {\"limitante\": \"%s\"", NOMBRES_NODOS_RUTA[nodo_limitante(totales)]);
+    for (int n = 0; n < NUM_NODOS_RUTA; n++)
+        if (totales[n] > 0.0)
+            fprintf(fp, ", \"%s\": %.6f", NOMBRES_NODOS_RUTA[n], totales[n]);
+    fprintf(fp, "},\n");
+}
 
-    int p1_input_pipe[2];
-    int p1_to_p3_pipe[2];
-    int p3_to_kernel_pipe[2];
+/* Un huésped retenido espera a leer un byte de su extremo de un socketpair. Ese extremo es
+   O_CLOEXEC: el kernel ve EOF en el suyo justo cuando el exec se completa. */
 
-    struct rusage usage_temp;
-    int p1_status, p3_status;
-    int p1_vivo = 1, p3_vivo = 1;
-    int last_temp = -1;
-    double tiempo_acumulado_p1 = 0.0;
-    double tiempo_acumulado_p3 = 0.0;
-    struct timeval turno_start, turno_end;
-    struct timeval p1_last_stop_time, p3_last_stop_time;
-    struct timeval p1_turn_start, p3_turn_start;
+typedef struct
+{
+    pid_t pid;
+    int pidfd;
+    int fd_compuerta;
+} HuespedRetenido;
 
-    if (pipe(p1_input_pipe) == -1 || pipe(p1_to_p3_pipe) == -1 || pipe(p3_to_kernel_pipe) == -1)
+static HuespedRetenido huespedes_retenidos[MAX_HUESPEDES_RETENIDOS];
+static int num_huespedes_retenidos = 0;
+
+void soltar_retenido(int i)
+{
+    close(huespedes_retenidos[i].pidfd);
+    close(huespedes_retenidos[i].fd_compuerta);
+    huespedes_retenidos[i] = huespedes_retenidos[--num_huespedes_retenidos];
+}
+
+/* Devuelve 0 si el PID no estaba retenido. */
+int liberar_huesped(pid_t pid)
+{
+    int i = 0;
+    while (i < num_huespedes_retenidos && huespedes_retenidos[i].pid != pid)
+        i++;
+    if (i == num_huespedes_retenidos)
+        return 0;
+
+    HuespedRetenido *r = &huespedes_retenidos[i];
+    double liberado = tiempo_monotonico();
+    char senial = 1;
+    if (write(r->fd_compuerta, &senial, 1) == 1)
     {
-        perror("Error en pipes");
-        exit(1);
+        struct pollfd pfd[2] = {{.fd = r->fd_compuerta, .events = POLLIN}, {.fd = r->pidfd, .events = POLLIN}};
+        if (poll(pfd, 2, TIMEOUT_ARRANQUE * 1000) > 0 && !(pfd[1].revents & POLLIN) &&
+            read(r->fd_compuerta, &senial, 1) == 0 && escenario_actual >= 1 && escenario_actual <= 4)
+            registrar_estadistica(&estadisticas_escenario[escenario_actual].arranque, tiempo_monotonico() - liberado);
+    }
+    soltar_retenido(i);
+    return 1;
+}
+
+void purgar_retenidos()
+{
+    for (int i = 0; i < num_huespedes_retenidos;)
+    {
+        struct pollfd pfd = {.fd = huespedes_retenidos[i].pidfd, .events = POLLIN};
+        if (poll(&pfd, 1, 0) > 0)
+            soltar_retenido(i);
+        else
+            i++;
     }
+}
 
-    if ((pid1 = fork()) == 0)
+/* El instante se toma antes del kill: con SIGCONT el huésped puede desalojar al kernel
+   y anotar su propio evento antes de que kill vuelva. Un SIGCONT es además la
+   liberación de un huésped retenido en su compuerta. */
+void senial_huesped(pid_t pid, int senial, int slot)
+{
+    FASE_KERNEL(FASE_SENIALES);
+    TramoKernel previo = entrar_tramo(TRAMO_SENIALES);
+    double instante = tiempo_monotonico();
+    kill(pid, senial);
+    if (senial == SIGCONT)
+        liberar_huesped(pid);
+    marcar_huesped_corriendo(slot, senial == SIGCONT);
+    trazar_evento(senial == SIGSTOP ? EVENTO_SIGSTOP : EVENTO_SIGCONT, pid, slot + 1, instante, 0.0, 0);
+    if (nivel_log == NIVEL_LOG_DETALLE)
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s -> PID %d\n", senial == SIGSTOP ? "SIGSTOP" : "SIGCONT", pid);
+    salir_tramo(previo);
+
+    ProcesoStats *stats = stats_por_slot(slot);
+    if (!stats)
+        return;
+    if (senial == SIGSTOP && stats->instante_parada == 0.0)
+    {
+        stats->instante_parada = instante;
+    }
+    else if (senial == SIGCONT)
     {
-        close(p1_input_pipe[1]);
-        dup2(p1_input_pipe[0], STDIN_FILENO);
-        close(p1_input_pipe[0]);
+        if (stats->instante_parada > 0.0)
+            stats->espera_total += instante - stats->instante_parada;
+        stats->instante_parada = 0.0;
+        if (stats->instante_primera_ejecucion == 0.0)
+            stats->instante_primera_ejecucion = instante;
+    }
+}
 
-        close(p1_to_p3_pipe[0]);
-        dup2(p1_to_p3_pipe[1], STDOUT_FILENO);
-        close(p1_to_p3_pipe[1]);
+/* Sin llegada conocida (descendientes del escenario 4) se toma su tiempo de vida. */
+void registrar_metricas_clasicas(ProcesoStats *stats, double vida)
+{
+    double fin = tiempo_monotonico();
+    double llegada = stats->instante_llegada > 0.0 ? stats->instante_llegada : fin - vida;
+    double primera = stats->instante_primera_ejecucion > 0.0 ? stats->instante_primera_ejecucion : llegada;
+
+    stats->retorno_total += fin - llegada;
+    stats->respuesta_total += primera - llegada;
+    stats->completados++;
+    stats->instante_llegada = stats->instante_primera_ejecucion = stats->instante_parada = 0.0;
+}
 
-        close(p3_to_kernel_pipe[0]);
-        close(p3_to_kernel_pipe[1]);
+void detener_huesped(pid_t pid, ProcesoStats *stats)
+{
+    senial_huesped(pid, SIGSTOP, slot_telemetria(stats));
+    stats->seniales_recibidas[SIGSTOP]++;
+    publicar_estado_proceso(slot_telemetria(stats), pid, TEL_DETENIDO, 0.0);
+}
 
-        char *argv[] = {
-            "qemu-riscv32",
-            "-d", "cpu",
-            "-D", "p1_trace.log",
-            "./code/escenariosBasicos/proceso1",
-            NULL};
-        lanzar_hijo_exec(argv);
-    }
+void reanudar_huesped(pid_t pid, ProcesoStats *stats, double quantum)
+{
+    senial_huesped(pid, SIGCONT, slot_telemetria(stats));
+    stats->seniales_recibidas[SIGCONT]++;
+    publicar_estado_proceso(slot_telemetria(stats), pid, TEL_EJECUTANDO, quantum);
+}
 
-    if ((pid3 = fork()) == 0)
-    {
-        close(p1_input_pipe[0]);
-        close(p1_input_pipe[1]);
+void guardar_stats_proceso(const char *nombre_proceso, pid_t pid, double wall_time, struct rusage *usage, int status)
+{
+    int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
 
-        close(p1_to_p3_pipe[1]);
-        dup2(p1_to_p3_pipe[0], STDIN_FILENO);
-        close(p1_to_p3_pipe[0]);
+    publicar_estado_proceso(slot_telemetria_por_nombre(nombre_proceso), pid, TEL_TERMINADO, 0.0);
+    marcar_huesped_corriendo(slot_telemetria_por_nombre(nombre_proceso), 0);
+    trazar_evento(EVENTO_SALIDA, pid, slot_telemetria_por_nombre(nombre_proceso) + 1, tiempo_monotonico(), 0.0, exit_code);
 
-        close(p3_to_kernel_pipe[0]);
-        dup2(p3_to_kernel_pipe[1], STDOUT_FILENO);
-        close(p3_to_kernel_pipe[1]);
+    ProcesoStats *stats = stats_por_slot(slot_telemetria_por_nombre(nombre_proceso));
+    if (stats)
+        registrar_metricas_clasicas(stats, wall_time);
 
-        char *argv[] = {
-            "qemu-riscv32",
-            "-d", "cpu",
-            "-D", "p3_trace.log",
-            "./code/escenariosBasicos/proceso3",
-            NULL};
-        lanzar_hijo_exec(argv);
+    if (strstr(nombre_proceso, "proceso1"))
+    {
+        usage_p1 = *usage;
+        pid_p1 = pid;
+        time_p1 = wall_time;
+        copiar_rusage_a_stats(usage, wall_time, &p1_full_stats, exit_code);
     }
+    else if (strstr(nombre_proceso, "proceso2"))
+    {
+        usage_p2 = *usage;
+        pid_p2 = pid;
+        time_p2 = wall_time;
+        copiar_rusage_a_stats(usage, wall_time, &p2_full_stats, exit_code);
+    }
+    else if (strstr(nombre_proceso, "proceso3"))
+    {
+        usage_p3 = *usage;
+        pid_p3 = pid;
+        time_p3 = wall_time;
+        copiar_rusage_a_stats(usage, wall_time, &p3_full_stats, exit_code);
+    }
+}
 
-    close(p1_input_pipe[0]);
-    close(p1_to_p3_pipe[0]);
-    close(p1_to_p3_pipe[1]);
-    close(p3_to_kernel_pipe[1]);
-
-    fcntl(p3_to_kernel_pipe[0], F_SETFL, O_NONBLOCK);
+void iniciar_traza_lecturas()
+{
+    memset(&traza_lecturas, 0, sizeof(TrazaLecturas));
+    traza_lecturas.fd_p1_a_p3 = -1;
+    traza_lecturas.fd_p3_a_kernel = -1;
+    traza_lecturas.fd_actuaciones = -1;
+    memset(&resumen_latencia_ciclo, 0, sizeof(ResumenLatencia));
+}
 
-    kill(pid1, SIGSTOP);
-    p1_full_stats.seniales_recibidas[SIGSTOP]++;
-    gettimeofday(&p1_last_stop_time, NULL);
-    kill(pid3, SIGSTOP);
-    p3_full_stats.seniales_recibidas[SIGSTOP]++;
-    gettimeofday(&p3_last_stop_time, NULL);
+void registrar_entrada_lectura(int valor, long fin_en_flujo)
+{
+    if (traza_lecturas.num_lecturas >= MAX_LECTURAS_TRAZADAS)
+        return;
 
-    p1_full_stats.num_pausas++;
-    p3_full_stats.num_pausas++;
+    LecturaTrazada *lectura = &traza_lecturas.lecturas[traza_lecturas.num_lecturas++];
+    lectura->valor = valor;
+    lectura->fin_en_flujo = fin_en_flujo;
+    lectura->instante[ETAPA_ENTRADA] = tiempo_monotonico();
+}
 
-    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Procesos listos. Iniciando...\n");
+/* El kernel conserva un duplicado del extremo de lectura de p1_to_p3_pipe sin
+   leerlo: los bytes pendientes (FIONREAD) más los ya consumidos por P3 dan la
+   posición de P1 en el flujo, porque P1 y P3 reenvían la entrada byte a byte. */
+void vigilar_pipes_lecturas(int fd_p1_a_p3, int fd_p3_a_kernel)
+{
+    if (fd_p1_a_p3 >= 0)
+        traza_lecturas.fd_p1_a_p3 = fcntl(fd_p1_a_p3, F_DUPFD_CLOEXEC, 0);
+    traza_lecturas.fd_p3_a_kernel = fd_p3_a_kernel;
+}
 
-    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
-    close(p1_input_pipe[1]);
+char estado_huesped(pid_t pid)
+{
+    char ruta[64], linea[512];
+    FILE *fp;
+    char estado = 0;
 
-    while (p1_vivo || p3_vivo)
+    snprintf(ruta, sizeof(ruta), "/proc/%d/stat", pid);
+    if ((fp = fopen(ruta, "r")) != NULL)
     {
-
-        if (p1_vivo)
+        if (fgets(linea, sizeof(linea), fp))
         {
-            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %d seg...\n",
-                   color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1, QUANTUM_P1);
+            char *cierre = strrchr(linea, ')');
+            if (cierre && cierre[1] == ' ')
+                estado = cierre[2];
+        }
+        fclose(fp);
+    }
+    return estado;
+}
 
-            struct timeval now;
-            gettimeofday(&now, NULL);
-            p1_full_stats.tiempo_pausado_total += timeval_diff(&p1_last_stop_time, &now);
+long bytes_pendientes(int fd)
+{
+    int pendientes = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &pendientes) == -1)
+        return 0;
+    return pendientes;
+}
 
-            gettimeofday(&turno_start, NULL);
-            p1_turn_start = turno_start;
-            kill(pid1, SIGCONT);
-            p1_full_stats.seniales_recibidas[SIGCONT]++;
-            sleep(QUANTUM_P1);
-            gettimeofday(&turno_end, NULL);
-            tiempo_acumulado_p1 += timeval_diff(&turno_start, &turno_end);
-            p1_full_stats.quantum_dado_total += QUANTUM_P1;
+double cpu_huesped(pid_t pid)
+{
+    char ruta[64];
+    unsigned long long ns;
 
-            if (wait4(pid1, &p1_status, WNOHANG, &usage_temp) == pid1)
-            {
-                p1_vivo = 0;
-                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &turno_end);
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó." ANSI_RESET "\n",
-                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
-                guardar_stats_proceso("./code/escenariosBasicos/proceso1", pid1, tiempo_acumulado_p1, &usage_temp, p1_status);
-            }
-            else
-            {
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
-                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
-                kill(pid1, SIGSTOP);
-                usleep(10000);
-                unsigned long pc_p1 = obtener_pc_riscv("p1_trace.log");
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "El proceso 1 se quedó en el PC: 0x%lx\n" ANSI_RESET, pc_p1);
-                p1_full_stats.seniales_recibidas[SIGSTOP]++;
-                gettimeofday(&p1_last_stop_time, NULL);
-                p1_full_stats.num_pausas++;
-                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &p1_last_stop_time);
-            }
-        }
+    if (pid <= 0)
+        return -1.0;
+    snprintf(ruta, sizeof(ruta), "/proc/%d/schedstat", pid);
+    FILE *fp = fopen(ruta, "r");
+    if (!fp)
+        return -1.0;
+    int leido = fscanf(fp, "%llu", &ns) == 1;
+    fclose(fp);
+    return leido ? ns / ESCALA_NANOSEGUNDOS : -1.0;
+}
+
+void marcar_etapa_lecturas(int *siguiente, EtapaLectura etapa, long producido, double ahora)
+{
+    double cpu = -1.0;
+    int cpu_medida = 0;
 
-        if (p3_vivo)
+    while (*siguiente < traza_lecturas.num_lecturas &&
+           traza_lecturas.lecturas[*siguiente].fin_en_flujo <= producido)
+    {
+        if (grabacion_rafagas.fp && !cpu_medida)
         {
-            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %d seg...\n",
-                   color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3, QUANTUM_P3);
+            cpu = cpu_huesped(grabacion_rafagas.pids[etapa == ETAPA_SALIDA_P1 ? 0 : 2]);
+            cpu_medida = 1;
+        }
+        traza_lecturas.lecturas[*siguiente].instante[etapa] = ahora;
+        traza_lecturas.lecturas[*siguiente].cpu_emision[etapa] = cpu;
+        (*siguiente)++;
+    }
+}
 
-            struct timeval now;
-            gettimeofday(&now, NULL);
-            p3_full_stats.tiempo_pausado_total += timeval_diff(&p3_last_stop_time, &now);
+void registrar_actuacion_lecturas(int cantidad, double ahora)
+{
+    while (cantidad-- > 0 && traza_lecturas.siguiente_actuacion < traza_lecturas.num_lecturas)
+        traza_lecturas.lecturas[traza_lecturas.siguiente_actuacion++].instante[ETAPA_ACTUACION] = ahora;
+}
 
-            gettimeofday(&turno_start, NULL);
-            p3_turn_start = turno_start;
-            kill(pid3, SIGCONT);
-            p3_full_stats.seniales_recibidas[SIGCONT]++;
-            sleep(QUANTUM_P3);
+void leer_actuaciones_escudo(double ahora)
+{
+    char buffer[256];
+    ssize_t bytes;
 
-            last_temp = leer_datos_p3(p3_to_kernel_pipe[0]);
+    while ((bytes = read(traza_lecturas.fd_actuaciones, buffer, sizeof(buffer))) > 0)
+    {
+        fwrite(buffer, 1, bytes, stdout);
+        for (ssize_t i = 0; i < bytes; i++)
+            if (buffer[i] == '\n')
+                registrar_actuacion_lecturas(1, ahora);
+    }
+    fflush(stdout);
 
-            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Temperatura analizada por %s%s: %d\n",
-                   color_proceso("./proceso3"), nombre_legible("./proceso3"), last_temp);
+    if (bytes == 0)
+    {
+        close(traza_lecturas.fd_actuaciones);
+        traza_lecturas.fd_actuaciones = -1;
+    }
+}
 
-            gettimeofday(&turno_end, NULL);
-            tiempo_acumulado_p3 += timeval_diff(&turno_start, &turno_end);
-            p3_full_stats.quantum_dado_total += QUANTUM_P3;
+void muestrear_latencias()
+{
+    FASE_KERNEL(FASE_LATENCIAS);
+    double ahora = tiempo_monotonico();
 
-            if (wait4(pid3, &p3_status, WNOHANG, &usage_temp) == pid3)
-            {
-                p3_vivo = 0;
-                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &turno_end);
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó." ANSI_RESET "\n",
-                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
-                guardar_stats_proceso("./code/escenariosBasicos/proceso3", pid3, tiempo_acumulado_p3, &usage_temp, p3_status);
-            }
-            else
-            {
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
-                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
-                kill(pid3, SIGSTOP);
-                usleep(10000);
-                unsigned long pc_p3 = obtener_pc_riscv("p3_trace.log");
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "El proceso 3 se quedó en el PC: 0x%lx\n" ANSI_RESET, pc_p3);
-                p3_full_stats.seniales_recibidas[SIGSTOP]++;
-                gettimeofday(&p3_last_stop_time, NULL);
-                p3_full_stats.num_pausas++;
-                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &p3_last_stop_time);
-            }
-        }
+    if (traza_lecturas.fd_p3_a_kernel >= 0 || traza_lecturas.fd_p1_a_p3 >= 0)
+    {
+        long producido_p3 = traza_lecturas.bytes_recibidos_p3 + bytes_pendientes(traza_lecturas.fd_p3_a_kernel);
+        long producido_p1 = producido_p3 + bytes_pendientes(traza_lecturas.fd_p1_a_p3);
 
-        if (last_temp != -1)
-        {
-            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Lanzando %s%s con argumento: %d (Acción por defecto si < 90).\n",
-                   color_proceso("./proceso2"), nombre_legible("./proceso2"), (last_temp > 90) ? 1 : 0);
+        marcar_etapa_lecturas(&traza_lecturas.siguiente_salida_p1, ETAPA_SALIDA_P1, producido_p1, ahora);
+        marcar_etapa_lecturas(&traza_lecturas.siguiente_salida_p3, ETAPA_SALIDA_P3, producido_p3, ahora);
+    }
 
-            gettimeofday(&p2_start, NULL);
+    if (traza_lecturas.fd_actuaciones >= 0)
+        leer_actuaciones_escudo(ahora);
+}
 
-            if ((pid2 = fork()) == 0)
-            {
-                close(p3_to_kernel_pipe[0]);
-                char temp_arg[2] = {(last_temp > 90) ? '1' : '0', '\0'};
-                char *args[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", temp_arg, NULL};
-                lanzar_hijo_exec(args);
-            }
+/* El Escudo actúa sobre todas las lecturas que P3 entregó desde la actuación anterior. */
+void registrar_actuacion_escudo()
+{
+    muestrear_latencias();
+    registrar_actuacion_lecturas(traza_lecturas.siguiente_salida_p3 - traza_lecturas.siguiente_actuacion,
+                                 tiempo_monotonico());
+}
 
-            esperar_proceso(pid2, "./code/escenariosBasicos/proceso2", 0, &p2_start);
+void registrar_tramo(EstadisticaOnline *hist, const LecturaTrazada *lectura, EtapaLectura desde, EtapaLectura hasta)
+{
+    if (lectura->instante[desde] > 0.0 && lectura->instante[hasta] > 0.0)
+        registrar_estadistica(hist, lectura->instante[hasta] - lectura->instante[desde]);
+}
+
+void consolidar_traza_lecturas()
+{
+    muestrear_latencias();
+
+    /* Lo que P3 nunca llegó a entregar (p. ej. P1 terminado a la fuerza) también se pierde. */
+    int canal_p3_vigilado = traza_lecturas.fd_p3_a_kernel >= 0;
+    if (canal_p3_vigilado && traza_lecturas.siguiente_registro_p3 < traza_lecturas.num_lecturas)
+        resumen_latencia_ciclo.registros_perdidos += traza_lecturas.num_lecturas - traza_lecturas.siguiente_registro_p3;
+
+    if (traza_lecturas.fd_p1_a_p3 >= 0)
+        close(traza_lecturas.fd_p1_a_p3);
+    if (traza_lecturas.fd_actuaciones >= 0)
+        close(traza_lecturas.fd_actuaciones);
+    traza_lecturas.fd_p1_a_p3 = traza_lecturas.fd_p3_a_kernel = traza_lecturas.fd_actuaciones = -1;
+
+    if (escenario_actual < 1 || escenario_actual > 4)
+        return;
+
+    EstadisticaOnline *hist = latencias_escenario[escenario_actual];
+    ResumenLatencia *resumen = &resumen_latencia_ciclo;
+    double suma_extremo = 0.0;
+
+    resumen->lecturas = traza_lecturas.num_lecturas;
+
+    EstadisticasEscenario *est = &estadisticas_escenario[escenario_actual];
+    est->registros_p3 += resumen->registros_p3;
+    est->registros_perdidos += resumen->registros_perdidos;
+    est->registros_fuera_de_orden += resumen->registros_fuera_de_orden;
+
+    for (int i = 0; i < traza_lecturas.num_lecturas; i++)
+    {
+        const LecturaTrazada *lectura = &traza_lecturas.lecturas[i];
+
+        registrar_tramo(&hist[TRAMO_RECEPTOR], lectura, ETAPA_ENTRADA, ETAPA_SALIDA_P1);
+        registrar_tramo(&hist[TRAMO_ANALIZADOR], lectura, ETAPA_SALIDA_P1, ETAPA_SALIDA_P3);
+        registrar_tramo(&hist[TRAMO_ESCUDO], lectura, ETAPA_SALIDA_P3, ETAPA_ACTUACION);
+
+        if (lectura->instante[ETAPA_ACTUACION] <= 0.0)
+            continue;
+
+        double extremo = lectura->instante[ETAPA_ACTUACION] - lectura->instante[ETAPA_ENTRADA];
+        registrar_estadistica(&hist[TRAMO_EXTREMO], extremo);
+        resumen->actuadas++;
+        suma_extremo += extremo;
+        if (extremo > resumen->extremo_max)
+            resumen->extremo_max = extremo;
+
+        if (lectura->valor > UMBRAL_ESCUDO)
+        {
+            registrar_estadistica(&hist[TRAMO_EXTREMO_CRITICO], extremo);
+            resumen->criticas++;
+            if (extremo > resumen->critica_max)
+                resumen->critica_max = extremo;
         }
     }
 
-    close(p3_to_kernel_pipe[0]);
+    if (resumen->actuadas > 0)
+        resumen->extremo_medio = suma_extremo / resumen->actuadas;
+}
 
-    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Ciclo de Round-Robin finalizado.\n");
+void inicializar_ciclo()
+{
+    FASE_KERNEL(FASE_INICIO_CICLO);
+    pid_p1 = pid_p2 = pid_p3 = 0;
+    time_p1 = time_p2 = time_p3 = 0.0;
+    memset(&usage_p1, 0, sizeof(struct rusage));
+    memset(&usage_p2, 0, sizeof(struct rusage));
+    memset(&usage_p3, 0, sizeof(struct rusage));
+    inicializar_stats(&p1_full_stats);
+    inicializar_stats(&p2_full_stats);
+    inicializar_stats(&p3_full_stats);
+    iniciar_traza_lecturas();
+    reiniciar_backend_es();
+    publicar_inicio_ciclo();
 }
 
-void ejecutar_escenario_3()
+const char *nombre_legible(const char *nombre)
 {
-    pid_t pid1, pid2, pid3;
-    const int TIMEOUT_P1 = 10;
-    const int TIMEOUT_P3 = 5;
+    if (strstr(nombre, "proceso1"))
+        return "Receptor de Señal";
+    if (strstr(nombre, "proceso2"))
+        return "Control Escudo";
+    if (strstr(nombre, "proceso3"))
+        return "Analizador Espectral";
+    return nombre;
+}
 
-    int p1_input_pipe[2], p1_to_p3_pipe[2], p3_to_kernel_pipe[2];
+const char *color_proceso(const char *nombre)
+{
+    if (strstr(nombre, "proceso1"))
+        return COLOR_P1;
+    if (strstr(nombre, "proceso2"))
+        return COLOR_P2;
+    if (strstr(nombre, "proceso3"))
+        return COLOR_P3;
+    return ANSI_WHITE;
+}
 
-    struct rusage usage_temp;
-    int p1_status, p3_status;
-    int p1_vivo = 1, p3_vivo = 1;
-    int arg_p2_proximo = -1;
+void proceso_terminado(const char *nombre_proceso, pid_t pid)
+{
+    printf("\n" COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) ha completado su tarea." ANSI_RESET "\n",
+           color_proceso(nombre_proceso), nombre_legible(nombre_proceso), pid);
+    fflush(stdout);
+}
 
-    double tiempo_acumulado_p1 = 0.0;
-    double tiempo_acumulado_p3 = 0.0;
-    struct timeval turno_start, turno_end;
-    struct timeval p1_last_stop_time, p3_last_stop_time;
-    struct timeval p1_turn_start, p3_turn_start;
+typedef struct
+{
+    int fd;
+    char peticion[1024];
+    size_t recibidos;
+    char *respuesta;
+    size_t tam_respuesta;
+    size_t enviados;
+    double inicio;
+} ClienteMetricas;
+
+static int fd_metricas = -1;
+static ClienteMetricas clientes_metricas[MAX_CLIENTES_METRICAS];
+
+static const double LIMITES_CICLO_SEGUNDOS[] = {1, 2, 5, 10, 15, 20, 30, 45, 60, 90, 120, 180, 300, 600};
+#define NUM_LIMITES_CICLO ((int)(sizeof(LIMITES_CICLO_SEGUNDOS) / sizeof(LIMITES_CICLO_SEGUNDOS[0])))
+
+void iniciar_endpoint_metricas(int puerto)
+{
+    struct sockaddr_in direccion = {0};
+    int reutilizar = 1;
 
-    if (pipe(p1_input_pipe) == -1 || pipe(p1_to_p3_pipe) == -1 || pipe(p3_to_kernel_pipe) == -1)
+    fd_metricas = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_metricas == -1)
     {
-        perror("pipe");
+        perror("socket");
         exit(1);
     }
+    setsockopt(fd_metricas, SOL_SOCKET, SO_REUSEADDR, &reutilizar, sizeof(reutilizar));
+
+    direccion.sin_family = AF_INET;
+    direccion.sin_port = htons(puerto);
+    direccion.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
 
-    if ((pid1 = fork()) == 0)
+    if (bind(fd_metricas, (struct sockaddr *)&direccion, sizeof(direccion)) == -1 || listen(fd_metricas, MAX_CLIENTES_METRICAS) == -1)
     {
-        close(p1_input_pipe[1]);
-        dup2(p1_input_pipe[0], STDIN_FILENO);
-        close(p1_input_pipe[0]);
+        perror("bind/listen (endpoint de métricas)");
+        exit(1);
+    }
 
-        close(p1_to_p3_pipe[0]);
-        dup2(p1_to_p3_pipe[1], STDOUT_FILENO);
-        close(p1_to_p3_pipe[1]);
+    for (int i = 0; i < MAX_CLIENTES_METRICAS; i++)
+        clientes_metricas[i].fd = -1;
 
-        close(p3_to_kernel_pipe[0]);
-        close(p3_to_kernel_pipe[1]);
+    printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Métricas en http://127.0.0.1:%d/metrics\n", puerto);
+}
 
-        char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso1", NULL};
-        lanzar_hijo_exec(argv);
-    }
+void escribir_resumen_prometheus(FILE *fp, const char *nombre, const char *etiquetas, const EstadisticaOnline *e)
+{
+    static const double cuantiles[] = {0.5, 0.9, 0.99};
+    const char *separador = etiquetas[0] ? "," : "";
+
+    for (int q = 0; q < 3; q++)
+        fprintf(fp, "%s{%s%squantile=\"%g\"} %.6f\n", nombre, etiquetas, separador, cuantiles[q],
+                percentil_estadistica(e, cuantiles[q]));
+    fprintf(fp, "%s_sum{%s} %.6f\n", nombre, etiquetas, e->media * e->muestras);
+    fprintf(fp, "%s_count{%s} %ld\n", nombre, etiquetas, e->muestras);
+}
 
-    if ((pid3 = fork()) == 0)
+void escribir_histograma_prometheus(FILE *fp, const char *nombre, const char *etiquetas, const EstadisticaOnline *e)
+{
+    long acumulado = 0;
+    int cubeta = 0;
+
+    for (int l = 0; l < NUM_LIMITES_CICLO; l++)
     {
-        close(p1_input_pipe[0]);
-        close(p1_input_pipe[1]);
+        while (cubeta < HDR_NUM_CUBETAS && valor_cubeta_hdr(cubeta, e->escala) <= LIMITES_CICLO_SEGUNDOS[l])
+            acumulado += e->cubetas[cubeta++];
+        fprintf(fp, "%s_bucket{%s,le=\"%g\"} %ld\n", nombre, etiquetas, LIMITES_CICLO_SEGUNDOS[l], acumulado);
+    }
+    fprintf(fp, "%s_bucket{%s,le=\"+Inf\"} %ld\n", nombre, etiquetas, e->muestras);
+    fprintf(fp, "%s_sum{%s} %.6f\n", nombre, etiquetas, e->media * e->muestras);
+    fprintf(fp, "%s_count{%s} %ld\n", nombre, etiquetas, e->muestras);
+}
 
-        close(p1_to_p3_pipe[1]);
-        dup2(p1_to_p3_pipe[0], STDIN_FILENO);
-        close(p1_to_p3_pipe[0]);
+void escribir_metricas_prometheus(FILE *fp)
+{
+    static const char *politicas[] = {"rr", "edf", "gang", "datos"};
+    static const char *procesos[3] = {"proceso1", "proceso2", "proceso3"};
+    static const char *estados[4] = {"inactivo", "ejecutando", "detenido", "terminado"};
+    char etiquetas[128];
 
-        close(p3_to_kernel_pipe[0]);
-        dup2(p3_to_kernel_pipe[1], STDOUT_FILENO);
-        close(p3_to_kernel_pipe[1]);
+    fprintf(fp, "# HELP kernel_info Política de planificación activa.\n# TYPE kernel_info gauge\n");
+    fprintf(fp, "kernel_info{politica=\"%s\"} 1\n", politicas[politica_actual]);
+    fprintf(fp, "# TYPE kernel_escenario_actual gauge\nkernel_escenario_actual %d\n", escenario_actual);
+    fprintf(fp, "# TYPE kernel_ciclo_actual gauge\nkernel_ciclo_actual %d\n", ciclo_actual);
 
-        char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso3", NULL};
-        lanzar_hijo_exec(argv);
+    if (telemetria)
+    {
+        fprintf(fp, "# HELP kernel_proceso_estado Estado actual de cada huésped (1 en el estado vigente).\n# TYPE kernel_proceso_estado gauge\n");
+        for (int p = 0; p < 3; p++)
+            for (int e = 0; e < 4; e++)
+                fprintf(fp, "kernel_proceso_estado{proceso=\"%s\",estado=\"%s\"} %d\n",
+                        procesos[p], estados[e], telemetria->procesos[p].estado == (uint32_t)e);
     }
 
-    close(p1_input_pipe[0]);
-    close(p1_to_p3_pipe[0]);
-    close(p1_to_p3_pipe[1]);
-    close(p3_to_kernel_pipe[1]);
+    fprintf(fp, "# HELP kernel_ciclo_duracion_segundos Duración de cada ciclo completo.\n# TYPE kernel_ciclo_duracion_segundos histogram\n");
+    for (int esc = 1; esc <= 4; esc++)
+    {
+        snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\"", esc);
+        escribir_histograma_prometheus(fp, "kernel_ciclo_duracion_segundos", etiquetas, &estadisticas_escenario[esc].tiempo_ciclo);
+    }
 
-    fcntl(p3_to_kernel_pipe[0], F_SETFL, O_NONBLOCK);
+    fprintf(fp, "# HELP kernel_tiempo_muerto_segundos Tiempo del ciclo no atribuido a ningún huésped.\n# TYPE kernel_tiempo_muerto_segundos summary\n");
+    for (int esc = 1; esc <= 4; esc++)
+    {
+        snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\"", esc);
+        escribir_resumen_prometheus(fp, "kernel_tiempo_muerto_segundos", etiquetas, &estadisticas_escenario[esc].tiempo_muerto);
+    }
 
-    kill(pid1, SIGSTOP);
-    p1_full_stats.seniales_recibidas[SIGSTOP]++;
-    gettimeofday(&p1_last_stop_time, NULL);
-    kill(pid3, SIGSTOP);
-    p3_full_stats.seniales_recibidas[SIGSTOP]++;
-    gettimeofday(&p3_last_stop_time, NULL);
+    fprintf(fp, "# HELP kernel_cpu_propia_segundos CPU (usuario + sistema) consumida por el propio kernel en cada ciclo.\n# TYPE kernel_cpu_propia_segundos summary\n");
+    for (int esc = 1; esc <= 4; esc++)
+    {
+        snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\"", esc);
+        escribir_resumen_prometheus(fp, "kernel_cpu_propia_segundos", etiquetas, &estadisticas_escenario[esc].cpu_kernel);
+    }
 
-    p1_full_stats.num_pausas++;
-    p3_full_stats.num_pausas++;
+    fprintf(fp, "# HELP kernel_sobrepaso_quantum_segundos Retraso entre el fin previsto de cada quantum y el momento en que el planificador actúa.\n# TYPE kernel_sobrepaso_quantum_segundos summary\n");
+    for (int esc = 1; esc <= 4; esc++)
+    {
+        snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\"", esc);
+        escribir_resumen_prometheus(fp, "kernel_sobrepaso_quantum_segundos", etiquetas, &estadisticas_escenario[esc].sobrepaso_quantum);
+    }
 
-    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
-    close(p1_input_pipe[1]);
+    fprintf(fp, "# HELP kernel_lanzamiento_huesped_segundos Duración de clone() para crear un huésped (sin retener, incluye el exec).\n# TYPE kernel_lanzamiento_huesped_segundos summary\n");
+    for (int esc = 1; esc <= 4; esc++)
+    {
+        snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\"", esc);
+        escribir_resumen_prometheus(fp, "kernel_lanzamiento_huesped_segundos", etiquetas, &estadisticas_escenario[esc].lanzamiento);
+    }
 
-    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Procesos listos. Iniciando...\n");
+    fprintf(fp, "# HELP kernel_arranque_retenido_segundos Desde que se abre la compuerta de un huésped retenido hasta que completa su exec.\n# TYPE kernel_arranque_retenido_segundos summary\n");
+    for (int esc = 1; esc <= 4; esc++)
+    {
+        snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\"", esc);
+        escribir_resumen_prometheus(fp, "kernel_arranque_retenido_segundos", etiquetas, &estadisticas_escenario[esc].arranque);
+    }
 
-    while (p1_vivo || p3_vivo)
+    fprintf(fp, "# HELP kernel_registros_p3_total Registros del Analizador recibidos por el kernel, perdidos y fuera de orden.\n# TYPE kernel_registros_p3_total counter\n");
+    for (int esc = 1; esc <= 4; esc++)
     {
+        const EstadisticasEscenario *est = &estadisticas_escenario[esc];
+        fprintf(fp, "kernel_registros_p3_total{escenario=\"%d\",resultado=\"recibido\"} %ld\n", esc, est->registros_p3);
+        fprintf(fp, "kernel_registros_p3_total{escenario=\"%d\",resultado=\"perdido\"} %ld\n", esc, est->registros_perdidos);
+        fprintf(fp, "kernel_registros_p3_total{escenario=\"%d\",resultado=\"fuera_de_orden\"} %ld\n", esc, est->registros_fuera_de_orden);
+    }
 
+    const struct
+    {
+        const char *nombre;
+        const char *tipo;
+        const char *ayuda;
+    } contadores[] = {
+        {"kernel_proceso_cpu_segundos_total", "counter", "CPU (usuario + sistema) de los huéspedes."},
+        {"kernel_proceso_cambios_contexto_total", "counter", "Cambios de contexto voluntarios e involuntarios."},
+        {"kernel_proceso_pausas_total", "counter", "Veces que el planificador detuvo al huésped."},
+        {"kernel_proceso_quantum_dado_segundos_total", "counter", "Quantum concedido."},
+        {"kernel_proceso_quantum_usado_segundos_total", "counter", "Quantum efectivamente consumido."},
+        {"kernel_proceso_instancias_total", "counter", "Instancias del huésped contabilizadas."}};
+
+    for (int c = 0; c < 6; c++)
+    {
+        fprintf(fp, "# HELP %s %s\n# TYPE %s %s\n", contadores[c].nombre, contadores[c].ayuda, contadores[c].nombre, contadores[c].tipo);
+        for (int esc = 1; esc <= 4; esc++)
         {
-            char *arg_msg = (arg_p2_proximo == 1) ? "Activar (1)" : (arg_p2_proximo == 0) ? "Desactivar (0)"
-                                                                                          : "Neutro (-1)";
-            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Lanzando %s%s con argumento: %s (Decisión de ronda previa)...\n",
-                   color_proceso("proceso2"), nombre_legible("proceso2"), arg_msg);
-
-            gettimeofday(&p2_start, NULL);
-
-            if ((pid2 = fork()) == 0)
+            for (int p = 0; p < 3; p++)
             {
-                close(p3_to_kernel_pipe[0]);
-
-                if (arg_p2_proximo == -1)
+                const TotalesProceso *t = &estadisticas_escenario[esc].totales[p];
+                snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\",proceso=\"%s\"", esc, procesos[p]);
+                switch (c)
                 {
-                    char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", NULL};
-                    lanzar_hijo_exec(argv);
-                }
-                else
-                {
-                    char arg_str[2];
-                    sprintf(arg_str, "%d", arg_p2_proximo);
-                    char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", arg_str, NULL};
-                    lanzar_hijo_exec(argv);
+                case 0:
+                    fprintf(fp, "%s{%s} %.6f\n", contadores[c].nombre, etiquetas, t->cpu);
+                    break;
+                case 1:
+                    fprintf(fp, "%s{%s,tipo=\"voluntario\"} %ld\n", contadores[c].nombre, etiquetas, t->cambios_voluntarios);
+                    fprintf(fp, "%s{%s,tipo=\"involuntario\"} %ld\n", contadores[c].nombre, etiquetas, t->cambios_involuntarios);
+                    break;
+                case 2:
+                    fprintf(fp, "%s{%s} %ld\n", contadores[c].nombre, etiquetas, t->pausas);
+                    break;
+                case 3:
+                    fprintf(fp, "%s{%s} %.6f\n", contadores[c].nombre, etiquetas, t->quantum_dado);
+                    break;
+                case 4:
+                    fprintf(fp, "%s{%s} %.6f\n", contadores[c].nombre, etiquetas, t->quantum_usado);
+                    break;
+                default:
+                    fprintf(fp, "%s{%s} %ld\n", contadores[c].nombre, etiquetas, t->instancias);
                 }
             }
-
-            esperar_proceso(pid2, "proceso2", 0, &p2_start);
-
-            arg_p2_proximo = -1;
         }
+    }
 
-        if (p1_vivo)
+    fprintf(fp, "# HELP kernel_latencia_segundos Latencia sensor -> Escudo por tramo.\n# TYPE kernel_latencia_segundos summary\n");
+    for (int esc = 1; esc <= 4; esc++)
+    {
+        for (int t = 0; t < NUM_TRAMOS; t++)
         {
-            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %ds...\n",
-                   color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1, TIMEOUT_P1);
+            snprintf(etiquetas, sizeof(etiquetas), "escenario=\"%d\",tramo=\"%s\"", esc, NOMBRES_TRAMOS[t]);
+            escribir_resumen_prometheus(fp, "kernel_latencia_segundos", etiquetas, &latencias_escenario[esc][t]);
+        }
+    }
 
-            struct timeval now;
-            gettimeofday(&now, NULL);
-            p1_full_stats.tiempo_pausado_total += timeval_diff(&p1_last_stop_time, &now);
+    fprintf(fp, "# HELP kernel_alimentador_duracion_segundos Tiempo en volcar medidas.txt al pipe de P1.\n# TYPE kernel_alimentador_duracion_segundos summary\n");
+    escribir_resumen_prometheus(fp, "kernel_alimentador_duracion_segundos", "", &duracion_alimentador);
+    fprintf(fp, "# HELP kernel_escaneo_traza_duracion_segundos Tiempo en extraer el PC de la traza de QEMU.\n# TYPE kernel_escaneo_traza_duracion_segundos summary\n");
+    escribir_resumen_prometheus(fp, "kernel_escaneo_traza_duracion_segundos", "", &duracion_escaneo_traza);
+}
 
-            gettimeofday(&turno_start, NULL);
-            p1_turn_start = turno_start;
-            kill(pid1, SIGCONT);
-            p1_full_stats.seniales_recibidas[SIGCONT]++;
-            sleep(TIMEOUT_P1);
+void preparar_respuesta_metricas(ClienteMetricas *cliente)
+{
+    char *cuerpo = NULL;
+    size_t tam_cuerpo = 0;
+    int encontrado = strncmp(cliente->peticion, "GET /metrics", 12) == 0;
 
-            gettimeofday(&turno_end, NULL);
-            tiempo_acumulado_p1 += timeval_diff(&turno_start, &turno_end);
-            p1_full_stats.quantum_dado_total += TIMEOUT_P1;
+    FILE *fp = open_memstream(&cuerpo, &tam_cuerpo);
+    if (encontrado)
+        escribir_metricas_prometheus(fp);
+    else
+        fprintf(fp, "Solo se sirve GET /metrics\n");
+    fclose(fp);
+
+    fp = open_memstream(&cliente->respuesta, &cliente->tam_respuesta);
+    fprintf(fp, "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+            encontrado ? "200 OK" : "404 Not Found", tam_cuerpo);
+    fwrite(cuerpo, 1, tam_cuerpo, fp);
+    fclose(fp);
+    free(cuerpo);
+}
+
+void cerrar_cliente_metricas(ClienteMetricas *cliente)
+{
+    close(cliente->fd);
+    free(cliente->respuesta);
+    memset(cliente, 0, sizeof(ClienteMetricas));
+    cliente->fd = -1;
+}
 
-            if (wait4(pid1, &p1_status, WNOHANG, &usage_temp) == pid1)
+/* Nunca bloquea: se llama desde los bucles de espera del planificador. */
+void atender_metricas()
+{
+    if (fd_metricas == -1)
+        return;
+
+    int nuevo;
+    while ((nuevo = accept4(fd_metricas, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+    {
+        int libre = -1;
+        for (int i = 0; i < MAX_CLIENTES_METRICAS && libre == -1; i++)
+            if (clientes_metricas[i].fd == -1)
+                libre = i;
+
+        if (libre == -1)
+        {
+            close(nuevo);
+            continue;
+        }
+        clientes_metricas[libre].fd = nuevo;
+        clientes_metricas[libre].inicio = tiempo_monotonico();
+    }
+
+    for (int i = 0; i < MAX_CLIENTES_METRICAS; i++)
+    {
+        ClienteMetricas *cliente = &clientes_metricas[i];
+        if (cliente->fd == -1)
+            continue;
+
+        if (cliente->respuesta == NULL)
+        {
+            ssize_t n = recv(cliente->fd, cliente->peticion + cliente->recibidos,
+                             sizeof(cliente->peticion) - 1 - cliente->recibidos, 0);
+            if (n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK))
             {
-                p1_vivo = 0;
-                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &turno_end);
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó.\n",
-                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
-                guardar_stats_proceso("./code/escenariosBasicos/proceso1", pid1, tiempo_acumulado_p1, &usage_temp, p1_status);
+                cerrar_cliente_metricas(cliente);
+                continue;
             }
-            else
+            if (n > 0)
             {
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
-                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
-                kill(pid1, SIGSTOP);
-                p1_full_stats.seniales_recibidas[SIGSTOP]++;
-                gettimeofday(&p1_last_stop_time, NULL);
-                p1_full_stats.num_pausas++;
-                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &p1_last_stop_time);
+                cliente->recibidos += n;
+                cliente->peticion[cliente->recibidos] = '\0';
             }
+
+            if (strstr(cliente->peticion, "\r\n\r\n") || strstr(cliente->peticion, "\n\n") ||
+                cliente->recibidos == sizeof(cliente->peticion) - 1)
+                preparar_respuesta_metricas(cliente);
         }
 
-        if (p3_vivo)
+        if (cliente->respuesta != NULL)
         {
-            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %ds...\n",
-                   color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3, TIMEOUT_P3);
+            ssize_t n = send(cliente->fd, cliente->respuesta + cliente->enviados,
+                             cliente->tam_respuesta - cliente->enviados, MSG_NOSIGNAL);
+            if (n > 0)
+                cliente->enviados += n;
+            if ((n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) || cliente->enviados == cliente->tam_respuesta)
+            {
+                cerrar_cliente_metricas(cliente);
+                continue;
+            }
+        }
 
-            struct timeval now;
-            gettimeofday(&now, NULL);
-            p3_full_stats.tiempo_pausado_total += timeval_diff(&p3_last_stop_time, &now);
+        if (tiempo_monotonico() - cliente->inicio > TIMEOUT_CLIENTE_METRICAS)
+            cerrar_cliente_metricas(cliente);
+    }
+}
 
-            gettimeofday(&turno_start, NULL);
+int abrir_pidfd(pid_t pid)
+{
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+}
+
+int pidfd_sigue_existiendo(int pidfd)
+{
+    return syscall(SYS_pidfd_send_signal, pidfd, 0, NULL, 0) == 0;
+}
+
+void sumar_rusage(struct rusage *destino, const struct rusage *origen)
+{
+    timeradd(&destino->ru_utime, &origen->ru_utime, &destino->ru_utime);
+    timeradd(&destino->ru_stime, &origen->ru_stime, &destino->ru_stime);
+    if (origen->ru_maxrss > destino->ru_maxrss)
+        destino->ru_maxrss = origen->ru_maxrss;
+    destino->ru_nvcsw += origen->ru_nvcsw;
+    destino->ru_nivcsw += origen->ru_nivcsw;
+}
+
+void restar_rusage(struct rusage *destino, const struct rusage *origen)
+{
+    timersub(&destino->ru_utime, &origen->ru_utime, &destino->ru_utime);
+    timersub(&destino->ru_stime, &origen->ru_stime, &destino->ru_stime);
+    if (destino->ru_utime.tv_sec < 0)
+        timerclear(&destino->ru_utime);
+    if (destino->ru_stime.tv_sec < 0)
+        timerclear(&destino->ru_stime);
+    destino->ru_nvcsw -= origen->ru_nvcsw;
+    destino->ru_nivcsw -= origen->ru_nivcsw;
+}
+
+/* Uso de CPU y memoria de un proceso vivo según /proc, para el caso de que lo
+   recoja su propio padre y wait4 nunca nos entregue su rusage. */
+void leer_uso_proc(pid_t pid, struct rusage *uso)
+{
+    char ruta[64], linea[512];
+    FILE *fp;
+
+    snprintf(ruta, sizeof(ruta), "/proc/%d/stat", pid);
+    if ((fp = fopen(ruta, "r")) != NULL)
+    {
+        if (fgets(linea, sizeof(linea), fp))
+        {
+            char *cierre = strrchr(linea, ')');
+            unsigned long utime, stime;
+            if (cierre && sscanf(cierre + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) == 2)
+            {
+                long ticks = sysconf(_SC_CLK_TCK);
+                uso->ru_utime.tv_sec = utime / ticks;
+                uso->ru_utime.tv_usec = (utime % ticks) * 1000000 / ticks;
+                uso->ru_stime.tv_sec = stime / ticks;
+                uso->ru_stime.tv_usec = (stime % ticks) * 1000000 / ticks;
+            }
+        }
+        fclose(fp);
+    }
+
+    snprintf(ruta, sizeof(ruta), "/proc/%d/status", pid);
+    if ((fp = fopen(ruta, "r")) != NULL)
+    {
+        while (fgets(linea, sizeof(linea), fp))
+        {
+            sscanf(linea, "VmHWM: %ld", &uso->ru_maxrss);
+            sscanf(linea, "voluntary_ctxt_switches: %ld", &uso->ru_nvcsw);
+            sscanf(linea, "nonvoluntary_ctxt_switches: %ld", &uso->ru_nivcsw);
+        }
+        fclose(fp);
+    }
+}
+
+/* El ejecutable huésped aparece en la línea de comandos de qemu (o del intérprete binfmt).
+   Un clon aún sin execve conserva la de su padre, así que se relee en cada sondeo y
+   solo se sobrescribe la ruta conocida si la lectura tuvo éxito. */
+void leer_ruta_huesped(pid_t pid, char *ruta, size_t tam)
+{
+    char archivo[64], cmdline[1024];
+
+    snprintf(archivo, sizeof(archivo), "/proc/%d/cmdline", pid);
+    int fd = open(archivo, O_RDONLY);
+    if (fd == -1)
+        return;
+    ssize_t bytes = read(fd, cmdline, sizeof(cmdline) - 1);
+    close(fd);
+    if (bytes <= 0)
+        return;
+    cmdline[bytes] = '\0';
+
+    for (char *arg = cmdline; arg < cmdline + bytes; arg += strlen(arg) + 1)
+    {
+        if (strstr(arg, "proceso1") || strstr(arg, "proceso2") || strstr(arg, "proceso3"))
+        {
+            snprintf(ruta, tam, "%s", arg);
+            return;
+        }
+    }
+}
+
+/* Un zombi ya no tiene cmdline; queda su comm (el nombre del huésped si corre por binfmt)
+   y su instante de arranque, con el que se calcula cuánto vivió. */
+void identificar_zombi(pid_t pid, char *ruta, size_t tam, double *vivido)
+{
+    char archivo[64], linea[512];
+    FILE *fp;
+
+    *vivido = 0.0;
+    snprintf(archivo, sizeof(archivo), "/proc/%d/comm", pid);
+    if ((fp = fopen(archivo, "r")) != NULL)
+    {
+        if (fgets(linea, sizeof(linea), fp) && (strstr(linea, "proceso1") || strstr(linea, "proceso2") || strstr(linea, "proceso3")))
+        {
+            linea[strcspn(linea, "\n")] = '\0';
+            snprintf(ruta, tam, "%s", linea);
+        }
+        fclose(fp);
+    }
+
+    snprintf(archivo, sizeof(archivo), "/proc/%d/stat", pid);
+    if ((fp = fopen(archivo, "r")) != NULL)
+    {
+        unsigned long long arranque;
+        char *cierre = NULL;
+        if (fgets(linea, sizeof(linea), fp) && (cierre = strrchr(linea, ')')) &&
+            sscanf(cierre + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu", &arranque) == 1)
+        {
+            struct timespec ahora;
+            clock_gettime(CLOCK_BOOTTIME, &ahora);
+            *vivido = ahora.tv_sec + ahora.tv_nsec / 1e9 - (double)arranque / sysconf(_SC_CLK_TCK);
+            if (*vivido < 0.0)
+                *vivido = 0.0;
+        }
+        fclose(fp);
+    }
+}
+
+Descendiente *buscar_descendiente(pid_t pid)
+{
+    for (int i = 0; i < registro_descendientes.num_descendientes; i++)
+        if (registro_descendientes.lista[i].pid == pid)
+            return &registro_descendientes.lista[i];
+    return NULL;
+}
+
+Descendiente *registrar_descendiente(pid_t pid, pid_t ppid)
+{
+    if (registro_descendientes.num_descendientes >= MAX_DESCENDIENTES)
+        return NULL;
+
+    int pidfd = abrir_pidfd(pid);
+    if (pidfd == -1)
+        return NULL;
+
+    Descendiente *d = &registro_descendientes.lista[registro_descendientes.num_descendientes++];
+    memset(d, 0, sizeof(Descendiente));
+    d->pid = pid;
+    d->ppid = ppid;
+    d->pidfd = pidfd;
+    d->activo = 1;
+    gettimeofday(&d->inicio, NULL);
+    leer_ruta_huesped(pid, d->ruta, sizeof(d->ruta));
+    return d;
+}
+
+void iniciar_seguimiento_descendientes(pid_t raiz, const char *ruta_raiz)
+{
+    memset(&registro_descendientes, 0, sizeof(RegistroDescendientes));
+    registro_descendientes.activo = 1;
+
+    Descendiente *d = registrar_descendiente(raiz, getpid());
+    if (d && d->ruta[0] == '\0')
+        snprintf(d->ruta, sizeof(d->ruta), "%s", ruta_raiz);
+}
+
+void descubrir_hijos_de(pid_t padre)
+{
+    char ruta[64];
+    snprintf(ruta, sizeof(ruta), "/proc/%d/task", padre);
+
+    DIR *dir = opendir(ruta);
+    if (!dir)
+        return;
+
+    struct dirent *entrada;
+    while ((entrada = readdir(dir)) != NULL)
+    {
+        if (entrada->d_name[0] == '.')
+            continue;
+
+        char ruta_hijos[300];
+        snprintf(ruta_hijos, sizeof(ruta_hijos), "/proc/%d/task/%s/children", padre, entrada->d_name);
+        FILE *fp = fopen(ruta_hijos, "r");
+        if (!fp)
+            continue;
+
+        int hijo;
+        while (fscanf(fp, "%d", &hijo) == 1)
+        {
+            Descendiente *d = buscar_descendiente(hijo);
+            if (d == NULL)
+                registrar_descendiente(hijo, padre);
+            else if (d->activo)
+                leer_ruta_huesped(hijo, d->ruta, sizeof(d->ruta));
+        }
+        fclose(fp);
+    }
+    closedir(dir);
+}
+
+void atribuir_uso_descendiente(const char *ruta, pid_t pid, struct rusage *usage, double wall_time, int status)
+{
+    int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    struct rusage *destino_usage = NULL;
+    ProcesoStats *destino = NULL;
+    double *destino_time = NULL;
+    pid_t *destino_pid = NULL;
+
+    if (strstr(ruta, "proceso2"))
+    {
+        destino_usage = &usage_p2, destino = &p2_full_stats, destino_time = &time_p2, destino_pid = &pid_p2;
+    }
+    else if (strstr(ruta, "proceso3"))
+    {
+        destino_usage = &usage_p3, destino = &p3_full_stats, destino_time = &time_p3, destino_pid = &pid_p3;
+    }
+    else if (strstr(ruta, "proceso1"))
+    {
+        destino_usage = &usage_p1, destino = &p1_full_stats, destino_time = &time_p1, destino_pid = &pid_p1;
+    }
+
+    if (destino == NULL)
+    {
+        registro_descendientes.sin_identificar++;
+        sumar_rusage(&registro_descendientes.uso_otros, usage);
+        return;
+    }
+
+    sumar_rusage(destino_usage, usage);
+    *destino_time += wall_time;
+    *destino_pid = pid;
+    copiar_rusage_a_stats(destino_usage, *destino_time, destino, exit_code);
+    registrar_metricas_clasicas(destino, wall_time);
+    destino->instancias++;
+    publicar_estado_proceso(slot_telemetria(destino), pid, TEL_TERMINADO, 0.0);
+}
+
+void cerrar_descendiente(Descendiente *d, struct rusage *usage, int status)
+{
+    if (!timerisset(&d->fin))
+        gettimeofday(&d->fin, NULL);
+
+    d->activo = 0;
+    close(d->pidfd);
+    d->pidfd = -1;
+
+    /* Lo que este proceso recogió de sus hijos ya fue atribuido a esos hijos. */
+    restar_rusage(usage, &d->absorbido);
+
+    if (d->ppid == getpid())
+        return;
+
+    atribuir_uso_descendiente(d->ruta, d->pid, usage, timeval_diff(&d->inicio, &d->fin), status);
+}
+
+void sondear_descendientes()
+{
+    if (!registro_descendientes.activo)
+        return;
+
+    double ahora = tiempo_monotonico();
+    if (ahora - registro_descendientes.ultimo_sondeo < INTERVALO_DESCENDIENTES_MS / 1000.0)
+        return;
+    registro_descendientes.ultimo_sondeo = ahora;
+
+    for (int i = 0; i < registro_descendientes.num_descendientes; i++)
+    {
+        Descendiente *d = &registro_descendientes.lista[i];
+        if (!d->activo)
+            continue;
+
+        struct pollfd pfd = {.fd = d->pidfd, .events = POLLIN};
+        if (poll(&pfd, 1, 0) <= 0)
+        {
+            leer_uso_proc(d->pid, &d->instantanea);
+            if (d->ppid != getpid())
+                leer_ruta_huesped(d->pid, d->ruta, sizeof(d->ruta));
+            publicar_estado_proceso(slot_telemetria_por_nombre(d->ruta), d->pid, TEL_EJECUTANDO, 0.0);
+            descubrir_hijos_de(d->pid);
+            continue;
+        }
+
+        /* Terminó: si ya es hijo nuestro (huérfano adoptado) lo recogemos con su rusage exacto. */
+        if (d->ppid == getpid())
+            continue;
+
+        if (!timerisset(&d->fin))
+            gettimeofday(&d->fin, NULL);
+
+        int status = 0;
+        struct rusage usage;
+        pid_t r = wait4(d->pid, &status, WNOHANG, &usage);
+        if (r == d->pid)
+        {
+            registro_descendientes.reapeados_kernel++;
+            cerrar_descendiente(d, &usage, status);
+        }
+        else if (r == -1 && errno == ECHILD && !pidfd_sigue_existiendo(d->pidfd))
+        {
+            /* Lo recogió su padre: su uso quedó sumado al del padre. */
+            Descendiente *padre = buscar_descendiente(d->ppid);
+            if (padre)
+                sumar_rusage(&padre->absorbido, &d->instantanea);
+            registro_descendientes.reapeados_padre++;
+            usage = d->instantanea;
+            cerrar_descendiente(d, &usage, 0);
+        }
+    }
+}
+
+int descendientes_activos()
+{
+    int activos = 0;
+    for (int i = 0; i < registro_descendientes.num_descendientes; i++)
+        if (registro_descendientes.lista[i].activo && registro_descendientes.lista[i].ppid != getpid())
+            activos++;
+    return activos;
+}
+
+void finalizar_seguimiento_descendientes()
+{
+    if (!registro_descendientes.activo)
+        return;
+
+    for (int restante = TIMEOUT_DESCENDIENTES * 1000; restante > 0 && descendientes_activos() > 0; restante -= INTERVALO_DESCENDIENTES_MS)
+    {
+        muestrear_latencias();
+        sondear_descendientes();
+        atender_canales();
+        usleep(INTERVALO_DESCENDIENTES_MS * 1000);
+    }
+
+    for (int i = 0; i < registro_descendientes.num_descendientes; i++)
+    {
+        Descendiente *d = &registro_descendientes.lista[i];
+        if (!d->activo || d->ppid == getpid())
+            continue;
+
+        int status = 0;
+        struct rusage usage;
+        printf(COLOR_ERROR "[Control Central] ALERTA: " ANSI_RESET "Descendiente %s (PID %d) no terminó. Forzando terminación (SIGKILL)...\n",
+               d->ruta[0] ? d->ruta : "desconocido", d->pid);
+        kill(d->pid, SIGKILL);
+        if (wait4(d->pid, &status, 0, &usage) == d->pid)
+        {
+            registro_descendientes.reapeados_kernel++;
+            cerrar_descendiente(d, &usage, status);
+        }
+        else
+        {
+            usage = d->instantanea;
+            cerrar_descendiente(d, &usage, 0);
+        }
+    }
+
+    /* Huérfanos adoptados que nunca llegamos a ver vivos: se miran con WNOWAIT antes de
+       recogerlos para atribuirlos por su comm; los que no se reconocen van a "otros". */
+    siginfo_t info;
+    memset(&info, 0, sizeof(info));
+    while (waitid(P_ALL, 0, &info, WEXITED | WNOHANG | WNOWAIT) == 0 && info.si_pid > 0)
+    {
+        pid_t huerfano = info.si_pid;
+        char ruta[256] = "";
+        double vivido;
+        int status;
+        struct rusage usage;
+
+        identificar_zombi(huerfano, ruta, sizeof(ruta), &vivido);
+        if (wait4(huerfano, &status, 0, &usage) != huerfano)
+            break;
+        registro_descendientes.reapeados_kernel++;
+        atribuir_uso_descendiente(ruta, huerfano, &usage, vivido, status);
+        memset(&info, 0, sizeof(info));
+    }
+
+    const struct rusage *otros = &registro_descendientes.uso_otros;
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Descendientes rastreados: %d (recogidos por el kernel: %d, por su padre: %d, sin identificar: %d, CPU de los sin identificar: %.6f s usuario + %.6f s sistema).\n",
+           registro_descendientes.num_descendientes - 1, registro_descendientes.reapeados_kernel,
+           registro_descendientes.reapeados_padre, registro_descendientes.sin_identificar,
+           otros->ru_utime.tv_sec + otros->ru_utime.tv_usec / 1e6, otros->ru_stime.tv_sec + otros->ru_stime.tv_usec / 1e6);
+
+    registro_descendientes.activo = 0;
+}
+
+void descontar_uso_absorbido(pid_t pid, struct rusage *usage)
+{
+    Descendiente *d = buscar_descendiente(pid);
+    if (d)
+    {
+        restar_rusage(usage, &d->absorbido);
+        if (d->pidfd >= 0)
+            close(d->pidfd);
+        d->pidfd = -1;
+        d->activo = 0;
+    }
+}
+
+pid_t esperar_hijo_muestreando(pid_t pid, int *status, struct rusage *usage)
+{
+    pid_t terminado;
+
+    while ((terminado = sondear_hijo(pid, status, usage)) == 0)
+    {
+        muestrear_latencias();
+        sondear_descendientes();
+        atender_canales();
+        usleep(INTERVALO_MUESTREO_US);
+    }
+
+    muestrear_latencias();
+    return terminado;
+}
+
+void dormir_hasta(double instante)
+{
+    if (backend_es == BACKEND_ES_URING)
+    {
+        dormir_hasta_uring(instante);
+        return;
+    }
+
+    struct timespec objetivo;
+    objetivo.tv_sec = (time_t)instante;
+    objetivo.tv_nsec = (long)((instante - objetivo.tv_sec) * 1000000000.0);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &objetivo, NULL) == EINTR)
+        ;
+}
+
+/* Duerme en pasos de INTERVALO_MUESTREO_US con plazos absolutos, de modo que el último
+   paso termina exactamente en 'fin' y no acumula el retraso de cada usleep. */
+void dormir_muestreando_hasta(double fin)
+{
+    double ahora;
+
+    while ((ahora = tiempo_monotonico()) < fin)
+    {
+        muestrear_latencias();
+        atender_canales();
+        double paso = ahora + INTERVALO_MUESTREO_US / 1000000.0;
+        dormir_hasta(paso < fin ? paso : fin);
+    }
+}
+
+void dormir_muestreando(double segundos)
+{
+    dormir_muestreando_hasta(tiempo_monotonico() + segundos);
+}
+
+void registrar_sobrepaso_quantum(double fin_previsto)
+{
+    if (escenario_actual >= 1 && escenario_actual <= 4)
+        registrar_estadistica(&estadisticas_escenario[escenario_actual].sobrepaso_quantum,
+                              tiempo_monotonico() - fin_previsto);
+}
+
+void dormir_quantum(double segundos)
+{
+    double inicio = tiempo_monotonico();
+    double fin = inicio + segundos;
+    dormir_muestreando_hasta(fin);
+    registrar_sobrepaso_quantum(fin);
+    trazar_evento(EVENTO_QUANTUM, getpid(), PISTA_KERNEL, inicio, tiempo_monotonico() - inicio, 0);
+}
+
+void print_fila_tabla(const char *nombre, pid_t pid, double wall_time, struct rusage *usage)
+{
+    printf("%s| %-20s | %-7d | %-11.6f | %ld.%06ld s | %ld.%06ld s | %-15ld |" ANSI_RESET "\n",
+           color_proceso(nombre),
+           nombre_legible(nombre), pid,
+           wall_time,
+           usage->ru_utime.tv_sec, usage->ru_utime.tv_usec,
+           usage->ru_stime.tv_sec, usage->ru_stime.tv_usec,
+           usage->ru_maxrss);
+}
+
+void mostrar_tabla_recursos()
+{
+    FASE_KERNEL(FASE_TABLA_RECURSOS);
+    printf(COLOR_TABLE "\n--- Resumen de Recursos del Ciclo ---\n");
+    printf("| Proceso              | PID     | T. Real (s) | CPU Usuario | CPU Sistema | Memoria Pico (KB) |\n");
+    printf("|----------------------|---------|-------------|-------------|-------------|-------------------|\n" ANSI_RESET);
+
+    if (pid_p1 > 0)
+        print_fila_tabla("./proceso1", pid_p1, time_p1, &usage_p1);
+    if (pid_p2 > 0)
+        print_fila_tabla("./proceso2", pid_p2, time_p2, &usage_p2);
+    if (pid_p3 > 0)
+        print_fila_tabla("./proceso3", pid_p3, time_p3, &usage_p3);
+
+    printf(COLOR_TABLE "|----------------------|---------|-------------|-------------|-------------|-------------------|\n" ANSI_RESET);
+    fflush(stdout);
+}
+
+void mostrar_metricas_extra(ProcesoStats *stats)
+{
+    FASE_KERNEL(FASE_INFORME_CONSOLA);
+    if (stats->time_real == 0.0)
+        return;
+
+    printf(COLOR_TABLE "\n  [METRICAS AVANZADAS]\n");
+    printf("  - T. Ejecución Efectiva (CPU): %.6f s\n", stats->tiempo_ejecucion_efectiva);
+    printf("  - Cambios de Contexto (Vol/Inv): %d / %d\n", stats->cambios_contexto_voluntario, stats->cambios_contexto_involuntario);
+
+    if (stats->num_pausas > 0)
+    {
+        printf("  - Pausas Totales: %d\n", stats->num_pausas);
+        printf("  - T. Pausado Total (Wall): %.6f s\n", stats->tiempo_pausado_total);
+        printf("  - Quantum Dado/Usado: %.2f s / %.2f s\n", stats->quantum_dado_total, stats->quantum_usado_total);
+    }
+
+    if (stats->instancias > 0)
+        printf("  - Instancias (descendientes agregados): %d\n", stats->instancias);
+
+    if (stats->turnos_omitidos > 0 || stats->turnos_acortados > 0)
+        printf("  - Turnos Omitidos/Acortados (datos): %d / %d (%.2f s de quantum ocioso evitados)\n",
+               stats->turnos_omitidos, stats->turnos_acortados, stats->tiempo_ocioso_evitado);
+
+    if (stats->edf_activaciones > 0)
+    {
+        int cumplidos = stats->edf_activaciones - stats->edf_plazos_perdidos;
+        printf("  - Activaciones EDF: %d (Plazos perdidos: %d)\n", stats->edf_activaciones, stats->edf_plazos_perdidos);
+        if (stats->edf_plazos_perdidos > 0)
+            printf("  - Retraso Máx/Medio: %.6f s / %.6f s\n", stats->edf_retraso_max,
+                   stats->edf_retraso_total / stats->edf_plazos_perdidos);
+        if (cumplidos > 0)
+            printf("  - Holgura Mín/Media: %.6f s / %.6f s\n", stats->edf_holgura_min,
+                   stats->edf_holgura_total / cumplidos);
+    }
+
+    const char *estado;
+    if (WIFEXITED(stats->exit_status))
+        estado = "TERMINADO_EXIT";
+    else if (WIFSIGNALED(stats->exit_status))
+        estado = "TERMINADO_SENAL";
+    else
+        estado = "NO_TERMINADO";
+
+    printf("  - Estado Final: %s (Status: %d)\n" ANSI_RESET, estado, stats->exit_status);
+}
+
+void esperar_proceso(pid_t pid, const char *nombre_proceso, int timeout_sec, struct timeval *start_time)
+{
+    int status;
+    struct rusage usage;
+    struct timeval end_time;
+    double wall_time = 0.0;
+    int kill_signal = 0;
+
+    publicar_estado_proceso(slot_telemetria_por_nombre(nombre_proceso), pid, TEL_EJECUTANDO, 0.0);
+
+    if (timeout_sec > 0)
+    {
+        for (int remaining = timeout_sec; remaining > 0; remaining--)
+        {
+            pid_t terminado = sondear_hijo(pid, &status, &usage);
+            if (terminado == pid)
+            {
+                gettimeofday(&end_time, NULL);
+                wall_time = timeval_diff(start_time, &end_time);
+                proceso_terminado(nombre_proceso, pid);
+                goto guardar_stats;
+            }
+            sleep(1);
+        }
+
+        printf(COLOR_ERROR "[Control Central] ALERTA: " ANSI_RESET "%s%s (PID %d) no responde. Forzando terminación (SIGKILL)..." ANSI_RESET "\n",
+               color_proceso(nombre_proceso), nombre_legible(nombre_proceso), pid);
+        kill(pid, SIGKILL);
+        kill_signal = SIGKILL;
+        esperar_hijo_muestreando(pid, &status, &usage);
+        gettimeofday(&end_time, NULL);
+        wall_time = timeval_diff(start_time, &end_time);
+        proceso_terminado(nombre_proceso, pid);
+    }
+    {
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Esperando finalización de %s%s (PID %d)..." ANSI_RESET "\n",
+               color_proceso(nombre_proceso), nombre_legible(nombre_proceso), pid);
+        fflush(stdout);
+
+        esperar_hijo_muestreando(pid, &status, &usage);
+
+        gettimeofday(&end_time, NULL);
+        wall_time = timeval_diff(start_time, &end_time);
+
+        fflush(stdout);
+        proceso_terminado(nombre_proceso, pid);
+    }
+
+guardar_stats:
+    guardar_stats_proceso(nombre_proceso, pid, wall_time, &usage, status);
+
+    if (strstr(nombre_proceso, "proceso1"))
+        p1_full_stats.seniales_recibidas[kill_signal]++;
+    if (strstr(nombre_proceso, "proceso2"))
+        p2_full_stats.seniales_recibidas[kill_signal]++;
+    if (strstr(nombre_proceso, "proceso3"))
+        p3_full_stats.seniales_recibidas[kill_signal]++;
+
+    if (escenario_actual == 1)
+    {
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Mostrando métricas adicionales para %s%s:\n",
+               color_proceso(nombre_proceso), nombre_legible(nombre_proceso));
+        if (strstr(nombre_proceso, "proceso1"))
+            mostrar_metricas_extra(&p1_full_stats);
+        if (strstr(nombre_proceso, "proceso2"))
+            mostrar_metricas_extra(&p2_full_stats);
+        if (strstr(nombre_proceso, "proceso3"))
+            mostrar_metricas_extra(&p3_full_stats);
+    }
+}
+
+static uint32_t *arenas_traza_rt[2];
+static unsigned long *inicios_traza_rt[2];
+
+void preasignar_memoria_rt()
+{
+    /* Sin devolver memoria al sistema ni usar mmap para bloques grandes: cada malloc
+       posterior sale de memoria ya residente y bloqueada. */
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    volatile char pila[PILA_PREASIGNADA_RT];
+    memset((char *)pila, 0, sizeof(pila));
+
+    for (int i = 0; i < 2; i++)
+    {
+        size_t tam_arena = (size_t)estados_anillo_traza * PALABRAS_MEDIAS_ESTADO_TRAZA + RANURAS_ESTADO_TRAZA + 1;
+        arenas_traza_rt[i] = malloc(tam_arena * sizeof(uint32_t));
+        inicios_traza_rt[i] = malloc(estados_anillo_traza * sizeof(unsigned long));
+        if (!arenas_traza_rt[i] || !inicios_traza_rt[i])
+        {
+            perror("malloc");
+            exit(1);
+        }
+        memset(arenas_traza_rt[i], 0, tam_arena * sizeof(uint32_t));
+        memset(inicios_traza_rt[i], 0, estados_anillo_traza * sizeof(unsigned long));
+    }
+}
+
+void iniciar_modo_rt()
+{
+    cpu_set_t disponibles;
+    CPU_ZERO(&disponibles);
+    sched_getaffinity(0, sizeof(disponibles), &disponibles);
+    nucleos_huespedes = disponibles;
+
+    if (CPU_COUNT(&disponibles) >= 2)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &disponibles))
+                nucleo_rt = cpu;
+
+        cpu_set_t reservado;
+        CPU_ZERO(&reservado);
+        CPU_SET(nucleo_rt, &reservado);
+        CPU_CLR(nucleo_rt, &nucleos_huespedes);
+        if (sched_setaffinity(0, sizeof(reservado), &reservado) == -1)
+        {
+            perror(COLOR_ERROR "sched_setaffinity" ANSI_RESET);
+            nucleo_rt = -1;
+            nucleos_huespedes = disponibles;
+        }
+    }
+    else
+    {
+        printf(COLOR_ERROR "[Centro de Control] AVISO: " ANSI_RESET "Un solo núcleo disponible: planificador y huéspedes lo compartirán.\n");
+    }
+
+    /* SCHED_RESET_ON_FORK: los hijos (huéspedes e hilos lectores) vuelven a SCHED_OTHER. */
+    struct sched_param parametros = {.sched_priority = PRIORIDAD_RT};
+    if (sched_setscheduler(0, SCHED_FIFO | SCHED_RESET_ON_FORK, &parametros) == -1)
+        printf(COLOR_ERROR "[Centro de Control] AVISO: " ANSI_RESET "Sin privilegios para SCHED_FIFO (%s). Se continúa en SCHED_OTHER.\n", strerror(errno));
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == -1)
+        printf(COLOR_ERROR "[Centro de Control] AVISO: " ANSI_RESET "mlockall falló (%s). La memoria del planificador puede paginarse.\n", strerror(errno));
+
+    preasignar_memoria_rt();
+
+    printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Modo RT: planificador %s en el núcleo %d, huéspedes en %d núcleo(s).\n",
+           (sched_getscheduler(0) & ~SCHED_RESET_ON_FORK) == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_OTHER", nucleo_rt, CPU_COUNT(&nucleos_huespedes));
+}
+
+/* Se calcula en el padre. Un huésped que se quedaría solo con el núcleo reservado del
+   planificador pasa a los de huéspedes. Devuelve 0 si no hay que tocarla. */
+int afinidad_huesped(int nucleo, cpu_set_t *mascara)
+{
+    int fijar = 0;
+    if (nucleo >= 0)
+    {
+        CPU_ZERO(mascara);
+        CPU_SET(nucleo, mascara);
+        fijar = 1;
+    }
+    else if (nucleo_rt < 0 || sched_getaffinity(0, sizeof(cpu_set_t), mascara) == -1)
+        return 0;
+
+    if (nucleo_rt >= 0 && CPU_COUNT(mascara) == 1 && CPU_ISSET(nucleo_rt, mascara))
+    {
+        *mascara = nucleos_huespedes;
+        fijar = 1;
+    }
+    return fijar;
+}
+
+/* Ruta de qemu-riscv32 en el PATH, resuelta una vez en el padre: el hijo hace execve. */
+const char *ruta_qemu()
+{
+    static char ruta[PATH_MAX];
+    if (ruta[0])
+        return ruta;
+
+    const char *path = getenv("PATH");
+    while (path && *path)
+    {
+        size_t largo = strcspn(path, ":");
+        snprintf(ruta, sizeof(ruta), "%.*s/qemu-riscv32", (int)largo, path);
+        if (largo > 0 && access(ruta, X_OK) == 0)
+            return ruta;
+        path += largo + (path[largo] == ':');
+    }
+    snprintf(ruta, sizeof(ruta), "qemu-riscv32");
+    return ruta;
+}
+
+void trazar_lanzamiento(char *const argv[], pid_t pid, double instante)
+{
+    int slot = -1, argumento = -1;
+    for (int i = 1; argv[i] && slot < 0; i++)
+    {
+        slot = slot_telemetria_por_nombre(argv[i]);
+        if (slot >= 0 && argv[i + 1] && isdigit((unsigned char)argv[i + 1][0]))
+            argumento = atoi(argv[i + 1]);
+    }
+    trazar_evento(EVENTO_LANZAMIENTO, pid, slot + 1, instante, 0.0, argumento);
+}
+
+/* ---- Lanzamiento de huéspedes ----
+   clone(CLONE_VM | CLONE_VFORK) como posix_spawn: no se copian las tablas de páginas del
+   kernel y clone vuelve cuando el hijo ya hizo exec. Un huésped retenido no puede
+   compartir memoria mientras espera, así que se clona sin CLONE_VM y con su pidfd. */
+
+typedef struct
+{
+    char *const *argv;
+    const ArranqueHuesped *arranque;
+    int fd_compuerta;
+    sigset_t mascara;
+    const char *ruta_qemu;
+    int fijar_afinidad;
+    cpu_set_t afinidad;
+} ContextoLanzamiento;
+
+#define MENSAJE_FALLO_AFINIDAD COLOR_ERROR "sched_setaffinity: no se pudo fijar el núcleo del huésped\n" ANSI_RESET
+#define MENSAJE_FALLO_EXEC COLOR_ERROR "Error al iniciar componente de software: execve de qemu-riscv32 falló\n" ANSI_RESET
+
+/* Corre en el hijo antes del exec, con la memoria del kernel si no está retenido: solo
+   llamadas al sistema sobre datos que el padre dejó preparados (nada de stdio, malloc
+   ni estructuras del kernel). Ningún resultado se lee de errno; lo que escriban en él
+   los envoltorios al fallar lo descarta el padre al volver de clone. */
+int arrancar_huesped(void *arg)
+{
+    ContextoLanzamiento *c = arg;
+    const ArranqueHuesped *a = c->arranque;
+
+    if (a->entrada >= 0)
+        dup2(a->entrada, STDIN_FILENO);
+    if (a->salida >= 0)
+        dup2(a->salida, STDOUT_FILENO);
+    if (c->fijar_afinidad && sched_setaffinity(0, sizeof(cpu_set_t), &c->afinidad) == -1)
+        write(STDERR_FILENO, MENSAJE_FALLO_AFINIDAD, sizeof(MENSAJE_FALLO_AFINIDAD) - 1);
+
+    /* Solo conserva stdin, stdout, stderr y la compuerta (en el 3, O_CLOEXEC). */
+    int primero_libre = 3;
+    if (c->fd_compuerta >= 0)
+    {
+        dup3(c->fd_compuerta, 3, O_CLOEXEC);
+        primero_libre = 4;
+    }
+#ifdef SYS_close_range
+    if (syscall(SYS_close_range, primero_libre, ~0U, 0) == -1)
+#endif
+        for (int fd = primero_libre; fd < 1024; fd++)
+            close(fd);
+
+    if (c->fd_compuerta >= 0)
+    {
+        char senial;
+        if (read(3, &senial, 1) != 1)
+            _exit(0);
+    }
+
+    sigprocmask(SIG_SETMASK, &c->mascara, NULL);
+    execve(c->ruta_qemu, c->argv, environ);
+    write(STDERR_FILENO, MENSAJE_FALLO_EXEC, sizeof(MENSAJE_FALLO_EXEC) - 1);
+    _exit(1);
+}
+
+/* Devuelve -1 con errno si no pudo crear al huésped; no deja nada a medias. */
+pid_t intentar_lanzar_huesped(char *const argv[], const ArranqueHuesped *arranque, ProcesoStats *stats)
+{
+    FASE_KERNEL(FASE_LANZAMIENTO);
+    static char pila[TAM_PILA_LANZAMIENTO] __attribute__((aligned(16)));
+    ContextoLanzamiento contexto = {.argv = argv, .arranque = arranque, .fd_compuerta = -1, .ruta_qemu = ruta_qemu()};
+    int compuerta[2] = {-1, -1};
+    int pidfd = -1;
+    int flags = SIGCHLD | CLONE_VM | CLONE_VFORK;
+    TramoKernel previo = entrar_tramo(TRAMO_LANZAMIENTO);
+
+    char *argv_perfil[MAX_ARGV_PERFIL];
+    char ruta_socket[TAM_RUTA_SOCKET_GDB];
+    int programa_perfil = -1;
+    if (periodo_perfil_ms > 0 &&
+        (programa_perfil = preparar_argv_perfil(argv, argv_perfil, ruta_socket, sizeof(ruta_socket))) >= 0)
+        contexto.argv = argv_perfil;
+
+    if (arranque->retenido)
+    {
+        purgar_retenidos();
+        if (num_huespedes_retenidos == MAX_HUESPEDES_RETENIDOS)
+            errno = EAGAIN;
+        if (num_huespedes_retenidos == MAX_HUESPEDES_RETENIDOS ||
+            socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, compuerta) == -1)
+        {
+            salir_tramo(previo);
+            return -1;
+        }
+        contexto.fd_compuerta = compuerta[1];
+        flags = SIGCHLD | CLONE_PIDFD;
+    }
+
+    contexto.fijar_afinidad = afinidad_huesped(arranque->nucleo, &contexto.afinidad);
+
+    /* Sin señales en el hijo hasta el exec: sus manejadores escribirían en la memoria
+       del kernel. */
+    sigset_t todas;
+    sigfillset(&todas);
+    sigprocmask(SIG_SETMASK, &todas, &contexto.mascara);
+
+    double llegada = tiempo_monotonico();
+    int errno_previo = errno;
+    pid_t pid = clone(arrancar_huesped, pila + sizeof(pila), flags, &contexto, &pidfd);
+    double lanzado = tiempo_monotonico();
+    if (pid != -1)
+        errno = errno_previo;
+
+    sigprocmask(SIG_SETMASK, &contexto.mascara, NULL);
+    if (pid == -1)
+    {
+        int error = errno;
+        if (arranque->retenido)
+        {
+            close(compuerta[0]);
+            close(compuerta[1]);
+        }
+        if (programa_perfil >= 0)
+            unlink(ruta_socket);
+        salir_tramo(previo);
+        errno = error;
+        return -1;
+    }
+
+    trazar_lanzamiento(contexto.argv, pid, llegada);
+    if (programa_perfil >= 0)
+        registrar_huesped_perfil(pid, ruta_socket, programa_perfil);
+    if (!arranque->retenido)
+        marcar_huesped_corriendo(slot_telemetria(stats), 1);
+
+    if (arranque->retenido)
+    {
+        close(compuerta[1]);
+        huespedes_retenidos[num_huespedes_retenidos++] = (HuespedRetenido){.pid = pid, .pidfd = pidfd, .fd_compuerta = compuerta[0]};
+    }
+
+    if (escenario_actual >= 1 && escenario_actual <= 4)
+        registrar_estadistica(&estadisticas_escenario[escenario_actual].lanzamiento, lanzado - llegada);
+
+    if (stats)
+    {
+        stats->instante_llegada = llegada;
+        stats->instante_primera_ejecucion = 0.0;
+        stats->instante_parada = 0.0;
+    }
+    salir_tramo(previo);
+    return pid;
+}
+
+pid_t lanzar_huesped(char *const argv[], const ArranqueHuesped *arranque, ProcesoStats *stats)
+{
+    pid_t pid = intentar_lanzar_huesped(argv, arranque, stats);
+    if (pid == -1)
+    {
+        perror("Error lanzando el huésped");
+        exit(1);
+    }
+    return pid;
+}
+
+/* Cada línea que emite P3 es un registro. Su número de secuencia es su posición en
+   medidas.txt, que el kernel conoce porque es quien alimenta a P1: un valor que aparece
+   más adelante en la ventana delata registros perdidos, y uno que no encaja en ella, un
+   registro fuera de orden. */
+void registrar_registro_p3(int valor)
+{
+    ResumenLatencia *resumen = &resumen_latencia_ciclo;
+    int esperado = traza_lecturas.siguiente_registro_p3;
+
+    resumen->registros_p3++;
+    for (int i = esperado; i < traza_lecturas.num_lecturas && i < esperado + VENTANA_REGISTROS_P3; i++)
+    {
+        if (traza_lecturas.lecturas[i].valor == valor)
+        {
+            resumen->registros_perdidos += i - esperado;
+            traza_lecturas.siguiente_registro_p3 = i + 1;
+            return;
+        }
+    }
+    if (traza_lecturas.num_lecturas > 0)
+        resumen->registros_fuera_de_orden++;
+}
+
+int valor_registro_p3(const char *registro)
+{
+    int valor = 0;
+    for (; *registro; registro++)
+        if (isdigit((unsigned char)*registro))
+            valor = valor * 10 + (*registro - '0');
+    return valor;
+}
+
+/* Cierra el registro en curso; uno truncado se descarta y el hueco lo contará el siguiente. */
+int cerrar_registro_p3(int *valor, char *analisis, size_t tam_analisis, size_t *largo_analisis)
+{
+    int valido = !traza_lecturas.registro_p3_truncado;
+
+    traza_lecturas.registro_p3[traza_lecturas.largo_registro_p3] = '\0';
+    if (valido)
+    {
+        *valor = valor_registro_p3(traza_lecturas.registro_p3);
+        registrar_registro_p3(*valor);
+        if (*largo_analisis < tam_analisis - MAX_REGISTRO_P3)
+            *largo_analisis += snprintf(analisis + *largo_analisis, tam_analisis - *largo_analisis, "%s%s",
+                                        *largo_analisis ? " " : "", traza_lecturas.registro_p3);
+    }
+    traza_lecturas.largo_registro_p3 = 0;
+    traza_lecturas.registro_p3_truncado = 0;
+    return valido;
+}
+
+/* Un registro partido entre dos lecturas se completa en la siguiente. */
+int leer_datos_p3(int pipe_fd, int *valor)
+{
+    FASE_KERNEL(FASE_LECTURA_P3);
+    char buffer[4096];
+    char analisis[256] = "";
+    size_t largo_analisis = 0;
+    int registros = 0;
+    ssize_t bytes;
+    TramoKernel previo = entrar_tramo(TRAMO_TUBERIA);
+    double inicio = tiempo_monotonico();
+
+    while ((bytes = leer_es(pipe_fd, buffer, sizeof(buffer))) > 0)
+    {
+        traza_lecturas.bytes_recibidos_p3 += bytes;
+        muestrear_latencias();
+
+        for (ssize_t i = 0; i < bytes; i++)
+        {
+            if (buffer[i] == '\n')
+                registros += cerrar_registro_p3(valor, analisis, sizeof(analisis), &largo_analisis);
+            else if (traza_lecturas.largo_registro_p3 < MAX_REGISTRO_P3 - 1)
+                traza_lecturas.registro_p3[traza_lecturas.largo_registro_p3++] = buffer[i];
+            else
+                traza_lecturas.registro_p3_truncado = 1;
+        }
+    }
+
+    if (bytes == 0 && traza_lecturas.largo_registro_p3 > 0)
+        registros += cerrar_registro_p3(valor, analisis, sizeof(analisis), &largo_analisis);
+
+    if (registros > 0)
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Análisis recibido de %s%s" COLOR_KERNEL ": [%s%s] (%d registro%s)" ANSI_RESET "\n",
+               color_proceso("./proceso3"), nombre_legible("./proceso3"), analisis,
+               largo_analisis >= sizeof(analisis) - MAX_REGISTRO_P3 ? " ..." : "", registros, registros == 1 ? "" : "s");
+
+    trazar_evento(EVENTO_LECTURA_P3, getpid(), PISTA_KERNEL, inicio, tiempo_monotonico() - inicio, registros);
+    salir_tramo(previo);
+    return registros;
+}
+
+/* El archivo completo sale en una sola escritura, tras la cual se cierra el extremo de
+   escritura del pipe; cada lectura queda registrada con su posición en el flujo antes de
+   escribir, para que P1 no pueda consumirla sin fecha. */
+void enviar_contenido_archivo_a_pipe(int pipe_fd_escritura, const char *archivo)
+{
+    FASE_KERNEL(FASE_ALIMENTADOR);
+    TramoKernel previo = entrar_tramo(TRAMO_ALIMENTADOR);
+    FILE *fp = fopen(archivo, "r");
+    if (!fp)
+    {
+        fprintf(stderr, COLOR_ERROR "[Control Central] ERROR: No se puede abrir el archivo de señal %s\n" ANSI_RESET, archivo);
+        close(pipe_fd_escritura);
+        salir_tramo(previo);
+        return;
+    }
+
+    double inicio = tiempo_monotonico();
+    char *datos = NULL;
+    long largo = 0;
+    if (fseek(fp, 0, SEEK_END) == 0 && (largo = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0)
+    {
+        datos = malloc(largo);
+        if (datos)
+            largo = fread(datos, 1, largo, fp);
+    }
+    fclose(fp);
+    if (!datos)
+    {
+        close(pipe_fd_escritura);
+        salir_tramo(previo);
+        return;
+    }
+
+    int valor_linea = 0;
+    for (long i = 0; i < largo; i++)
+    {
+        if (isdigit((unsigned char)datos[i]))
+            valor_linea = valor_linea * 10 + (datos[i] - '0');
+        else if (datos[i] == '\n')
+        {
+            registrar_entrada_lectura(valor_linea, i + 1);
+            valor_linea = 0;
+        }
+    }
+
+    escribir_y_cerrar_es(pipe_fd_escritura, datos, largo, COLOR_ERROR "Error alimentando el pipe de P1" ANSI_RESET);
+    registrar_estadistica(&duracion_alimentador, tiempo_monotonico() - inicio);
+    salir_tramo(previo);
+}
+
+unsigned long obtener_pc_riscv(const char *ruta_log)
+{
+    FASE_KERNEL(FASE_ESCANEO_TRAZA);
+    char comando[256];
+
+    TramoKernel previo = entrar_tramo(TRAMO_TRAZAS);
+    double inicio = tiempo_monotonico();
+    snprintf(comando, sizeof(comando), "tail -n 200 %s", ruta_log);
+
+    FILE *fp = popen(comando, "r");
+    if (!fp)
+    {
+        salir_tramo(previo);
+        return 0;
+    }
+
+    char linea[256];
+    unsigned long ultimo_pc = 0;
+
+    while (fgets(linea, sizeof(linea), fp))
+    {
+
+        for (int i = 0; linea[i]; i++)
+            linea[i] = tolower(linea[i]);
+
+        char *ptr = linea;
+        while ((ptr = strstr(ptr, "pc")) != NULL)
+        {
+
+            int inicio_valido = (ptr == linea) || !isalnum(*(ptr - 1));
+
+            int fin_valido = !isalnum(*(ptr + 2));
+
+            if (inicio_valido && fin_valido)
+            {
+
+                char *num_ptr = ptr + 2;
+
+                while (*num_ptr && !isxdigit(*num_ptr))
+                    num_ptr++;
+
+                if (*num_ptr)
+                {
+                    ultimo_pc = strtoul(num_ptr, NULL, 16);
+                }
+            }
+
+            ptr += 2;
+        }
+    }
+
+    pclose(fp);
+    registrar_estadistica(&duracion_escaneo_traza, tiempo_monotonico() - inicio);
+    salir_tramo(previo);
+    return ultimo_pc;
+}
+
+/* ---- Captura de trazas acotada (escenario 2) ----
+   QEMU escribe su volcado -d cpu en un FIFO; un hilo lo drena y conserva solo los
+   últimos estados de registros en un anillo. Cada estado se guarda como diferencia
+   con el anterior: [máscara][valores de las ranuras que cambiaron], donde la ranura 0
+   es el PC y las ranuras 1..31 son x1..x31 (x0 siempre vale 0). */
+
+typedef struct
+{
+    const char *ruta_fifo;
+    const char *ruta_volcado;
+    int fd;
+    pthread_t hilo;
+    pthread_mutex_t cerrojo;
+    int detener;
+    int ultima_solicitud;
+
+    uint32_t *arena;
+    unsigned long tam_arena;
+    unsigned long cabeza;
+    unsigned long *inicio_estado;
+    int max_estados;
+    int primero;
+    int num_estados;
+
+    uint32_t base[RANURAS_ESTADO_TRAZA];
+    uint32_t ultimo[RANURAS_ESTADO_TRAZA];
+    uint32_t pendiente[RANURAS_ESTADO_TRAZA];
+    int hay_pendiente;
+
+    long estados_procesados;
+    long bytes_leidos;
+    long palabras_guardadas;
+} AnilloTraza;
+
+static volatile sig_atomic_t solicitudes_volcado_trazas = 0;
+
+void solicitar_volcado_trazas(int sig)
+{
+    (void)sig;
+    solicitudes_volcado_trazas++;
+}
+
+uint32_t palabra_arena(const AnilloTraza *a, unsigned long posicion)
+{
+    return a->arena[posicion % a->tam_arena];
+}
+
+void descartar_estado_antiguo(AnilloTraza *a)
+{
+    unsigned long pos = a->inicio_estado[a->primero];
+    uint32_t mascara = palabra_arena(a, pos++);
+    for (int r = 0; r < RANURAS_ESTADO_TRAZA; r++)
+        if (mascara & (1u << r))
+            a->base[r] = palabra_arena(a, pos++);
+
+    a->primero = (a->primero + 1) % a->max_estados;
+    a->num_estados--;
+}
+
+void guardar_estado_traza(AnilloTraza *a)
+{
+    uint32_t mascara = 0;
+    int cambios = 0;
+    for (int r = 0; r < RANURAS_ESTADO_TRAZA; r++)
+    {
+        if (a->pendiente[r] != a->ultimo[r])
+        {
+            mascara |= 1u << r;
+            cambios++;
+        }
+    }
+
+    unsigned long necesarias = 1 + cambios;
+    while (a->num_estados > 0 &&
+           (a->num_estados == a->max_estados || a->cabeza + necesarias - a->inicio_estado[a->primero] > a->tam_arena))
+        descartar_estado_antiguo(a);
+
+    int indice = (a->primero + a->num_estados) % a->max_estados;
+    a->inicio_estado[indice] = a->cabeza;
+    a->arena[a->cabeza++ % a->tam_arena] = mascara;
+    for (int r = 0; r < RANURAS_ESTADO_TRAZA; r++)
+        if (mascara & (1u << r))
+            a->arena[a->cabeza++ % a->tam_arena] = a->pendiente[r];
+
+    a->num_estados++;
+    a->estados_procesados++;
+    a->palabras_guardadas += necesarias;
+    memcpy(a->ultimo, a->pendiente, sizeof(a->ultimo));
+    a->hay_pendiente = 0;
+}
+
+void procesar_linea_traza(AnilloTraza *a, char *linea)
+{
+    char *guardado = NULL;
+    char *token = strtok_r(linea, " \t", &guardado);
+
+    while (token)
+    {
+        char *valor = strtok_r(NULL, " \t", &guardado);
+        if (!valor)
+            return;
+
+        int ranura = -1;
+        if (strcasecmp(token, "pc") == 0)
+        {
+            if (a->hay_pendiente)
+                guardar_estado_traza(a);
+            memcpy(a->pendiente, a->ultimo, sizeof(a->pendiente));
+            a->hay_pendiente = 1;
+            ranura = 0;
+        }
+        else if (token[0] == 'x' && isdigit((unsigned char)token[1]))
+        {
+            int registro = atoi(token + 1);
+            if (registro >= 1 && registro < RANURAS_ESTADO_TRAZA)
+                ranura = registro;
+        }
+
+        if (ranura >= 0 && a->hay_pendiente)
+        {
+            a->pendiente[ranura] = (uint32_t)strtoul(valor, NULL, 16);
+            token = strtok_r(NULL, " \t", &guardado);
+        }
+        else
+        {
+            token = valor;
+        }
+    }
+}
+
+void escribir_estado_traza(int fd, const uint32_t *estado)
+{
+    char buffer[1024];
+    int n = snprintf(buffer, sizeof(buffer), " pc       %08x\n x0       00000000", estado[0]);
+    for (int r = 1; r < RANURAS_ESTADO_TRAZA; r++)
+        n += snprintf(buffer + n, sizeof(buffer) - n, "%s x%-7d %08x", (r % 4 == 0) ? "\n" : "", r, estado[r]);
+    n += snprintf(buffer + n, sizeof(buffer) - n, "\n");
+    write(fd, buffer, n);
+}
+
+/* Solo usa snprintf/write para poder llamarse desde el hilo lector. */
+void volcar_anillo_traza(AnilloTraza *a)
+{
+    uint32_t estado[RANURAS_ESTADO_TRAZA];
+
+    pthread_mutex_lock(&a->cerrojo);
+    int fd = open(a->ruta_volcado, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd != -1)
+    {
+        memcpy(estado, a->base, sizeof(estado));
+        for (int i = 0; i < a->num_estados; i++)
+        {
+            unsigned long pos = a->inicio_estado[(a->primero + i) % a->max_estados];
+            uint32_t mascara = palabra_arena(a, pos++);
+            for (int r = 0; r < RANURAS_ESTADO_TRAZA; r++)
+                if (mascara & (1u << r))
+                    estado[r] = palabra_arena(a, pos++);
+            escribir_estado_traza(fd, estado);
+        }
+        if (a->hay_pendiente)
+            escribir_estado_traza(fd, a->pendiente);
+        close(fd);
+    }
+    pthread_mutex_unlock(&a->cerrojo);
+}
+
+void *drenar_fifo_traza(void *arg)
+{
+    AnilloTraza *a = arg;
+    char bloque[65536];
+    char linea[1024];
+    size_t largo_linea = 0;
+
+    if (nucleo_rt >= 0)
+    {
+        struct sched_param normal = {.sched_priority = 0};
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &normal);
+        pthread_setaffinity_np(pthread_self(), sizeof(nucleos_huespedes), &nucleos_huespedes);
+    }
+
+    while (1)
+    {
+        struct pollfd pfd = {.fd = a->fd, .events = POLLIN};
+        if (poll(&pfd, 1, 100) > 0)
+        {
+            ssize_t n = read(a->fd, bloque, sizeof(bloque));
+            if (n > 0)
+            {
+                pthread_mutex_lock(&a->cerrojo);
+                a->bytes_leidos += n;
+                for (ssize_t i = 0; i < n; i++)
+                {
+                    if (bloque[i] != '\n')
+                    {
+                        if (largo_linea < sizeof(linea) - 1)
+                            linea[largo_linea++] = bloque[i];
+                        continue;
+                    }
+                    linea[largo_linea] = '\0';
+                    procesar_linea_traza(a, linea);
+                    largo_linea = 0;
+                }
+                pthread_mutex_unlock(&a->cerrojo);
+                continue;
+            }
+        }
+
+        if (a->ultima_solicitud != solicitudes_volcado_trazas)
+        {
+            a->ultima_solicitud = solicitudes_volcado_trazas;
+            volcar_anillo_traza(a);
+        }
+
+        if (__atomic_load_n(&a->detener, __ATOMIC_ACQUIRE))
+            break;
+    }
+    return NULL;
+}
+
+/* El kernel abre el FIFO en lectura/escritura: así QEMU nunca se bloquea al abrirlo y
+   el hilo no ve EOF aunque el huésped termine; se detiene con 'detener'. */
+void iniciar_anillo_traza(AnilloTraza *a, const char *ruta_fifo, const char *ruta_volcado)
+{
+    memset(a, 0, sizeof(AnilloTraza));
+    a->ruta_fifo = ruta_fifo;
+    a->ruta_volcado = ruta_volcado;
+    a->max_estados = estados_anillo_traza;
+    /* Siempre cabe al menos un estado con todas las ranuras cambiadas. */
+    a->tam_arena = (unsigned long)estados_anillo_traza * PALABRAS_MEDIAS_ESTADO_TRAZA + RANURAS_ESTADO_TRAZA + 1;
+    if (modo_rt)
+    {
+        int ranura = strstr(ruta_fifo, "p3") ? 1 : 0;
+        a->arena = arenas_traza_rt[ranura];
+        a->inicio_estado = inicios_traza_rt[ranura];
+    }
+    else
+    {
+        a->arena = malloc(a->tam_arena * sizeof(uint32_t));
+        a->inicio_estado = malloc(a->max_estados * sizeof(unsigned long));
+    }
+    a->ultima_solicitud = solicitudes_volcado_trazas;
+
+    unlink(ruta_fifo);
+    if (!a->arena || !a->inicio_estado || mkfifo(ruta_fifo, 0600) == -1 ||
+        (a->fd = open(ruta_fifo, O_RDWR | O_NONBLOCK | O_CLOEXEC)) == -1)
+    {
+        perror("Error preparando el FIFO de trazas");
+        exit(1);
+    }
+
+    pthread_mutex_init(&a->cerrojo, NULL);
+    if (pthread_create(&a->hilo, NULL, drenar_fifo_traza, a) != 0)
+    {
+        perror("pthread_create");
+        exit(1);
+    }
+}
+
+void finalizar_anillo_traza(AnilloTraza *a, const char *nombre_proceso)
+{
+    FASE_KERNEL(FASE_ANILLO_TRAZA);
+    TramoKernel previo = entrar_tramo(TRAMO_TRAZAS);
+    __atomic_store_n(&a->detener, 1, __ATOMIC_RELEASE);
+    pthread_join(a->hilo, NULL);
+    if (a->hay_pendiente)
+        guardar_estado_traza(a);
+    volcar_anillo_traza(a);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Traza de %s%s" ANSI_RESET ": %ld estados (%.1f KB) drenados del FIFO, %d retenidos en %s (%.1f palabras/estado).\n",
+           color_proceso(nombre_proceso), nombre_legible(nombre_proceso), a->estados_procesados, a->bytes_leidos / 1024.0,
+           a->num_estados, a->ruta_volcado,
+           a->estados_procesados > 0 ? (double)a->palabras_guardadas / a->estados_procesados : 0.0);
+
+    close(a->fd);
+    unlink(a->ruta_fifo);
+    pthread_mutex_destroy(&a->cerrojo);
+    if (!modo_rt)
+    {
+        free(a->arena);
+        free(a->inicio_estado);
+    }
+    salir_tramo(previo);
+}
+
+/* La pareja del ciclo siguiente se lanza durante la pausa: cada emulador se detiene
+   bloqueado en su entrada, con medidas.txt ya en la tubería de P1. */
+
+typedef struct
+{
+    int lista;
+    int escenario;
+    pid_t pid1, pid3;
+    int fd_p1_a_p3;
+    int fd_p3_a_kernel;
+    int con_trazas;
+    AnilloTraza traza_p1, traza_p3;
+
+    /* Lecturas escritas al prelanzar; se registran al adoptar, con el instante de adopción. */
+    LecturaTrazada entradas[MAX_LECTURAS_TRAZADAS];
+    int num_entradas;
+} TuberiaHuespedes;
+
+static TuberiaHuespedes tuberia_huespedes;
+
+int escenario_prelanzable(int escenario)
+{
+    if (topologias[escenario])
+        return 0;
+    return (escenario == 2 && politica_actual != POLITICA_GANG && num_sensores == 0) ||
+           (escenario == 3 && (politica_actual == POLITICA_RR || politica_actual == POLITICA_DATOS));
+}
+
+/* El hijo ya hizo exec: su ejecutable ya no es el del kernel. Antes de eso aún conserva
+   copias de todas las tuberías del kernel. */
+int huesped_tras_exec(pid_t pid)
+{
+    char ruta[64], propio[PATH_MAX], ajeno[PATH_MAX];
+
+    snprintf(ruta, sizeof(ruta), "/proc/%d/exe", pid);
+    ssize_t largo_propio = readlink("/proc/self/exe", propio, sizeof(propio));
+    ssize_t largo_ajeno = readlink(ruta, ajeno, sizeof(ajeno));
+    return largo_ajeno > 0 && !(largo_ajeno == largo_propio && memcmp(propio, ajeno, largo_ajeno) == 0);
+}
+
+int huesped_bloqueado(pid_t pid)
+{
+    return huesped_tras_exec(pid) && estado_huesped(pid) == 'S';
+}
+
+void esperar_huespedes_bloqueados(pid_t pid1, pid_t pid3)
+{
+    double limite = tiempo_monotonico() + TIMEOUT_PRELANZAMIENTO;
+    while (!(huesped_bloqueado(pid1) && huesped_bloqueado(pid3)))
+    {
+        if (tiempo_monotonico() >= limite)
+        {
+            printf(COLOR_ERROR "[Control Central] AVISO: " ANSI_RESET "Los huéspedes prelanzados no se bloquearon en %.1f s; se detienen igualmente.\n",
+                   TIMEOUT_PRELANZAMIENTO);
+            return;
+        }
+        atender_canales();
+        usleep(1000);
+    }
+}
+
+/* El turno acaba en cuanto el huésped se duerme en su tubería sin nada que hacer, y se
+   omite el de quien sigue así: la CPU pasa al otro extremo. */
+
+/* fd_entrada/fd_salida son los duplicados de lectura que conserva el kernel de la stdin
+   y la stdout del huésped (-1 si no los tiene): con FIONREAD se sabe si hay datos. La
+   llamada en curso sale de /proc/<pid>/syscall; wchan sirve de respaldo. */
+MotivoOcio ocio_huesped(pid_t pid, int fd_entrada)
+{
+    char estado = estado_huesped(pid);
+    if (estado == 0 || estado == 'Z' || estado == 'X')
+        return OCIO_TERMINADO;
+    if (estado != 'S')
+        return OCIO_NINGUNO;
+
+    char ruta[64], linea[256] = "";
+    long llamada = -1;
+    unsigned long fd = 0;
+    FILE *fp;
+
+    snprintf(ruta, sizeof(ruta), "/proc/%d/syscall", pid);
+    if ((fp = fopen(ruta, "r")) != NULL)
+    {
+        if (fscanf(fp, "%ld %lx", &llamada, &fd) != 2)
+            llamada = -1;
+        fclose(fp);
+    }
+    if (llamada == -1)
+    {
+        snprintf(ruta, sizeof(ruta), "/proc/%d/wchan", pid);
+        if ((fp = fopen(ruta, "r")) != NULL)
+        {
+            if (!fgets(linea, sizeof(linea), fp))
+                linea[0] = '\0';
+            fclose(fp);
+        }
+        if (strstr(linea, "pipe_read"))
+            llamada = SYS_read, fd = STDIN_FILENO;
+        else if (strstr(linea, "pipe_write"))
+            llamada = SYS_write, fd = STDOUT_FILENO;
+    }
+
+    if (llamada == SYS_read && fd == STDIN_FILENO && bytes_pendientes(fd_entrada) == 0)
+        return OCIO_SIN_ENTRADA;
+    if (llamada == SYS_write && fd == STDOUT_FILENO)
+        return OCIO_SALIDA_LLENA;
+    return OCIO_NINGUNO;
+}
+
+MotivoOcio dormir_quantum_datos(double segundos, pid_t pid, int fd_entrada, ProcesoStats *stats)
+{
+    double inicio = tiempo_monotonico();
+    double fin = inicio + segundos;
+    double ahora;
+    MotivoOcio ocio = OCIO_NINGUNO;
+
+    while ((ahora = tiempo_monotonico()) < fin)
+    {
+        muestrear_latencias();
+        atender_canales();
+        double paso = ahora + INTERVALO_MUESTREO_US / 1000000.0;
+        dormir_hasta(paso < fin ? paso : fin);
+        if ((ocio = ocio_huesped(pid, fd_entrada)) != OCIO_NINGUNO)
+            break;
+    }
+
+    ahora = tiempo_monotonico();
+    if (ocio == OCIO_NINGUNO)
+    {
+        registrar_sobrepaso_quantum(fin);
+    }
+    else if (ahora < fin)
+    {
+        stats->turnos_acortados++;
+        stats->tiempo_ocioso_evitado += fin - ahora;
+    }
+    trazar_evento(EVENTO_QUANTUM, getpid(), PISTA_KERNEL, inicio, ahora - inicio, 0);
+    return ocio;
+}
+
+/* El huésped acabó su último turno ocioso y nada cambió desde entonces: sin datos nuevos
+   en su entrada o con la salida aún llena. El otro extremo tiene que estar vivo para
+   que la situación pueda cambiar; si no, el turno se da igual. */
+int turno_innecesario(MotivoOcio ocio, int fd_entrada, int fd_salida, int otro_extremo_vivo)
+{
+    if (politica_actual != POLITICA_DATOS || !otro_extremo_vivo)
+        return 0;
+    if (ocio == OCIO_SIN_ENTRADA)
+        return fd_entrada >= 0 && bytes_pendientes(fd_entrada) == 0;
+    if (ocio == OCIO_SALIDA_LLENA)
+        return fd_salida >= 0 && bytes_pendientes(fd_salida) >= fcntl(fd_salida, F_GETPIPE_SZ);
+    return 0;
+}
+
+void omitir_turno(const char *nombre, pid_t pid, ProcesoStats *stats, double quantum, MotivoOcio ocio)
+{
+    stats->turnos_omitidos++;
+    stats->tiempo_ocioso_evitado += quantum;
+    if (nivel_log >= NIVEL_LOG_NORMAL)
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Turno de %s%s (PID %d) omitido: %s.\n",
+               color_proceso(nombre), nombre_legible(nombre), pid,
+               ocio == OCIO_SIN_ENTRADA ? "sin datos en su entrada" : "su salida sigue llena");
+}
+
+void lanzar_tuberia_huespedes(TuberiaHuespedes *t, int escenario, int *fd_entrada)
+{
+    int p1_input_pipe[2], p1_to_p3_pipe[2], p3_to_kernel_pipe[2];
+
+    if (pipe(p1_input_pipe) == -1 || pipe(p1_to_p3_pipe) == -1 || pipe(p3_to_kernel_pipe) == -1)
+    {
+        perror("Error en pipes");
+        exit(1);
+    }
+    interponer_grifos(p1_to_p3_pipe, p3_to_kernel_pipe);
+
+    t->escenario = escenario;
+    t->con_trazas = (escenario == 2);
+    if (t->con_trazas)
+    {
+        iniciar_anillo_traza(&t->traza_p1, "p1_trace.fifo", "p1_trace.log");
+        iniciar_anillo_traza(&t->traza_p3, "p3_trace.fifo", "p3_trace.log");
+    }
+
+    char *argv1_trazas[] = {"qemu-riscv32", "-d", "cpu", "-D", "p1_trace.fifo", "./code/escenariosBasicos/proceso1", NULL};
+    char *argv1[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso1", NULL};
+    ArranqueHuesped arranque1 = {.entrada = p1_input_pipe[0], .salida = p1_to_p3_pipe[1], .nucleo = -1};
+    t->pid1 = lanzar_huesped(escenario == 2 ? argv1_trazas : argv1, &arranque1, &p1_full_stats);
+
+    char *argv3_trazas[] = {"qemu-riscv32", "-d", "cpu", "-D", "p3_trace.fifo", "./code/escenariosBasicos/proceso3", NULL};
+    char *argv3[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso3", NULL};
+    ArranqueHuesped arranque3 = {.entrada = p1_to_p3_pipe[0], .salida = p3_to_kernel_pipe[1], .nucleo = -1};
+    t->pid3 = lanzar_huesped(escenario == 2 ? argv3_trazas : argv3, &arranque3, &p3_full_stats);
+
+    close(p1_input_pipe[0]);
+    close(p1_to_p3_pipe[1]);
+    close(p3_to_kernel_pipe[1]);
+
+    t->fd_p1_a_p3 = p1_to_p3_pipe[0];
+    t->fd_p3_a_kernel = p3_to_kernel_pipe[0];
+    *fd_entrada = p1_input_pipe[1];
+}
+
+void prelanzar_siguiente_ciclo()
+{
+    TuberiaHuespedes *t = &tuberia_huespedes;
+    int fd_entrada;
+
+    if (t->lista || !escenario_prelanzable(escenario_actual))
+        return;
+
+    double inicio = tiempo_monotonico();
+    lanzar_tuberia_huespedes(t, escenario_actual, &fd_entrada);
+    esperar_huespedes_bloqueados(t->pid1, t->pid3);
+    senial_huesped(t->pid1, SIGSTOP, slot_telemetria(&p1_full_stats));
+    senial_huesped(t->pid3, SIGSTOP, slot_telemetria(&p3_full_stats));
+
+    /* Las lecturas se anotan aparte: la traza del ciclo que acaba de terminar no se toca. */
+    int antes = traza_lecturas.num_lecturas;
+    enviar_contenido_archivo_a_pipe(fd_entrada, "medidas.txt");
+    enviar_escrituras_es();
+    t->num_entradas = traza_lecturas.num_lecturas - antes;
+    memcpy(t->entradas, &traza_lecturas.lecturas[antes], t->num_entradas * sizeof(LecturaTrazada));
+    traza_lecturas.num_lecturas = antes;
+
+    t->lista = 1;
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Ciclo #%d prelanzado: %s%s" ANSI_RESET " (PID %d) y %s%s" ANSI_RESET " (PID %d) detenidos en %.3f s.\n",
+           ciclo_actual, color_proceso("proceso1"), nombre_legible("proceso1"), t->pid1,
+           color_proceso("proceso3"), nombre_legible("proceso3"), t->pid3, tiempo_monotonico() - inicio);
+}
+
+void cerrar_tuberia_huespedes(TuberiaHuespedes *t)
+{
+    close(t->fd_p3_a_kernel);
+    if (t->con_trazas)
+    {
+        finalizar_anillo_traza(&t->traza_p1, "proceso1");
+        finalizar_anillo_traza(&t->traza_p3, "proceso3");
+    }
+    t->lista = 0;
+}
+
+/* El escenario (SIGTSTP, canal de control) o la política cambiaron y la pareja
+   prelanzada ya no sirve: EDF y gang lanzan la suya y recrean las FIFO de traza. */
+void descartar_prelanzamiento()
+{
+    TuberiaHuespedes *t = &tuberia_huespedes;
+
+    if (!t->lista || (t->escenario == escenario_actual && escenario_prelanzable(escenario_actual)))
+        return;
+
+    kill(t->pid1, SIGKILL);
+    kill(t->pid3, SIGKILL);
+    waitpid(t->pid1, NULL, 0);
+    waitpid(t->pid3, NULL, 0);
+    close(t->fd_p1_a_p3);
+    cerrar_tuberia_huespedes(t);
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Huéspedes prelanzados para el escenario %d descartados.\n", t->escenario);
+    informar_grifos(1);
+}
+
+TuberiaHuespedes *preparar_tuberia_huespedes(int escenario)
+{
+    TuberiaHuespedes *t = &tuberia_huespedes;
+    int fd_entrada;
+
+    descartar_prelanzamiento();
+
+    if (t->lista)
+    {
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Adoptando huéspedes prelanzados (PID %d y %d).\n", t->pid1, t->pid3);
+        for (int i = 0; i < t->num_entradas; i++)
+            registrar_entrada_lectura(t->entradas[i].valor, t->entradas[i].fin_en_flujo);
+
+        /* El SIGSTOP se envió antes de inicializar_ciclo; se vuelve a contabilizar aquí.
+           Para las métricas clásicas llegan ahora, ya detenidos. */
+        p1_full_stats.seniales_recibidas[SIGSTOP]++;
+        p3_full_stats.seniales_recibidas[SIGSTOP]++;
+        p1_full_stats.instante_llegada = p1_full_stats.instante_parada = tiempo_monotonico();
+        p3_full_stats.instante_llegada = p3_full_stats.instante_parada = p1_full_stats.instante_llegada;
+        publicar_estado_proceso(slot_telemetria(&p1_full_stats), t->pid1, TEL_DETENIDO, 0.0);
+        publicar_estado_proceso(slot_telemetria(&p3_full_stats), t->pid3, TEL_DETENIDO, 0.0);
+        vigilar_pipes_lecturas(t->fd_p1_a_p3, t->fd_p3_a_kernel);
+    }
+    else
+    {
+        lanzar_tuberia_huespedes(t, escenario, &fd_entrada);
+        vigilar_pipes_lecturas(t->fd_p1_a_p3, t->fd_p3_a_kernel);
+        /* Se esperan bloqueados en su primera lectura para que el exec ya esté pagado. */
+        esperar_huespedes_bloqueados(t->pid1, t->pid3);
+        detener_huesped(t->pid1, &p1_full_stats);
+        detener_huesped(t->pid3, &p3_full_stats);
+        enviar_contenido_archivo_a_pipe(fd_entrada, "medidas.txt");
+        enviar_escrituras_es();
+    }
+
+    close(t->fd_p1_a_p3);
+    t->lista = 0;
+    return t;
+}
+
+void ejecutar_escenario_1()
+{
+    pid_t pid1, pid2, pid3;
+    const int TIMEOUT_P3 = 10;
+
+    int datos_pipe_p3[2];
+    int p1_input_pipe[2];
+    int p1_to_p3_pipe[2];
+
+    if (pipe(datos_pipe_p3) == -1)
+    {
+        perror(COLOR_ERROR "pipe datos_pipe_p3" ANSI_RESET);
+        exit(1);
+    }
+
+    if (pipe(p1_input_pipe) == -1)
+    {
+        perror(COLOR_ERROR "pipe p1_input_pipe" ANSI_RESET);
+        exit(1);
+    }
+
+    if (pipe(p1_to_p3_pipe) == -1)
+    {
+        perror(COLOR_ERROR "pipe p1_to_p3_pipe" ANSI_RESET);
+        exit(1);
+    }
+    interponer_grifos(p1_to_p3_pipe, datos_pipe_p3);
+
+    gettimeofday(&p1_start, NULL);
+
+    char *argv1[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso1", NULL};
+    ArranqueHuesped arranque1 = {.entrada = p1_input_pipe[0], .salida = p1_to_p3_pipe[1], .nucleo = -1};
+    pid1 = lanzar_huesped(argv1, &arranque1, &p1_full_stats);
+
+    close(p1_input_pipe[0]);
+    close(p1_to_p3_pipe[1]);
+
+    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
+    enviar_escrituras_es();
+
+    gettimeofday(&p2_start, NULL);
+
+    /* P2 y P3 quedan retenidos antes del exec hasta que se les da paso: ya no corren
+       entre su creación y su SIGSTOP. */
+    char *argv2[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", NULL};
+    ArranqueHuesped arranque2 = {.entrada = -1, .salida = -1, .nucleo = -1, .retenido = 1};
+    pid2 = lanzar_huesped(argv2, &arranque2, &p2_full_stats);
+
+    gettimeofday(&p3_start, NULL);
+
+    char *argv3[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso3", NULL};
+    ArranqueHuesped arranque3 = {.entrada = p1_to_p3_pipe[0], .salida = datos_pipe_p3[1], .nucleo = -1, .retenido = 1};
+    pid3 = lanzar_huesped(argv3, &arranque3, &p3_full_stats);
+
+    vigilar_pipes_lecturas(p1_to_p3_pipe[0], datos_pipe_p3[0]);
+
+    close(datos_pipe_p3[1]);
+    close(p1_to_p3_pipe[0]);
+
+    detener_huesped(pid2, &p2_full_stats);
+    p2_full_stats.num_pausas++;
+    detener_huesped(pid3, &p3_full_stats);
+    p3_full_stats.num_pausas++;
+
+    esperar_proceso(pid1, "./code/escenariosBasicos/proceso1", 0, &p1_start);
+
+    struct timeval p1_end, p2_activacion;
+    gettimeofday(&p1_end, NULL);
+    p2_full_stats.tiempo_pausado_total += timeval_diff(&p2_start, &p1_end);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Receptor (P1) terminó. Activando %s%s" COLOR_KERNEL "..." ANSI_RESET "\n", color_proceso("proceso2"), nombre_legible("proceso2"));
+
+    gettimeofday(&p2_activacion, NULL);
+    reanudar_huesped(pid2, &p2_full_stats, 0.0);
+    esperar_proceso(pid2, "./code/escenariosBasicos/proceso2", 0, &p2_activacion);
+
+    struct timeval p2_end, p3_activacion;
+    gettimeofday(&p2_end, NULL);
+    p3_full_stats.tiempo_pausado_total += timeval_diff(&p3_start, &p2_end);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Escudo (P2) terminó. Activando %s%s" COLOR_KERNEL "..." ANSI_RESET "\n", color_proceso("proceso3"), nombre_legible("proceso3"));
+
+    gettimeofday(&p3_activacion, NULL);
+    reanudar_huesped(pid3, &p3_full_stats, 0.0);
+    esperar_proceso(pid3, "./code/escenariosBasicos/proceso3", 0, &p3_activacion);
+
+    int ultimo_valor;
+    leer_datos_p3(datos_pipe_p3[0], &ultimo_valor);
+}
+
+void ejecutar_escenario_2()
+{
+    pid_t pid1, pid2, pid3;
+    double quantum_p1, quantum_p3;
+    MotivoOcio p1_ocio = OCIO_NINGUNO, p3_ocio = OCIO_NINGUNO;
+
+    struct rusage usage_temp;
+    int p1_status, p3_status;
+    int p1_vivo = 1, p3_vivo = 1;
+    int last_temp = -1;
+    double tiempo_acumulado_p1 = 0.0;
+    double tiempo_acumulado_p3 = 0.0;
+    struct timeval turno_start, turno_end;
+    struct timeval p1_last_stop_time, p3_last_stop_time;
+    struct timeval p1_turn_start, p3_turn_start;
+
+    TuberiaHuespedes *tuberia = preparar_tuberia_huespedes(2);
+    pid1 = tuberia->pid1;
+    pid3 = tuberia->pid3;
+    int fd_p3_a_kernel = tuberia->fd_p3_a_kernel;
+
+    fcntl(fd_p3_a_kernel, F_SETFL, O_NONBLOCK);
+
+    gettimeofday(&p1_last_stop_time, NULL);
+    p3_last_stop_time = p1_last_stop_time;
+
+    p1_full_stats.num_pausas++;
+    p3_full_stats.num_pausas++;
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Procesos listos. Iniciando...\n");
+
+    while (p1_vivo || p3_vivo)
+    {
+        int lecturas_nuevas = 0;
+
+        if (p1_vivo && turno_innecesario(p1_ocio, -1, traza_lecturas.fd_p1_a_p3, p3_vivo))
+        {
+            omitir_turno("./proceso1", pid1, &p1_full_stats, quantum_p1_rr, p1_ocio);
+        }
+        else if (p1_vivo)
+        {
+            quantum_p1 = quantum_turno_rr(0);
+            if (nivel_log >= NIVEL_LOG_NORMAL)
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %.2f seg...\n",
+                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1, quantum_p1);
+
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            p1_full_stats.tiempo_pausado_total += timeval_diff(&p1_last_stop_time, &now);
+
+            gettimeofday(&turno_start, NULL);
+            p1_turn_start = turno_start;
+            reanudar_huesped(pid1, &p1_full_stats, quantum_p1);
+            if (politica_actual == POLITICA_DATOS)
+                p1_ocio = dormir_quantum_datos(quantum_p1, pid1, -1, &p1_full_stats);
+            else
+                dormir_quantum(quantum_p1);
+            gettimeofday(&turno_end, NULL);
+            tiempo_acumulado_p1 += timeval_diff(&turno_start, &turno_end);
+            p1_full_stats.quantum_dado_total += quantum_p1;
+
+            if (sondear_hijo(pid1, &p1_status, &usage_temp) == pid1)
+            {
+                p1_vivo = 0;
+                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &turno_end);
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó." ANSI_RESET "\n",
+                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
+                guardar_stats_proceso("./code/escenariosBasicos/proceso1", pid1, tiempo_acumulado_p1, &usage_temp, p1_status);
+            }
+            else
+            {
+                if (nivel_log >= NIVEL_LOG_NORMAL)
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
+                           color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
+                detener_huesped(pid1, &p1_full_stats);
+                usleep(10000);
+                volcar_anillo_traza(&tuberia->traza_p1);
+                unsigned long pc_p1 = obtener_pc_riscv("p1_trace.log");
+                if (nivel_log >= NIVEL_LOG_NORMAL)
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "El proceso 1 se quedó en el PC: 0x%lx\n" ANSI_RESET, pc_p1);
+                publicar_pc_proceso(&p1_full_stats, pc_p1);
+                gettimeofday(&p1_last_stop_time, NULL);
+                p1_full_stats.num_pausas++;
+                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &p1_last_stop_time);
+            }
+        }
+
+        if (p3_vivo && turno_innecesario(p3_ocio, traza_lecturas.fd_p1_a_p3, -1, p1_vivo))
+        {
+            omitir_turno("./proceso3", pid3, &p3_full_stats, quantum_p3_rr, p3_ocio);
+        }
+        else if (p3_vivo)
+        {
+            quantum_p3 = quantum_turno_rr(1);
+            if (nivel_log >= NIVEL_LOG_NORMAL)
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %.2f seg...\n",
+                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3, quantum_p3);
+
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            p3_full_stats.tiempo_pausado_total += timeval_diff(&p3_last_stop_time, &now);
+
+            gettimeofday(&turno_start, NULL);
+            p3_turn_start = turno_start;
+            reanudar_huesped(pid3, &p3_full_stats, quantum_p3);
+            if (politica_actual == POLITICA_DATOS)
+                p3_ocio = dormir_quantum_datos(quantum_p3, pid3, traza_lecturas.fd_p1_a_p3, &p3_full_stats);
+            else
+                dormir_quantum(quantum_p3);
+
+            lecturas_nuevas = leer_datos_p3(fd_p3_a_kernel, &last_temp);
+
+            if (nivel_log < NIVEL_LOG_NORMAL)
+                ;
+            else if (lecturas_nuevas > 0)
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Temperatura analizada por %s%s: %d\n",
+                       color_proceso("./proceso3"), nombre_legible("./proceso3"), last_temp);
+            else
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s no entregó lecturas en este turno.\n",
+                       color_proceso("./proceso3"), nombre_legible("./proceso3"));
+
+            gettimeofday(&turno_end, NULL);
+            tiempo_acumulado_p3 += timeval_diff(&turno_start, &turno_end);
+            p3_full_stats.quantum_dado_total += quantum_p3;
+
+            if (sondear_hijo(pid3, &p3_status, &usage_temp) == pid3)
+            {
+                p3_vivo = 0;
+                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &turno_end);
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó." ANSI_RESET "\n",
+                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
+                guardar_stats_proceso("./code/escenariosBasicos/proceso3", pid3, tiempo_acumulado_p3, &usage_temp, p3_status);
+            }
+            else
+            {
+                if (nivel_log >= NIVEL_LOG_NORMAL)
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
+                           color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
+                detener_huesped(pid3, &p3_full_stats);
+                usleep(10000);
+                volcar_anillo_traza(&tuberia->traza_p3);
+                unsigned long pc_p3 = obtener_pc_riscv("p3_trace.log");
+                if (nivel_log >= NIVEL_LOG_NORMAL)
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "El proceso 3 se quedó en el PC: 0x%lx\n" ANSI_RESET, pc_p3);
+                publicar_pc_proceso(&p3_full_stats, pc_p3);
+                gettimeofday(&p3_last_stop_time, NULL);
+                p3_full_stats.num_pausas++;
+                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &p3_last_stop_time);
+            }
+        }
+
+        if (lecturas_nuevas > 0)
+        {
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Lanzando %s%s con argumento: %d (Acción por defecto si < %d).\n",
+                   color_proceso("./proceso2"), nombre_legible("./proceso2"), (last_temp > UMBRAL_ESCUDO) ? 1 : 0, UMBRAL_ESCUDO);
+
+            gettimeofday(&p2_start, NULL);
+
+            char temp_arg[2] = {(last_temp > UMBRAL_ESCUDO) ? '1' : '0', '\0'};
+            char *args[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", temp_arg, NULL};
+            ArranqueHuesped arranque2 = {.entrada = -1, .salida = -1, .nucleo = -1};
+            pid2 = lanzar_huesped(args, &arranque2, &p2_full_stats);
+
+            esperar_proceso(pid2, "./code/escenariosBasicos/proceso2", 0, &p2_start);
+            registrar_actuacion_escudo();
+        }
+    }
+
+    cerrar_tuberia_huespedes(tuberia);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Ciclo de Round-Robin finalizado.\n");
+}
+
+void ejecutar_escenario_3()
+{
+    pid_t pid1, pid2, pid3;
+    double quantum_p1, quantum_p3;
+    MotivoOcio p1_ocio = OCIO_NINGUNO, p3_ocio = OCIO_NINGUNO;
+
+    struct rusage usage_temp;
+    int p1_status, p3_status;
+    int p1_vivo = 1, p3_vivo = 1;
+    int arg_p2_proximo = -1;
+
+    double tiempo_acumulado_p1 = 0.0;
+    double tiempo_acumulado_p3 = 0.0;
+    struct timeval turno_start, turno_end;
+    struct timeval p1_last_stop_time, p3_last_stop_time;
+    struct timeval p1_turn_start, p3_turn_start;
+
+    TuberiaHuespedes *tuberia = preparar_tuberia_huespedes(3);
+    pid1 = tuberia->pid1;
+    pid3 = tuberia->pid3;
+    int fd_p3_a_kernel = tuberia->fd_p3_a_kernel;
+
+    fcntl(fd_p3_a_kernel, F_SETFL, O_NONBLOCK);
+
+    gettimeofday(&p1_last_stop_time, NULL);
+    p3_last_stop_time = p1_last_stop_time;
+
+    p1_full_stats.num_pausas++;
+    p3_full_stats.num_pausas++;
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Procesos listos. Iniciando...\n");
+
+    while (p1_vivo || p3_vivo)
+    {
+
+        {
+            char *arg_msg = (arg_p2_proximo == 1) ? "Activar (1)" : (arg_p2_proximo == 0) ? "Desactivar (0)"
+                                                                                          : "Neutro (-1)";
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Lanzando %s%s con argumento: %s (Decisión de ronda previa)...\n",
+                   color_proceso("proceso2"), nombre_legible("proceso2"), arg_msg);
+
+            gettimeofday(&p2_start, NULL);
+
+            char arg_str[2] = {arg_p2_proximo == 1 ? '1' : '0', '\0'};
+            char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", arg_p2_proximo == -1 ? NULL : arg_str, NULL};
+            ArranqueHuesped arranque2 = {.entrada = -1, .salida = -1, .nucleo = -1};
+            pid2 = lanzar_huesped(argv, &arranque2, &p2_full_stats);
+
+            esperar_proceso(pid2, "proceso2", 0, &p2_start);
+
+            if (arg_p2_proximo != -1)
+                registrar_actuacion_escudo();
+
+            arg_p2_proximo = -1;
+        }
+
+        if (p1_vivo && turno_innecesario(p1_ocio, -1, traza_lecturas.fd_p1_a_p3, p3_vivo))
+        {
+            omitir_turno("./proceso1", pid1, &p1_full_stats, quantum_p1_rr, p1_ocio);
+        }
+        else if (p1_vivo)
+        {
+            quantum_p1 = quantum_turno_rr(0);
+            if (nivel_log >= NIVEL_LOG_NORMAL)
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %.2fs...\n",
+                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1, quantum_p1);
+
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            p1_full_stats.tiempo_pausado_total += timeval_diff(&p1_last_stop_time, &now);
+
+            gettimeofday(&turno_start, NULL);
+            p1_turn_start = turno_start;
+            reanudar_huesped(pid1, &p1_full_stats, quantum_p1);
+            if (politica_actual == POLITICA_DATOS)
+                p1_ocio = dormir_quantum_datos(quantum_p1, pid1, -1, &p1_full_stats);
+            else
+                dormir_quantum(quantum_p1);
+
+            gettimeofday(&turno_end, NULL);
+            tiempo_acumulado_p1 += timeval_diff(&turno_start, &turno_end);
+            p1_full_stats.quantum_dado_total += quantum_p1;
+
+            if (sondear_hijo(pid1, &p1_status, &usage_temp) == pid1)
+            {
+                p1_vivo = 0;
+                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &turno_end);
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó.\n",
+                       color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
+                guardar_stats_proceso("./code/escenariosBasicos/proceso1", pid1, tiempo_acumulado_p1, &usage_temp, p1_status);
+            }
+            else
+            {
+                if (nivel_log >= NIVEL_LOG_NORMAL)
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
+                           color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
+                detener_huesped(pid1, &p1_full_stats);
+                gettimeofday(&p1_last_stop_time, NULL);
+                p1_full_stats.num_pausas++;
+                p1_full_stats.quantum_usado_total += timeval_diff(&p1_turn_start, &p1_last_stop_time);
+            }
+        }
+
+        if (p3_vivo && turno_innecesario(p3_ocio, traza_lecturas.fd_p1_a_p3, -1, p1_vivo))
+        {
+            omitir_turno("./proceso3", pid3, &p3_full_stats, quantum_p3_rr, p3_ocio);
+        }
+        else if (p3_vivo)
+        {
+            quantum_p3 = quantum_turno_rr(1);
+            if (nivel_log >= NIVEL_LOG_NORMAL)
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %.2fs...\n",
+                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3, quantum_p3);
+
+            struct timeval now;
+            gettimeofday(&now, NULL);
+            p3_full_stats.tiempo_pausado_total += timeval_diff(&p3_last_stop_time, &now);
+
+            gettimeofday(&turno_start, NULL);
             p3_turn_start = turno_start;
-            kill(pid3, SIGCONT);
-            p3_full_stats.seniales_recibidas[SIGCONT]++;
-            sleep(TIMEOUT_P3);
+            reanudar_huesped(pid3, &p3_full_stats, quantum_p3);
+            if (politica_actual == POLITICA_DATOS)
+                p3_ocio = dormir_quantum_datos(quantum_p3, pid3, traza_lecturas.fd_p1_a_p3, &p3_full_stats);
+            else
+                dormir_quantum(quantum_p3);
+
+            int ultimo_valor_del_turno;
+
+            if (leer_datos_p3(fd_p3_a_kernel, &ultimo_valor_del_turno) > 0)
+            {
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Última lectura procesada por %s%s: %d\n",
+                       color_proceso("./proceso3"), nombre_legible("./proceso3"), ultimo_valor_del_turno);
+
+                if (ultimo_valor_del_turno > UMBRAL_ESCUDO)
+                {
+                    arg_p2_proximo = 1;
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activar escudo para la próxima ronda.\n" ANSI_RESET);
+                }
+                else
+                {
+                    arg_p2_proximo = 0;
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Desactivar escudo para la próxima ronda.\n" ANSI_RESET);
+                }
+            }
+            else
+            {
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Mantener estado neutro para la próxima ronda (No se recibió un nuevo valor del analizador).\n" ANSI_RESET);
+            }
+
+            gettimeofday(&turno_end, NULL);
+            tiempo_acumulado_p3 += timeval_diff(&turno_start, &turno_end);
+            p3_full_stats.quantum_dado_total += quantum_p3;
+
+            if (sondear_hijo(pid3, &p3_status, &usage_temp) == pid3)
+            {
+                p3_vivo = 0;
+                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &turno_end);
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó.\n",
+                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
+                guardar_stats_proceso("./code/escenariosBasicos/proceso3", pid3, tiempo_acumulado_p3, &usage_temp, p3_status);
+
+                if (p1_vivo)
+                {
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Terminó %s%s. Forzando terminación de %s%s (PID %d)...\n",
+                           color_proceso("./proceso3"), nombre_legible("./proceso3"),
+                           color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
+                    kill(pid1, SIGKILL);
+                    p1_full_stats.seniales_recibidas[SIGKILL]++;
+                    wait4(pid1, &p1_status, 0, &usage_temp);
+
+                    guardar_stats_proceso("./code/escenariosBasicos/proceso1", pid1, tiempo_acumulado_p1, &usage_temp, p1_status);
+                    p1_vivo = 0;
+                }
+            }
+            else
+            {
+                if (nivel_log >= NIVEL_LOG_NORMAL)
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
+                           color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
+                detener_huesped(pid3, &p3_full_stats);
+                gettimeofday(&p3_last_stop_time, NULL);
+                p3_full_stats.num_pausas++;
+                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &p3_last_stop_time);
+            }
+        }
+    }
+
+    cerrar_tuberia_huespedes(tuberia);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Ciclo finalizado.\n");
+}
+
+void ejecutar_escenario_4()
+{
+    pid_t pid1;
+    int p1_input_pipe[2];
+    int actuaciones_pipe[2];
+    if (pipe(p1_input_pipe) == -1 || pipe(actuaciones_pipe) == -1)
+    {
+        perror("pipe");
+        exit(1);
+    }
+    /* P3 y P2 heredan la salida de P1: cada línea del Escudo es una actuación. */
+    char *argv[] = {"qemu-riscv32", "./code/escenariosSyscall/proceso1", NULL};
+    ArranqueHuesped arranque1 = {.entrada = p1_input_pipe[0], .salida = actuaciones_pipe[1], .nucleo = -1};
+    pid1 = lanzar_huesped(argv, &arranque1, &p1_full_stats);
+    iniciar_seguimiento_descendientes(pid1, "./code/escenariosSyscall/proceso1");
+
+    close(p1_input_pipe[0]);
+    close(actuaciones_pipe[1]);
+    fcntl(actuaciones_pipe[0], F_SETFL, O_NONBLOCK);
+    traza_lecturas.fd_actuaciones = actuaciones_pipe[0];
+    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
+    enviar_escrituras_es();
+    gettimeofday(&p1_start, NULL);
+    esperar_proceso(pid1, "./code/escenariosSyscall/proceso1", 0, &p1_start);
+
+    descontar_uso_absorbido(pid1, &usage_p1);
+    copiar_rusage_a_stats(&usage_p1, time_p1, &p1_full_stats, p1_full_stats.exit_status);
+
+    finalizar_seguimiento_descendientes();
+}
+
+void registrar_trabajo_edf(ProcesoStats *stats, double fin, double plazo_absoluto)
+{
+    int cumplidos_previos = stats->edf_activaciones - stats->edf_plazos_perdidos;
+
+    stats->edf_activaciones++;
+
+    if (fin > plazo_absoluto)
+    {
+        double retraso = fin - plazo_absoluto;
+        if (stats->edf_plazos_perdidos == 0 || retraso > stats->edf_retraso_max)
+            stats->edf_retraso_max = retraso;
+        stats->edf_retraso_total += retraso;
+        stats->edf_plazos_perdidos++;
+    }
+    else
+    {
+        double holgura = plazo_absoluto - fin;
+        if (cumplidos_previos == 0 || holgura < stats->edf_holgura_min)
+            stats->edf_holgura_min = holgura;
+        stats->edf_holgura_total += holgura;
+    }
+}
+
+void combinar_stats_edf(ProcesoStats *destino, const ProcesoStats *origen)
+{
+    int cumplidos_destino = destino->edf_activaciones - destino->edf_plazos_perdidos;
+    int cumplidos_origen = origen->edf_activaciones - origen->edf_plazos_perdidos;
+
+    if (origen->edf_plazos_perdidos > 0 &&
+        (destino->edf_plazos_perdidos == 0 || origen->edf_retraso_max > destino->edf_retraso_max))
+        destino->edf_retraso_max = origen->edf_retraso_max;
+
+    if (cumplidos_origen > 0 &&
+        (cumplidos_destino == 0 || origen->edf_holgura_min < destino->edf_holgura_min))
+        destino->edf_holgura_min = origen->edf_holgura_min;
+
+    destino->edf_activaciones += origen->edf_activaciones;
+    destino->edf_plazos_perdidos += origen->edf_plazos_perdidos;
+    destino->edf_retraso_total += origen->edf_retraso_total;
+    destino->edf_holgura_total += origen->edf_holgura_total;
+}
+
+typedef struct
+{
+    const char *ruta;
+    const ParametrosEdf *params;
+    ProcesoStats *stats;
+    pid_t pid;
+    int vivo;
+    double liberacion;
+    double plazo_absoluto;
+    double restante;
+    double tiempo_acumulado;
+    struct timeval ultima_parada;
+} TareaEdf;
+
+void liberar_trabajo_edf(TareaEdf *tarea, double instante)
+{
+    tarea->liberacion = instante;
+    tarea->plazo_absoluto = instante + tarea->params->plazo_relativo;
+    tarea->restante = tarea->params->presupuesto;
+}
+
+void completar_trabajo_edf(TareaEdf *tarea, double fin)
+{
+    registrar_trabajo_edf(tarea->stats, fin, tarea->plazo_absoluto);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Trabajo EDF de %s%s" ANSI_RESET " %s (plazo %+.3f s).\n",
+           color_proceso(tarea->ruta), nombre_legible(tarea->ruta),
+           (fin > tarea->plazo_absoluto) ? COLOR_ERROR "PERDIDO" ANSI_RESET : "cumplido",
+           tarea->plazo_absoluto - fin);
+
+    liberar_trabajo_edf(tarea, tarea->liberacion + tarea->params->periodo);
+}
+
+int tarea_edf_lista(TareaEdf *tarea, double ahora)
+{
+    return tarea->vivo && tarea->restante > 0.0 && tarea->liberacion <= ahora;
+}
+
+/* Vuelve antes si el proceso termina o si llega una lectura por 'fd_datos', que libera un
+   trabajo del Escudo. Devuelve 1 si hubo lectura (0 es un valor válido). */
+int ejecutar_tramo_edf(TareaEdf *tarea, double duracion, int *fd_datos, int *valor_lectura, double *instante_lectura)
+{
+    struct timeval ahora_tv, inicio_tv;
+    struct rusage usage_temp;
+    int status;
+    int hay_lectura = 0;
+
+    gettimeofday(&ahora_tv, NULL);
+    tarea->stats->tiempo_pausado_total += timeval_diff(&tarea->ultima_parada, &ahora_tv);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "EDF: activando %s%s (PID %d) por %.2f s (plazo en %.2f s)...\n",
+           color_proceso(tarea->ruta), nombre_legible(tarea->ruta), tarea->pid,
+           duracion, tarea->plazo_absoluto - tiempo_monotonico());
+
+    gettimeofday(&inicio_tv, NULL);
+    double inicio = tiempo_monotonico();
+    double fin_tramo = inicio + duracion;
+
+    reanudar_huesped(tarea->pid, tarea->stats, duracion);
+    tarea->stats->quantum_dado_total += duracion;
+
+    double ahora = inicio;
+    while (ahora < fin_tramo)
+    {
+        int espera_ms = (int)((fin_tramo - ahora) * 1000.0) + 1;
+        if (espera_ms > EDF_TRAMO_SONDEO_MS)
+            espera_ms = EDF_TRAMO_SONDEO_MS;
+
+        if (fd_datos != NULL && *fd_datos >= 0)
+        {
+            struct pollfd pfd = {.fd = *fd_datos, .events = POLLIN};
+            if (poll(&pfd, 1, espera_ms) > 0)
+            {
+                if (pfd.revents & POLLIN)
+                {
+                    int valor;
+                    if (leer_datos_p3(*fd_datos, &valor) > 0)
+                    {
+                        *valor_lectura = valor;
+                        *instante_lectura = tiempo_monotonico();
+                        hay_lectura = 1;
+                    }
+                }
+                else if (pfd.revents & (POLLHUP | POLLERR))
+                {
+                    *fd_datos = -1;
+                }
+            }
+        }
+        else
+        {
+            usleep(espera_ms * 1000);
+        }
+
+        muestrear_latencias();
+        atender_canales();
+        ahora = tiempo_monotonico();
+
+        if (sondear_hijo(tarea->pid, &status, &usage_temp) == tarea->pid)
+        {
+            double usado = ahora - inicio;
+            tarea->vivo = 0;
+            tarea->tiempo_acumulado += usado;
+            tarea->stats->quantum_usado_total += usado;
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó.\n",
+                   color_proceso(tarea->ruta), nombre_legible(tarea->ruta), tarea->pid);
+            guardar_stats_proceso(tarea->ruta, tarea->pid, tarea->tiempo_acumulado, &usage_temp, status);
+            completar_trabajo_edf(tarea, ahora);
+            return hay_lectura;
+        }
+
+        if (hay_lectura)
+            break;
+    }
+
+    if (!hay_lectura)
+        registrar_sobrepaso_quantum(fin_tramo);
+    detener_huesped(tarea->pid, tarea->stats);
+    tarea->stats->num_pausas++;
+    gettimeofday(&tarea->ultima_parada, NULL);
+
+    double usado = timeval_diff(&inicio_tv, &tarea->ultima_parada);
+    tarea->tiempo_acumulado += usado;
+    tarea->stats->quantum_usado_total += usado;
+    tarea->restante -= usado;
+
+    if (tarea->restante <= 0.0)
+        completar_trabajo_edf(tarea, tiempo_monotonico());
+
+    return hay_lectura;
+}
+
+void lanzar_escudo_edf(int decision, double plazo_absoluto)
+{
+    pid_t pid2;
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "EDF: lanzando %s%s con argumento %d (plazo en %.3f s)...\n",
+           color_proceso("proceso2"), nombre_legible("proceso2"), decision, plazo_absoluto - tiempo_monotonico());
+
+    gettimeofday(&p2_start, NULL);
+
+    char arg_str[2] = {decision ? '1' : '0', '\0'};
+    char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", arg_str, NULL};
+    ArranqueHuesped arranque = {.entrada = -1, .salida = -1, .nucleo = -1};
+    pid2 = lanzar_huesped(argv, &arranque, &p2_full_stats);
+
+    esperar_proceso(pid2, "proceso2", 0, &p2_start);
+    registrar_actuacion_escudo();
+
+    double fin = tiempo_monotonico();
+    registrar_trabajo_edf(&p2_full_stats, fin, plazo_absoluto);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Actuación del %s%s" ANSI_RESET " %s (plazo %+.3f s).\n",
+           color_proceso("proceso2"), nombre_legible("proceso2"),
+           (fin > plazo_absoluto) ? COLOR_ERROR "PERDIDA" ANSI_RESET : "a tiempo",
+           plazo_absoluto - fin);
+}
+
+void ejecutar_escenario_3_edf()
+{
+    int p1_input_pipe[2], p1_to_p3_pipe[2], p3_to_kernel_pipe[2];
+    struct rusage usage_temp;
+    int p1_status;
+
+    TareaEdf p1 = {.ruta = "./code/escenariosBasicos/proceso1", .params = &EDF_P1, .stats = &p1_full_stats, .vivo = 1};
+    TareaEdf p3 = {.ruta = "./code/escenariosBasicos/proceso3", .params = &EDF_P3, .stats = &p3_full_stats, .vivo = 1};
+    TareaEdf *tareas[] = {&p1, &p3};
+    const int num_tareas = 2;
+
+    int escudo_pendiente = 0;
+    int decision_escudo = 0;
+    double plazo_escudo = 0.0;
+
+    if (pipe(p1_input_pipe) == -1 || pipe(p1_to_p3_pipe) == -1 || pipe(p3_to_kernel_pipe) == -1)
+    {
+        perror("pipe");
+        exit(1);
+    }
+    interponer_grifos(p1_to_p3_pipe, p3_to_kernel_pipe);
+
+    char *argv1[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso1", NULL};
+    ArranqueHuesped arranque1 = {.entrada = p1_input_pipe[0], .salida = p1_to_p3_pipe[1], .nucleo = -1};
+    p1.pid = lanzar_huesped(argv1, &arranque1, p1.stats);
+
+    char *argv3[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso3", NULL};
+    ArranqueHuesped arranque3 = {.entrada = p1_to_p3_pipe[0], .salida = p3_to_kernel_pipe[1], .nucleo = -1};
+    p3.pid = lanzar_huesped(argv3, &arranque3, p3.stats);
+
+    vigilar_pipes_lecturas(p1_to_p3_pipe[0], p3_to_kernel_pipe[0]);
+
+    close(p1_input_pipe[0]);
+    close(p1_to_p3_pipe[0]);
+    close(p1_to_p3_pipe[1]);
+    close(p3_to_kernel_pipe[1]);
+
+    fcntl(p3_to_kernel_pipe[0], F_SETFL, O_NONBLOCK);
+    int fd_datos = p3_to_kernel_pipe[0];
+
+    for (int i = 0; i < num_tareas; i++)
+    {
+        detener_huesped(tareas[i]->pid, tareas[i]->stats);
+        tareas[i]->stats->num_pausas++;
+        gettimeofday(&tareas[i]->ultima_parada, NULL);
+    }
+
+    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
+    enviar_escrituras_es();
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Procesos listos. Planificación EDF (P1 %.0f/%.0f s, P3 %.0f/%.0f s, Escudo D=%.2f s)...\n",
+           EDF_P1.presupuesto, EDF_P1.periodo, EDF_P3.presupuesto, EDF_P3.periodo, EDF_P2.plazo_relativo);
+
+    double inicio = tiempo_monotonico();
+    liberar_trabajo_edf(&p1, inicio);
+    liberar_trabajo_edf(&p3, inicio);
+
+    while (p1.vivo || p3.vivo)
+    {
+        double ahora = tiempo_monotonico();
+
+        if (escudo_pendiente)
+        {
+            /* El plazo del Escudo (relativo a la lectura) siempre es el más próximo
+               mientras sea menor que el periodo de las demás tareas. */
+            int expropia = 1;
+            for (int i = 0; i < num_tareas; i++)
+                if (tarea_edf_lista(tareas[i], ahora) && tareas[i]->plazo_absoluto < plazo_escudo)
+                    expropia = 0;
+
+            if (expropia)
+            {
+                lanzar_escudo_edf(decision_escudo, plazo_escudo);
+                escudo_pendiente = 0;
+                continue;
+            }
+        }
+
+        TareaEdf *elegida = NULL;
+        for (int i = 0; i < num_tareas; i++)
+        {
+            if (tarea_edf_lista(tareas[i], ahora) &&
+                (elegida == NULL || tareas[i]->plazo_absoluto < elegida->plazo_absoluto))
+                elegida = tareas[i];
+        }
+
+        double proxima_liberacion = DBL_MAX;
+        for (int i = 0; i < num_tareas; i++)
+        {
+            if (tareas[i]->vivo && tareas[i]->liberacion > ahora && tareas[i]->liberacion < proxima_liberacion)
+                proxima_liberacion = tareas[i]->liberacion;
+        }
+
+        if (elegida == NULL)
+        {
+            if (escudo_pendiente)
+            {
+                lanzar_escudo_edf(decision_escudo, plazo_escudo);
+                escudo_pendiente = 0;
+            }
+            else if (proxima_liberacion < DBL_MAX)
+            {
+                dormir_muestreando(proxima_liberacion - ahora);
+            }
+            continue;
+        }
+
+        double duracion = elegida->restante;
+        if (proxima_liberacion - ahora < duracion)
+            duracion = proxima_liberacion - ahora;
+
+        double instante_lectura = 0.0;
+        int lectura = 0;
+        if (ejecutar_tramo_edf(elegida, duracion, (elegida == &p3) ? &fd_datos : NULL, &lectura, &instante_lectura))
+        {
+            decision_escudo = (lectura > UMBRAL_ESCUDO) ? 1 : 0;
+            plazo_escudo = instante_lectura + EDF_P2.plazo_relativo;
+            escudo_pendiente = 1;
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Lectura %d recibida de %s%s" ANSI_RESET ": trabajo del Escudo liberado.\n",
+                   lectura, color_proceso("proceso3"), nombre_legible("proceso3"));
+        }
+
+        if (!p3.vivo && p1.vivo)
+        {
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Terminó %s%s. Forzando terminación de %s%s (PID %d)...\n",
+                   color_proceso(p3.ruta), nombre_legible(p3.ruta),
+                   color_proceso(p1.ruta), nombre_legible(p1.ruta), p1.pid);
+            kill(p1.pid, SIGKILL);
+            p1_full_stats.seniales_recibidas[SIGKILL]++;
+            wait4(p1.pid, &p1_status, 0, &usage_temp);
+            guardar_stats_proceso(p1.ruta, p1.pid, p1.tiempo_acumulado, &usage_temp, p1_status);
+            p1.vivo = 0;
+        }
+    }
+
+    if (escudo_pendiente)
+        lanzar_escudo_edf(decision_escudo, plazo_escudo);
+
+    close(p3_to_kernel_pipe[0]);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Ciclo EDF finalizado.\n");
+}
+
+int obtener_nucleos_disponibles(int *nucleos, int max_nucleos)
+{
+    cpu_set_t mascara;
+    int total = 0;
+
+    if (nucleo_rt >= 0)
+        mascara = nucleos_huespedes;
+    else if (sched_getaffinity(0, sizeof(mascara), &mascara) == -1)
+    {
+        nucleos[0] = 0;
+        return 1;
+    }
+
+    for (int cpu = 0; cpu < CPU_SETSIZE && total < max_nucleos; cpu++)
+        if (CPU_ISSET(cpu, &mascara))
+            nucleos[total++] = cpu;
+
+    return total > 0 ? total : 1;
+}
+
+typedef struct
+{
+    const char *ruta;
+    const char *ruta_fifo;
+    const char *ruta_traza;
+    AnilloTraza traza;
+    ProcesoStats *stats;
+    pid_t pid;
+    int vivo;
+    int cpu;
+    double tiempo_acumulado;
+    struct timeval ultima_parada;
+    struct timeval inicio_turno;
+} MiembroGang;
+
+/* Procesos sin relación con la banda (instancias del Escudo) que comparten un núcleo:
+   cada ranura se reanuda uno solo de ellos, por turnos. */
+typedef struct
+{
+    int cpu;
+    pid_t pids[MAX_COLA_NUCLEO];
+    struct timeval inicios[MAX_COLA_NUCLEO];
+    int num_procesos;
+    int turno;
+} ColaNucleo;
+
+void encolar_en_nucleo(ColaNucleo *cola, pid_t pid, struct timeval *inicio)
+{
+    if (cola->num_procesos >= MAX_COLA_NUCLEO)
+    {
+        int status;
+        struct rusage usage;
+        printf(COLOR_ERROR "[Control Central] ALERTA: " ANSI_RESET "Cola del núcleo %d llena. Esperando a %s%s (PID %d)...\n" ANSI_RESET,
+               cola->cpu, color_proceso("proceso2"), nombre_legible("proceso2"), pid);
+        senial_huesped(pid, SIGCONT, slot_telemetria(&p2_full_stats));
+        esperar_hijo_muestreando(pid, &status, &usage);
+        guardar_stats_proceso("proceso2", pid, 0.0, &usage, status);
+        registrar_actuacion_escudo();
+        return;
+    }
+
+    cola->pids[cola->num_procesos] = pid;
+    cola->inicios[cola->num_procesos] = *inicio;
+    cola->num_procesos++;
+
+    if (cola->num_procesos == 1)
+    {
+        cola->turno = 0;
+        senial_huesped(pid, SIGCONT, slot_telemetria(&p2_full_stats));
+    }
+}
+
+void recoger_cola_nucleo(ColaNucleo *cola, int bloquear)
+{
+    for (int i = 0; i < cola->num_procesos;)
+    {
+        int status;
+        struct rusage usage;
+        pid_t pid = cola->pids[i];
+
+        if (bloquear)
+            senial_huesped(pid, SIGCONT, slot_telemetria(&p2_full_stats));
+
+        pid_t terminado = bloquear ? esperar_hijo_muestreando(pid, &status, &usage)
+                                   : sondear_hijo(pid, &status, &usage);
+        if (terminado != pid)
+        {
+            i++;
+            continue;
+        }
+
+        struct timeval fin;
+        gettimeofday(&fin, NULL);
+        proceso_terminado("proceso2", pid);
+        guardar_stats_proceso("proceso2", pid, timeval_diff(&cola->inicios[i], &fin), &usage, status);
+        registrar_actuacion_escudo();
+
+        for (int j = i; j < cola->num_procesos - 1; j++)
+        {
+            cola->pids[j] = cola->pids[j + 1];
+            cola->inicios[j] = cola->inicios[j + 1];
+        }
+        cola->num_procesos--;
+        if (cola->turno > i)
+            cola->turno--;
+    }
+
+    if (cola->num_procesos > 0)
+        cola->turno %= cola->num_procesos;
+}
+
+void rotar_cola_nucleo(ColaNucleo *cola)
+{
+    if (cola->num_procesos < 2)
+        return;
+
+    senial_huesped(cola->pids[cola->turno], SIGSTOP, slot_telemetria(&p2_full_stats));
+    cola->turno = (cola->turno + 1) % cola->num_procesos;
+    senial_huesped(cola->pids[cola->turno], SIGCONT, slot_telemetria(&p2_full_stats));
+}
+
+void lanzar_escudo_en_nucleo(ColaNucleo *cola, int decision)
+{
+    pid_t pid2;
+    struct timeval inicio;
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Lanzando %s%s con argumento %d en el núcleo %d (concurrente con la banda)...\n",
+           color_proceso("proceso2"), nombre_legible("proceso2"), decision, cola->cpu);
+
+    gettimeofday(&inicio, NULL);
+    p2_start = inicio;
+
+    /* Con otro Escudo en el núcleo, espera retenido a su turno (su primer SIGCONT). */
+    char arg_str[2] = {decision ? '1' : '0', '\0'};
+    char *argv[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", arg_str, NULL};
+    ArranqueHuesped arranque = {.entrada = -1, .salida = -1, .nucleo = cola->cpu, .retenido = cola->num_procesos > 0};
+    pid2 = lanzar_huesped(argv, &arranque, &p2_full_stats);
+
+    pid_p2 = pid2;
+    encolar_en_nucleo(cola, pid2, &inicio);
+}
+
+void esperar_ranura_gang(MiembroGang *miembros, int num_miembros, double segundos)
+{
+    double fin = tiempo_monotonico() + segundos;
+
+    while (tiempo_monotonico() < fin)
+    {
+        int vivos = 0;
+        for (int i = 0; i < num_miembros; i++)
+        {
+            struct rusage usage_temp;
+            int status;
+            MiembroGang *m = &miembros[i];
+
+            if (!m->vivo)
+                continue;
+
+            if (sondear_hijo(m->pid, &status, &usage_temp) == m->pid)
+            {
+                struct timeval ahora;
+                gettimeofday(&ahora, NULL);
+                double usado = timeval_diff(&m->inicio_turno, &ahora);
+                m->vivo = 0;
+                m->tiempo_acumulado += usado;
+                m->stats->quantum_usado_total += usado;
+                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó en el núcleo %d.\n",
+                       color_proceso(m->ruta), nombre_legible(m->ruta), m->pid, m->cpu);
+                guardar_stats_proceso(m->ruta, m->pid, m->tiempo_acumulado, &usage_temp, status);
+                continue;
+            }
+            vivos++;
+        }
+
+        if (vivos == 0)
+            return;
+
+        muestrear_latencias();
+        atender_canales();
+        usleep(INTERVALO_MUESTREO_US);
+    }
+
+    registrar_sobrepaso_quantum(fin);
+}
+
+void ejecutar_escenario_gang(int escenario)
+{
+    int p1_input_pipe[2], p1_to_p3_pipe[2], p3_to_kernel_pipe[2];
+    int nucleos[MAX_NUCLEOS];
+    int num_nucleos = obtener_nucleos_disponibles(nucleos, MAX_NUCLEOS);
+    int con_traza = (escenario == 2);
+
+    MiembroGang miembros[2] = {
+        {.ruta = "./code/escenariosBasicos/proceso1", .ruta_fifo = "p1_trace.fifo", .ruta_traza = "p1_trace.log", .stats = &p1_full_stats, .vivo = 1},
+        {.ruta = "./code/escenariosBasicos/proceso3", .ruta_fifo = "p3_trace.fifo", .ruta_traza = "p3_trace.log", .stats = &p3_full_stats, .vivo = 1}};
+    const int num_miembros = 2;
+
+    ColaNucleo cola_escudo = {.cpu = nucleos[num_miembros % num_nucleos]};
+    int decision_escudo = -1;
+
+    if (pipe(p1_input_pipe) == -1 || pipe(p1_to_p3_pipe) == -1 || pipe(p3_to_kernel_pipe) == -1)
+    {
+        perror("pipe");
+        exit(1);
+    }
+    interponer_grifos(p1_to_p3_pipe, p3_to_kernel_pipe);
+
+    for (int i = 0; i < num_miembros; i++)
+    {
+        MiembroGang *m = &miembros[i];
+        m->cpu = nucleos[i % num_nucleos];
+        if (con_traza)
+            iniciar_anillo_traza(&m->traza, m->ruta_fifo, m->ruta_traza);
+
+        char *argv_trazas[] = {"qemu-riscv32", "-d", "cpu", "-D", (char *)m->ruta_fifo, (char *)m->ruta, NULL};
+        char *argv[] = {"qemu-riscv32", (char *)m->ruta, NULL};
+        ArranqueHuesped arranque = {.entrada = i == 0 ? p1_input_pipe[0] : p1_to_p3_pipe[0],
+                                    .salida = i == 0 ? p1_to_p3_pipe[1] : p3_to_kernel_pipe[1],
+                                    .nucleo = m->cpu};
+        m->pid = lanzar_huesped(con_traza ? argv_trazas : argv, &arranque, m->stats);
+    }
+
+    vigilar_pipes_lecturas(p1_to_p3_pipe[0], p3_to_kernel_pipe[0]);
+
+    close(p1_input_pipe[0]);
+    close(p1_to_p3_pipe[0]);
+    close(p1_to_p3_pipe[1]);
+    close(p3_to_kernel_pipe[1]);
+
+    fcntl(p3_to_kernel_pipe[0], F_SETFL, O_NONBLOCK);
+
+    for (int i = 0; i < num_miembros; i++)
+    {
+        detener_huesped(miembros[i].pid, miembros[i].stats);
+        miembros[i].stats->num_pausas++;
+        gettimeofday(&miembros[i].ultima_parada, NULL);
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) asignado al núcleo %d.\n",
+               color_proceso(miembros[i].ruta), nombre_legible(miembros[i].ruta), miembros[i].pid, miembros[i].cpu);
+    }
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Instancias del %s%s" ANSI_RESET " asignadas al núcleo %d (%d núcleos disponibles).\n",
+           color_proceso("proceso2"), nombre_legible("proceso2"), cola_escudo.cpu, num_nucleos);
+
+    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
+    enviar_escrituras_es();
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Procesos listos. Planificación en banda (gang) de la tubería P1 -> P3...\n");
+
+    while (miembros[0].vivo || miembros[1].vivo)
+    {
+        if (escenario == 3 && decision_escudo != -1)
+        {
+            lanzar_escudo_en_nucleo(&cola_escudo, decision_escudo);
+            decision_escudo = -1;
+        }
+
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando la banda [Receptor + Analizador] por %d seg...\n", QUANTUM_GANG);
+
+        for (int i = 0; i < num_miembros; i++)
+        {
+            MiembroGang *m = &miembros[i];
+            if (!m->vivo)
+                continue;
+            gettimeofday(&m->inicio_turno, NULL);
+            m->stats->tiempo_pausado_total += timeval_diff(&m->ultima_parada, &m->inicio_turno);
+            m->stats->quantum_dado_total += QUANTUM_GANG;
+        }
+        for (int i = 0; i < num_miembros; i++)
+        {
+            if (!miembros[i].vivo)
+                continue;
+            reanudar_huesped(miembros[i].pid, miembros[i].stats, QUANTUM_GANG);
+        }
+
+        esperar_ranura_gang(miembros, num_miembros, QUANTUM_GANG);
 
-            int ultimo_valor_del_turno = leer_datos_p3(p3_to_kernel_pipe[0]);
+        for (int i = 0; i < num_miembros; i++)
+        {
+            if (miembros[i].vivo)
+                senial_huesped(miembros[i].pid, SIGSTOP, slot_telemetria(miembros[i].stats));
+        }
 
-            if (ultimo_valor_del_turno != 0)
+        for (int i = 0; i < num_miembros; i++)
+        {
+            MiembroGang *m = &miembros[i];
+            if (!m->vivo)
+                continue;
+
+            m->stats->seniales_recibidas[SIGSTOP]++;
+            m->stats->num_pausas++;
+            publicar_estado_proceso(slot_telemetria(m->stats), m->pid, TEL_DETENIDO, 0.0);
+            gettimeofday(&m->ultima_parada, NULL);
+            double usado = timeval_diff(&m->inicio_turno, &m->ultima_parada);
+            m->tiempo_acumulado += usado;
+            m->stats->quantum_usado_total += usado;
+
+            if (con_traza)
             {
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Última lectura procesada por %s%s: %d\n",
-                       color_proceso("./proceso3"), nombre_legible("./proceso3"), ultimo_valor_del_turno);
+                usleep(10000);
+                volcar_anillo_traza(&m->traza);
+                unsigned long pc = obtener_pc_riscv(m->ruta_traza);
+                if (nivel_log >= NIVEL_LOG_NORMAL)
+                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s se quedó en el PC: 0x%lx\n" ANSI_RESET,
+                           color_proceso(m->ruta), nombre_legible(m->ruta), pc);
+                publicar_pc_proceso(m->stats, pc);
+            }
+        }
 
-                if (ultimo_valor_del_turno > 90)
-                {
-                    arg_p2_proximo = 1;
-                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activar escudo para la próxima ronda.\n" ANSI_RESET);
-                }
-                else
+        int lectura;
+        if (leer_datos_p3(p3_to_kernel_pipe[0], &lectura) > 0)
+        {
+            decision_escudo = (lectura > UMBRAL_ESCUDO) ? 1 : 0;
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Última lectura procesada por %s%s: %d\n",
+                   color_proceso("./proceso3"), nombre_legible("./proceso3"), lectura);
+        }
+
+        recoger_cola_nucleo(&cola_escudo, 0);
+        rotar_cola_nucleo(&cola_escudo);
+
+        if (escenario == 2 && decision_escudo != -1)
+        {
+            lanzar_escudo_en_nucleo(&cola_escudo, decision_escudo);
+            decision_escudo = -1;
+        }
+    }
+
+    if (decision_escudo != -1)
+        lanzar_escudo_en_nucleo(&cola_escudo, decision_escudo);
+    recoger_cola_nucleo(&cola_escudo, 1);
+
+    close(p3_to_kernel_pipe[0]);
+
+    for (int i = 0; con_traza && i < num_miembros; i++)
+        finalizar_anillo_traza(&miembros[i].traza, miembros[i].ruta);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Ciclo en banda finalizado.\n");
+}
+
+/* Las tuberías corren a la vez, sin turnos. El Escudo no se interrumpe: lo que llega
+   mientras actúa se resuelve en la decisión siguiente. */
+
+#define TAM_BLOQUE_SENSOR 4096
+#define MAX_FILAS_ABANICO 16
+#define PATRON_ENTRADA_SENSOR "sensores/medidas_%d.txt"
+
+typedef struct
+{
+    int valor;
+    double instante;
+} LecturaSensor;
+
+typedef struct
+{
+    char ruta_entrada[64];
+    pid_t pid1;
+    pid_t pid3;
+    int p1_vivo;
+    int p3_vivo;
+    int fd_fuente;
+    int fd_entrada;
+    int fd_datos;
+
+    char bloque[TAM_BLOQUE_SENSOR];
+    int inicio_bloque;
+    int fin_bloque;
+    int valor_en_curso;
+
+    LecturaSensor *lecturas;
+    int num_lecturas;
+    int capacidad_lecturas;
+    int siguiente_registro;
+
+    char registro[MAX_REGISTRO_P3];
+    int largo_registro;
+    int registro_truncado;
+
+    int ultimo_valor;
+    int con_valor;
+    int sobre_umbral;
+
+    int registros;
+    int fechados;
+    int perdidos;
+    int fuera_de_orden;
+    double latencia_total;
+    double latencia_max;
+    double cpu_p1;
+    double cpu_p3;
+    int salida_p1;
+    int salida_p3;
+} TuberiaSensor;
+
+typedef struct
+{
+    int num_sensores;
+    ReglaAbanico regla;
+    int quorum;
+    TuberiaSensor *sensores;
+
+    double tiempo;
+    double lanzamiento;
+    double cpu_kernel;
+    long despertares;
+    int registros;
+    int perdidos;
+    int fuera_de_orden;
+    int actuaciones;
+    int activaciones;
+    EstadisticaOnline latencia_sensor;
+    EstadisticaOnline latencia_decision;
+} ResultadoAbanico;
+
+void lanzar_tuberia_sensor(TuberiaSensor *s, int indice)
+{
+    int entrada[2], intermedia[2], datos[2];
+    struct stat st;
+
+    snprintf(s->ruta_entrada, sizeof(s->ruta_entrada), PATRON_ENTRADA_SENSOR, indice + 1);
+    if (stat(s->ruta_entrada, &st) == -1)
+        snprintf(s->ruta_entrada, sizeof(s->ruta_entrada), "medidas.txt");
+
+    if (pipe(entrada) == -1 || pipe(intermedia) == -1 || pipe(datos) == -1)
+    {
+        perror("Error en pipes del abanico");
+        exit(1);
+    }
+
+    char *argv1[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso1", NULL};
+    ArranqueHuesped arranque1 = {.entrada = entrada[0], .salida = intermedia[1], .nucleo = -1};
+    s->pid1 = lanzar_huesped(argv1, &arranque1, NULL);
+
+    char *argv3[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso3", NULL};
+    ArranqueHuesped arranque3 = {.entrada = intermedia[0], .salida = datos[1], .nucleo = -1};
+    s->pid3 = lanzar_huesped(argv3, &arranque3, NULL);
+
+    close(entrada[0]);
+    close(intermedia[0]);
+    close(intermedia[1]);
+    close(datos[1]);
+
+    s->p1_vivo = s->p3_vivo = 1;
+    s->fd_entrada = entrada[1];
+    s->fd_datos = datos[0];
+    fcntl(s->fd_entrada, F_SETFL, O_NONBLOCK);
+    fcntl(s->fd_datos, F_SETFL, O_NONBLOCK);
+
+    /* Un FIFO también sirve de entrada: el poll no marca su fin hasta que el escritor
+       se conecta y se va. */
+    s->fd_fuente = open(s->ruta_entrada, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (s->fd_fuente == -1)
+        fprintf(stderr, COLOR_ERROR "[Control Central] ERROR: No se puede abrir el archivo de señal %s\n" ANSI_RESET, s->ruta_entrada);
+}
+
+/* P1 puede haber muerto entre el poll y la escritura: el EPIPE se atiende aquí y el
+   SIGPIPE pendiente se descarta, sin cambiar la disposición que heredan los huéspedes. */
+ssize_t escribir_sin_sigpipe(int fd, const void *datos, size_t largo)
+{
+    sigset_t pipe_sig, anterior;
+    struct timespec cero = {0, 0};
+
+    sigemptyset(&pipe_sig);
+    sigaddset(&pipe_sig, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_sig, &anterior);
+    ssize_t escritos = write(fd, datos, largo);
+    if (escritos == -1 && errno == EPIPE)
+    {
+        sigtimedwait(&pipe_sig, NULL, &cero);
+        errno = EPIPE;
+    }
+    pthread_sigmask(SIG_SETMASK, &anterior, NULL);
+    return escritos;
+}
+
+void anotar_lectura_sensor(TuberiaSensor *s, int valor, double instante)
+{
+    if (s->num_lecturas == s->capacidad_lecturas)
+    {
+        int capacidad = s->capacidad_lecturas ? 2 * s->capacidad_lecturas : 64;
+        LecturaSensor *lecturas = realloc(s->lecturas, capacidad * sizeof(LecturaSensor));
+        if (!lecturas)
+            return;
+        s->lecturas = lecturas;
+        s->capacidad_lecturas = capacidad;
+    }
+    s->lecturas[s->num_lecturas++] = (LecturaSensor){.valor = valor, .instante = instante};
+}
+
+/* Cada línea queda fechada al entrar en la tubería. Agotada la fuente, P1 recibe EOF. */
+void bombear_sensor(TuberiaSensor *s, short eventos, double ahora)
+{
+    if ((eventos & (POLLERR | POLLHUP)) && s->inicio_bloque == s->fin_bloque && s->fd_fuente >= 0 &&
+        !(eventos & POLLIN))
+    {
+        close(s->fd_fuente);
+        s->fd_fuente = -1;
+    }
+    else if (s->inicio_bloque == s->fin_bloque && s->fd_fuente >= 0)
+    {
+        ssize_t n = read(s->fd_fuente, s->bloque, sizeof(s->bloque));
+        if (n > 0)
+        {
+            s->inicio_bloque = 0;
+            s->fin_bloque = n;
+        }
+        else if (n == 0 || errno != EAGAIN)
+        {
+            close(s->fd_fuente);
+            s->fd_fuente = -1;
+        }
+    }
+
+    if (s->inicio_bloque < s->fin_bloque && s->fd_entrada >= 0)
+    {
+        ssize_t n = escribir_sin_sigpipe(s->fd_entrada, s->bloque + s->inicio_bloque, s->fin_bloque - s->inicio_bloque);
+        if (n > 0)
+        {
+            for (int i = s->inicio_bloque; i < s->inicio_bloque + n; i++)
+            {
+                if (isdigit((unsigned char)s->bloque[i]))
+                    s->valor_en_curso = s->valor_en_curso * 10 + (s->bloque[i] - '0');
+                else if (s->bloque[i] == '\n')
                 {
-                    arg_p2_proximo = 0;
-                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Desactivar escudo para la próxima ronda.\n" ANSI_RESET);
+                    anotar_lectura_sensor(s, s->valor_en_curso, ahora);
+                    s->valor_en_curso = 0;
                 }
             }
+            s->inicio_bloque += n;
+        }
+        else if (n == -1 && errno != EAGAIN)
+        {
+            s->inicio_bloque = s->fin_bloque;
+            if (s->fd_fuente >= 0)
+                close(s->fd_fuente);
+            s->fd_fuente = -1;
+        }
+    }
+
+    if (s->fd_entrada >= 0 && s->fd_fuente < 0 && s->inicio_bloque == s->fin_bloque)
+    {
+        close(s->fd_entrada);
+        s->fd_entrada = -1;
+    }
+}
+
+void cerrar_registro_sensor(ResultadoAbanico *r, TuberiaSensor *s, double ahora)
+{
+    int valido = !s->registro_truncado;
+
+    s->registro[s->largo_registro] = '\0';
+    s->largo_registro = 0;
+    s->registro_truncado = 0;
+    if (!valido)
+        return;
+
+    int valor = valor_registro_p3(s->registro);
+    s->registros++;
+    s->ultimo_valor = valor;
+    s->con_valor = 1;
+    if (valor > UMBRAL_ESCUDO)
+        s->sobre_umbral = 1;
+
+    for (int i = s->siguiente_registro; i < s->num_lecturas && i < s->siguiente_registro + VENTANA_REGISTROS_P3; i++)
+    {
+        if (s->lecturas[i].valor == valor)
+        {
+            double latencia = ahora - s->lecturas[i].instante;
+            s->perdidos += i - s->siguiente_registro;
+            s->siguiente_registro = i + 1;
+            s->fechados++;
+            s->latencia_total += latencia;
+            if (latencia > s->latencia_max)
+                s->latencia_max = latencia;
+            registrar_estadistica(&r->latencia_sensor, latencia);
+            return;
+        }
+    }
+    s->fuera_de_orden++;
+}
+
+int leer_registros_sensor(ResultadoAbanico *r, TuberiaSensor *s, double ahora)
+{
+    char buffer[4096];
+    int antes = s->registros;
+    ssize_t n;
+
+    while ((n = read(s->fd_datos, buffer, sizeof(buffer))) > 0)
+    {
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (buffer[i] == '\n')
+                cerrar_registro_sensor(r, s, ahora);
+            else if (s->largo_registro < MAX_REGISTRO_P3 - 1)
+                s->registro[s->largo_registro++] = buffer[i];
             else
-            {
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Mantener estado neutro para la próxima ronda (No se recibió un nuevo valor del analizador).\n" ANSI_RESET);
-            }
+                s->registro_truncado = 1;
+        }
+    }
 
-            gettimeofday(&turno_end, NULL);
-            tiempo_acumulado_p3 += timeval_diff(&turno_start, &turno_end);
-            p3_full_stats.quantum_dado_total += TIMEOUT_P3;
+    if (n == 0 || (n == -1 && errno != EAGAIN))
+    {
+        if (s->largo_registro > 0)
+            cerrar_registro_sensor(r, s, ahora);
+        close(s->fd_datos);
+        s->fd_datos = -1;
+    }
+    return s->registros - antes;
+}
+
+/* max: el mayor último valor supera el umbral. cualquiera: alguna lectura recibida desde
+   la decisión anterior lo superó, aunque otra posterior del mismo sensor ya no. quorum:
+   al menos K sensores tienen su último valor por encima. */
+int decision_abanico(ResultadoAbanico *r)
+{
+    int maximo = INT_MIN, sobre_umbral = 0, alguna = 0;
+
+    for (int i = 0; i < r->num_sensores; i++)
+    {
+        TuberiaSensor *s = &r->sensores[i];
+        if (s->con_valor)
+        {
+            if (s->ultimo_valor > maximo)
+                maximo = s->ultimo_valor;
+            sobre_umbral += s->ultimo_valor > UMBRAL_ESCUDO;
+        }
+        alguna |= s->sobre_umbral;
+        s->sobre_umbral = 0;
+    }
+
+    if (r->regla == REGLA_CUALQUIERA)
+        return alguna;
+    if (r->regla == REGLA_QUORUM)
+        return sobre_umbral >= r->quorum;
+    return maximo > UMBRAL_ESCUDO;
+}
+
+int recoger_huesped_sensor(pid_t pid, int *vivo, double *cpu, int *salida)
+{
+    struct rusage uso;
+    int status;
+
+    if (!*vivo || sondear_hijo(pid, &status, &uso) != pid)
+        return 0;
+    *vivo = 0;
+    *cpu = cpu_rusage(&uso);
+    *salida = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    return 1;
+}
+
+void ejecutar_abanico_sensores(ResultadoAbanico *r)
+{
+    struct rlimit limite;
+    struct rusage uso_inicio, uso_fin;
+
+    /* Tres descriptores por sensor más los del kernel: 256 sensores no caben en 1024. */
+    if (getrlimit(RLIMIT_NOFILE, &limite) == 0 && limite.rlim_cur < limite.rlim_max)
+    {
+        limite.rlim_cur = limite.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limite);
+    }
+
+    iniciar_estadistica(&r->latencia_sensor, ESCALA_SEGUNDOS);
+    iniciar_estadistica(&r->latencia_decision, ESCALA_SEGUNDOS);
+    r->num_sensores = num_sensores;
+    r->regla = regla_abanico;
+    r->quorum = quorum_abanico > 0 ? quorum_abanico : num_sensores / 2 + 1;
+    if (r->quorum > num_sensores)
+        r->quorum = num_sensores;
+    r->despertares = r->registros = r->perdidos = r->fuera_de_orden = r->actuaciones = r->activaciones = 0;
+
+    r->sensores = calloc(num_sensores, sizeof(TuberiaSensor));
+    struct pollfd *pfds = malloc((3 * num_sensores + 1) * sizeof(struct pollfd));
+    int *duenos = malloc((3 * num_sensores + 1) * sizeof(int));
+    if (!r->sensores || !pfds || !duenos)
+    {
+        perror("Error reservando el abanico de sensores");
+        exit(1);
+    }
+
+    getrusage(RUSAGE_SELF, &uso_inicio);
+    double inicio = tiempo_monotonico();
+    for (int i = 0; i < num_sensores; i++)
+        lanzar_tuberia_sensor(&r->sensores[i], i);
+    r->lanzamiento = tiempo_monotonico() - inicio;
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Abanico de %d sensores (regla %s): %d huéspedes lanzados en %.3f s. Iniciando...\n",
+           num_sensores, NOMBRES_REGLAS_ABANICO[r->regla], 2 * num_sensores, r->lanzamiento);
+
+    pid_t pid2 = 0;
+    int pidfd2 = -1;
+    double inicio_escudo = 0.0, pendiente_desde = 0.0, cubierto_desde = 0.0;
+    int vivos = 2 * num_sensores;
 
-            if (wait4(pid3, &p3_status, WNOHANG, &usage_temp) == pid3)
+    while (vivos > 0 || pid2 > 0 || pendiente_desde > 0.0)
+    {
+        int num_pfds = 0, cerrando = 0;
+
+        for (int i = 0; i < num_sensores; i++)
+        {
+            TuberiaSensor *s = &r->sensores[i];
+            if (s->inicio_bloque == s->fin_bloque && s->fd_fuente >= 0)
             {
-                p3_vivo = 0;
-                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &turno_end);
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó.\n",
-                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
-                guardar_stats_proceso("./code/escenariosBasicos/proceso3", pid3, tiempo_acumulado_p3, &usage_temp, p3_status);
+                pfds[num_pfds] = (struct pollfd){.fd = s->fd_fuente, .events = POLLIN};
+                duenos[num_pfds++] = i;
+            }
+            else if (s->fd_entrada >= 0)
+            {
+                pfds[num_pfds] = (struct pollfd){.fd = s->fd_entrada, .events = POLLOUT};
+                duenos[num_pfds++] = i;
+            }
+            if (s->fd_datos >= 0)
+            {
+                pfds[num_pfds] = (struct pollfd){.fd = s->fd_datos, .events = POLLIN};
+                duenos[num_pfds++] = i;
+            }
+            else if (s->p1_vivo || s->p3_vivo)
+            {
+                cerrando++;
+            }
+        }
+        if (pidfd2 >= 0)
+        {
+            pfds[num_pfds] = (struct pollfd){.fd = pidfd2, .events = POLLIN};
+            duenos[num_pfds++] = -1;
+        }
 
-                if (p1_vivo)
-                {
-                    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Terminó %s%s. Forzando terminación de %s%s (PID %d)...\n",
-                           color_proceso("./proceso3"), nombre_legible("./proceso3"),
-                           color_proceso("./proceso1"), nombre_legible("./proceso1"), pid1);
-                    kill(pid1, SIGKILL);
-                    p1_full_stats.seniales_recibidas[SIGKILL]++;
-                    wait4(pid1, &p1_status, 0, &usage_temp);
+        /* Los que ya cerraron su salida se recogen por sondeo; el Escudo, por su pidfd. */
+        if (poll(pfds, num_pfds, cerrando > 0 ? EDF_TRAMO_SONDEO_MS : INTERVALO_MENU_MS) > 0)
+            r->despertares++;
+        double ahora = tiempo_monotonico();
 
-                    guardar_stats_proceso("./code/escenariosBasicos/proceso1", pid1, tiempo_acumulado_p1, &usage_temp, p1_status);
-                    p1_vivo = 0;
-                }
+        for (int p = 0; p < num_pfds; p++)
+        {
+            if (!pfds[p].revents || duenos[p] < 0)
+                continue;
+            TuberiaSensor *s = &r->sensores[duenos[p]];
+            if (pfds[p].fd == s->fd_datos)
+            {
+                if (leer_registros_sensor(r, s, ahora) > 0 && pendiente_desde == 0.0)
+                    pendiente_desde = ahora;
             }
             else
             {
-                printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
-                       color_proceso("./proceso3"), nombre_legible("./proceso3"), pid3);
-                kill(pid3, SIGSTOP);
-                p3_full_stats.seniales_recibidas[SIGSTOP]++;
-                gettimeofday(&p3_last_stop_time, NULL);
-                p3_full_stats.num_pausas++;
-                p3_full_stats.quantum_usado_total += timeval_diff(&p3_turn_start, &p3_last_stop_time);
+                bombear_sensor(s, pfds[p].revents, ahora);
+            }
+        }
+
+        for (int i = 0; i < num_sensores; i++)
+        {
+            TuberiaSensor *s = &r->sensores[i];
+            if (s->fd_datos >= 0 || !(s->p1_vivo || s->p3_vivo))
+                continue;
+            vivos -= recoger_huesped_sensor(s->pid1, &s->p1_vivo, &s->cpu_p1, &s->salida_p1);
+            vivos -= recoger_huesped_sensor(s->pid3, &s->p3_vivo, &s->cpu_p3, &s->salida_p3);
+        }
+
+        if (pid2 > 0)
+        {
+            struct rusage uso;
+            int status;
+            if (sondear_hijo(pid2, &status, &uso) == pid2)
+            {
+                double fin = tiempo_monotonico();
+                registrar_estadistica(&r->latencia_decision, fin - cubierto_desde);
+                guardar_stats_proceso("./code/escenariosBasicos/proceso2", pid2, fin - inicio_escudo, &uso, status);
+                close(pidfd2);
+                pidfd2 = -1;
+                pid2 = 0;
             }
         }
+
+        if (pid2 == 0 && pendiente_desde > 0.0)
+        {
+            int activar = decision_abanico(r);
+            char argumento[2] = {activar ? '1' : '0', '\0'};
+            char *args[] = {"qemu-riscv32", "./code/escenariosBasicos/proceso2", argumento, NULL};
+            ArranqueHuesped arranque2 = {.entrada = -1, .salida = -1, .nucleo = -1};
+
+            inicio_escudo = tiempo_monotonico();
+            pid2 = lanzar_huesped(args, &arranque2, &p2_full_stats);
+            pidfd2 = abrir_pidfd(pid2);
+            cubierto_desde = pendiente_desde;
+            pendiente_desde = 0.0;
+            r->actuaciones++;
+            r->activaciones += activar;
+        }
+
+        atender_canales();
     }
 
-    close(p3_to_kernel_pipe[0]);
+    r->tiempo = tiempo_monotonico() - inicio;
+    getrusage(RUSAGE_SELF, &uso_fin);
+    r->cpu_kernel = cpu_rusage(&uso_fin) - cpu_rusage(&uso_inicio);
 
-    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Ciclo finalizado.\n");
+    for (int i = 0; i < num_sensores; i++)
+    {
+        TuberiaSensor *s = &r->sensores[i];
+        /* Lo que P3 nunca entregó también cuenta como perdido. */
+        s->perdidos += s->num_lecturas - s->siguiente_registro;
+        r->registros += s->registros;
+        r->perdidos += s->perdidos;
+        r->fuera_de_orden += s->fuera_de_orden;
+    }
+
+    free(pfds);
+    free(duenos);
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Abanico de sensores finalizado.\n");
 }
 
-void ejecutar_escenario_4()
+void mostrar_abanico(const ResultadoAbanico *r)
 {
-    pid_t pid1;
-    int p1_input_pipe[2];
-    if (pipe(p1_input_pipe) == -1)
+    printf(COLOR_TABLE "\n--- Abanico de Sensores del Ciclo ---\n");
+    printf("| %-6s | %-24s | %-8s | %-8s | %-8s | %-9s | %-8s | %-7s | %-13s | %-12s | %-11s |\n",
+           "Sensor", "Entrada", "PID P1", "PID P3", "Lecturas", "Registros", "Perdidos", "F.orden",
+           "Lat.media(ms)", "Lat.max(ms)", "CPU P1+P3");
+    for (int i = 0; i < r->num_sensores && i < MAX_FILAS_ABANICO; i++)
     {
-        perror("pipe");
-        exit(1);
+        const TuberiaSensor *s = &r->sensores[i];
+        printf("| %-6d | %-24s | %-8d | %-8d | %-8d | %-9d | %-8d | %-7d | %-13.3f | %-12.3f | %-11.4f |\n",
+               i + 1, s->ruta_entrada, s->pid1, s->pid3, s->num_lecturas, s->registros, s->perdidos, s->fuera_de_orden,
+               s->fechados > 0 ? s->latencia_total / s->fechados * 1000.0 : 0.0, s->latencia_max * 1000.0,
+               s->cpu_p1 + s->cpu_p3);
+    }
+    if (r->num_sensores > MAX_FILAS_ABANICO)
+        printf("  ... %d sensores más en metricas_abanico.json\n", r->num_sensores - MAX_FILAS_ABANICO);
+
+    printf("  - Sensores: %d, regla %s", r->num_sensores, NOMBRES_REGLAS_ABANICO[r->regla]);
+    if (r->regla == REGLA_QUORUM)
+        printf(" (%d de %d)", r->quorum, r->num_sensores);
+    printf("; huéspedes lanzados en %.3f s\n", r->lanzamiento);
+    printf("  - Registros recibidos / perdidos / fuera de orden: %d / %d / %d (%.1f registros/s)\n",
+           r->registros, r->perdidos, r->fuera_de_orden, r->tiempo > 0.0 ? r->registros / r->tiempo : 0.0);
+    printf("  - Escudo: %d actuaciones (%d activaciones), %.1f registros por actuación\n",
+           r->actuaciones, r->activaciones, r->actuaciones > 0 ? (double)r->registros / r->actuaciones : 0.0);
+    printf("  - Latencia entrada -> kernel (p50 / p99 / máx): %.3f / %.3f / %.3f ms\n",
+           percentil_estadistica(&r->latencia_sensor, 0.50) * 1000.0,
+           percentil_estadistica(&r->latencia_sensor, 0.99) * 1000.0, r->latencia_sensor.maximo * 1000.0);
+    printf("  - Latencia registro -> Escudo (p50 / p99 / máx): %.3f / %.3f / %.3f ms\n",
+           percentil_estadistica(&r->latencia_decision, 0.50) * 1000.0,
+           percentil_estadistica(&r->latencia_decision, 0.99) * 1000.0, r->latencia_decision.maximo * 1000.0);
+    printf("  - Kernel: %.4f s de CPU (%.1f µs por registro), %ld despertares de poll\n" ANSI_RESET,
+           r->cpu_kernel, r->registros > 0 ? r->cpu_kernel / r->registros * 1e6 : 0.0, r->despertares);
+    fflush(stdout);
+}
+
+void exportar_abanico_a_json(const ResultadoAbanico *r)
+{
+    char *elemento = NULL;
+    size_t largo_elemento = 0;
+    FILE *fp = open_memstream(&elemento, &largo_elemento);
+    if (fp == NULL)
+    {
+        perror(COLOR_ERROR "Error al crear metricas_abanico.json" ANSI_RESET);
+        return;
+    }
+
+    fprintf(fp, "\t{\n");
+    fprintf(fp, "\t\t\"ciclo\": %d,\n", ciclo_actual);
+    fprintf(fp, "\t\t\"sensores\": %d,\n", r->num_sensores);
+    fprintf(fp, "\t\t\"regla\": \"%s\",\n", NOMBRES_REGLAS_ABANICO[r->regla]);
+    fprintf(fp, "\t\t\"quorum\": %d,\n", r->quorum);
+    fprintf(fp, "\t\t\"tiempo\": %.6f,\n", r->tiempo);
+    fprintf(fp, "\t\t\"lanzamiento\": %.6f,\n", r->lanzamiento);
+    fprintf(fp, "\t\t\"registros\": %d,\n", r->registros);
+    fprintf(fp, "\t\t\"registros_perdidos\": %d,\n", r->perdidos);
+    fprintf(fp, "\t\t\"registros_fuera_de_orden\": %d,\n", r->fuera_de_orden);
+    fprintf(fp, "\t\t\"registros_por_segundo\": %.3f,\n", r->tiempo > 0.0 ? r->registros / r->tiempo : 0.0);
+    fprintf(fp, "\t\t\"actuaciones\": %d,\n", r->actuaciones);
+    fprintf(fp, "\t\t\"activaciones\": %d,\n", r->activaciones);
+    fprintf(fp, "\t\t\"cpu_kernel\": %.6f,\n", r->cpu_kernel);
+    fprintf(fp, "\t\t\"despertares\": %ld,\n", r->despertares);
+    fprintf(fp, "\t\t\"latencia_entrada_kernel\": {\"p50\": %.6f, \"p99\": %.6f, \"max\": %.6f},\n",
+            percentil_estadistica(&r->latencia_sensor, 0.50), percentil_estadistica(&r->latencia_sensor, 0.99),
+            r->latencia_sensor.maximo);
+    fprintf(fp, "\t\t\"latencia_registro_escudo\": {\"p50\": %.6f, \"p99\": %.6f, \"max\": %.6f},\n",
+            percentil_estadistica(&r->latencia_decision, 0.50), percentil_estadistica(&r->latencia_decision, 0.99),
+            r->latencia_decision.maximo);
+    fprintf(fp, "\t\t\"tuberias\": [\n");
+    for (int i = 0; i < r->num_sensores; i++)
+    {
+        const TuberiaSensor *s = &r->sensores[i];
+        fprintf(fp, "\t\t\t{\"sensor\": %d, \"entrada\": \"%s\", \"pid_p1\": %d, \"pid_p3\": %d, \"lecturas\": %d, "
+                    "\"registros\": %d, \"perdidos\": %d, \"fuera_de_orden\": %d, \"latencia_media\": %.6f, "
+                    "\"latencia_max\": %.6f, \"cpu_p1\": %.6f, \"cpu_p3\": %.6f, \"salida_p1\": %d, \"salida_p3\": %d}%s\n",
+                i + 1, s->ruta_entrada, s->pid1, s->pid3, s->num_lecturas, s->registros, s->perdidos, s->fuera_de_orden,
+                s->fechados > 0 ? s->latencia_total / s->fechados : 0.0, s->latencia_max, s->cpu_p1, s->cpu_p3,
+                s->salida_p1, s->salida_p3, i < r->num_sensores - 1 ? "," : "");
+    }
+    fprintf(fp, "\t\t]\n");
+    fprintf(fp, "\t}\n]");
+    fclose(fp);
+
+    if (anexar_json_es("metricas_abanico.json", elemento, largo_elemento, COLOR_ERROR "Error al crear metricas_abanico.json" ANSI_RESET))
+        perror(COLOR_ERROR "Error al crear metricas_abanico.json" ANSI_RESET);
+}
+
+void liberar_abanico(ResultadoAbanico *r)
+{
+    for (int i = 0; i < r->num_sensores; i++)
+        free(r->sensores[i].lecturas);
+    free(r->sensores);
+    r->sensores = NULL;
+}
+
+void ejecutar_escenario_abanico()
+{
+    static ResultadoAbanico resultado;
+
+    ejecutar_abanico_sensores(&resultado);
+    mostrar_abanico(&resultado);
+    TramoKernel previo = entrar_tramo(TRAMO_JSON);
+    exportar_abanico_a_json(&resultado);
+    salir_tramo(previo);
+    liberar_abanico(&resultado);
+}
+
+void ejecutar_escenario()
+{
+    if (topologias[escenario_actual])
+    {
+        printf(COLOR_CICLO "--- Escenario %d: topología de %s ---\n" ANSI_RESET, escenario_actual, topologias[escenario_actual]->ruta);
+        ejecutar_topologia(topologias[escenario_actual]);
+    }
+    else
+    {
+        switch (escenario_actual)
+        {
+        case 1:
+            printf(COLOR_CICLO "--- Escenario 1: [Receptor] -> [Escudo] -> [Analizador] ---\n" ANSI_RESET);
+            ejecutar_escenario_1();
+            break;
+        case 2:
+            if (num_sensores > 0)
+            {
+                printf(COLOR_CICLO "--- Escenario 2 (Abanico): %d x [Receptor -> Analizador] -> [Escudo] ---\n" ANSI_RESET, num_sensores);
+                ejecutar_escenario_abanico();
+            }
+            else if (politica_actual == POLITICA_GANG)
+            {
+                printf(COLOR_CICLO "--- Escenario 2 (Gang): [Receptor || Analizador] -> [Escudo] ---\n" ANSI_RESET);
+                ejecutar_escenario_gang(2);
+            }
+            else
+            {
+                printf(COLOR_CICLO "--- Escenario 2: [Receptor] -> [Analizador] -> [Escudo] ---\n" ANSI_RESET);
+                ejecutar_escenario_2();
+            }
+            break;
+        case 3:
+            if (politica_actual == POLITICA_EDF)
+            {
+                printf(COLOR_CICLO "--- Escenario 3 (EDF): [Receptor] + [Analizador] -> [Escudo] con plazos ---\n" ANSI_RESET);
+                ejecutar_escenario_3_edf();
+            }
+            else if (politica_actual == POLITICA_GANG)
+            {
+                printf(COLOR_CICLO "--- Escenario 3 (Gang): [Escudo] -> [Receptor || Analizador] ---\n" ANSI_RESET);
+                ejecutar_escenario_gang(3);
+            }
+            else
+            {
+                printf(COLOR_CICLO "--- Escenario 3: [Escudo] -> [Receptor] -> [Analizador] ---\n" ANSI_RESET);
+                ejecutar_escenario_3();
+            }
+            break;
+        case 4:
+            printf(COLOR_CICLO "--- Escenario 4: Syscall automatico ---\n" ANSI_RESET);
+            ejecutar_escenario_4();
+            break;
+        default:
+            printf(COLOR_ERROR "[Control Central] Error: Escenario de ejecución no válido." ANSI_RESET "\n");
+            break;
+        }
     }
-    if ((pid1 = fork()) == 0)
-    {
-        close(p1_input_pipe[1]);
-        dup2(p1_input_pipe[0], STDIN_FILENO);
-        close(p1_input_pipe[0]);
 
-        char *argv[] = {"qemu-riscv32", "./code/escenariosSyscall/proceso1", NULL};
-        lanzar_hijo_exec(argv);
-    }
-    close(p1_input_pipe[0]);
-    enviar_contenido_archivo_a_pipe(p1_input_pipe[1], "medidas.txt");
-    close(p1_input_pipe[1]);
-    gettimeofday(&p1_start, NULL);
-    esperar_proceso(pid1, "./code/escenariosSyscall/proceso1", 0, &p1_start);
+    consolidar_traza_lecturas();
 }
 
-void ejecutar_escenario()
+/* SIGTSTP solo deja la petición: el reinicio se hace en la frontera de ciclo. */
+void solicitar_reinicio(int sig)
 {
-    switch (escenario_actual)
-    {
-    case 1:
-        printf(COLOR_CICLO "--- Escenario 1: [Receptor] -> [Escudo] -> [Analizador] ---\n" ANSI_RESET);
-        ejecutar_escenario_1();
-        break;
-    case 2:
-        printf(COLOR_CICLO "--- Escenario 2: [Receptor] -> [Analizador] -> [Escudo] ---\n" ANSI_RESET);
-        ejecutar_escenario_2();
-        break;
-    case 3:
-        printf(COLOR_CICLO "--- Escenario 3: [Escudo] -> [Receptor] -> [Analizador] ---\n" ANSI_RESET);
-        ejecutar_escenario_3();
-        break;
-    case 4:
-        printf(COLOR_CICLO "--- Escenario 4: Syscall automatico ---\n" ANSI_RESET);
-        ejecutar_escenario_4();
-        break;
-    default:
-        printf(COLOR_ERROR "[Control Central] Error: Escenario de ejecución no válido." ANSI_RESET "\n");
-        break;
-    }
+    (void)sig;
+    reinicio_solicitado = 1;
 }
 
 void reiniciar_escenario()
@@ -1032,6 +5209,7 @@ void reiniciar_escenario()
     system("clear");
     printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Reinicio de escenario solicitado (SIGTSTP). Seleccione nuevo escenario." ANSI_RESET "\n");
     escenario_actual = 0;
+    descartar_prelanzamiento();
     ciclo_actual = 1;
 
     memset(&acumulador_global, 0, sizeof(AcumuladorMetricas));
@@ -1059,8 +5237,115 @@ void acumular_metricas_ciclo(double tiempo_total_ciclo)
            ciclo_actual - 1, acumulador_global.total_ciclos_acumulados, CICLOS_POR_REPORTE);
 }
 
+void mostrar_resumen_latencia()
+{
+    FASE_KERNEL(FASE_INFORME_CONSOLA);
+    const ResumenLatencia *resumen = &resumen_latencia_ciclo;
+
+    if (resumen->lecturas == 0)
+        return;
+
+    printf(COLOR_TABLE "\n--- Latencia Sensor -> Escudo del Ciclo ---\n");
+    printf("  - Lecturas trazadas / actuadas: %d / %d\n", resumen->lecturas, resumen->actuadas);
+    if (resumen->registros_p3 > 0 || resumen->registros_perdidos > 0)
+        printf("  - Registros de P3 recibidos / perdidos / fuera de orden: %d / %d / %d\n",
+               resumen->registros_p3, resumen->registros_perdidos, resumen->registros_fuera_de_orden);
+    if (resumen->actuadas > 0)
+        printf("  - Extremo a extremo (media / máx): %.6f s / %.6f s\n", resumen->extremo_medio, resumen->extremo_max);
+    if (resumen->criticas > 0)
+        printf("  - Lecturas > %d actuadas: %d (máx %.6f s)\n", UMBRAL_ESCUDO, resumen->criticas, resumen->critica_max);
+    printf(ANSI_RESET);
+    fflush(stdout);
+}
+
+void imprimir_fila_estadistica(const char *nombre, const EstadisticaOnline *e)
+{
+    if (e->muestras == 0)
+    {
+        printf("| %-40s | %-8d | %-11s | %-11s | %-11s | %-11s | %-11s | %-11s | %-11s |\n",
+               nombre, 0, "-", "-", "-", "-", "-", "-", "-");
+        return;
+    }
+    printf("| %-40s | %-8ld | %-11.6f | %-11.6f | %-11.6f | %-11.6f | %-11.6f | %-11.6f | %-11.6f |\n",
+           nombre, e->muestras, e->media, desviacion_estadistica(e), e->minimo,
+           percentil_estadistica(e, 0.50), percentil_estadistica(e, 0.99),
+           percentil_estadistica(e, 0.999), e->maximo);
+}
+
+void imprimir_estadisticas_escenario()
+{
+    if (escenario_actual < 1 || escenario_actual > 4)
+        return;
+
+    EstadisticasEscenario *est = &estadisticas_escenario[escenario_actual];
+    EstadisticaOnline *hist = latencias_escenario[escenario_actual];
+    const char *procesos[3] = {"proceso1", "proceso2", "proceso3"};
+    char nombre[64];
+
+    printf(COLOR_TABLE "\n--- Estadísticas del Escenario %d (toda la ejecución) ---\n", escenario_actual);
+    printf("| Métrica                                  | Muestras | Media       | Desv.       | Mín         | p50         | p99         | p99.9       | Máx         |\n");
+    printf("|------------------------------------------|----------|-------------|-------------|-------------|-------------|-------------|-------------|-------------|\n");
+    imprimir_fila_estadistica("tiempo_ciclo (s)", &est->tiempo_ciclo);
+    imprimir_fila_estadistica("tiempo_muerto_kernel (s)", &est->tiempo_muerto);
+    imprimir_fila_estadistica("cpu_kernel (s)", &est->cpu_kernel);
+    imprimir_fila_estadistica("sobrepaso_quantum (s)", &est->sobrepaso_quantum);
+    imprimir_fila_estadistica("lanzamiento_huesped (s)", &est->lanzamiento);
+    imprimir_fila_estadistica("arranque_retenido (s)", &est->arranque);
+    for (int p = 0; p < 3; p++)
+    {
+        for (int m = 0; m < NUM_METRICAS_PROCESO; m++)
+        {
+            snprintf(nombre, sizeof(nombre), "%s.%s", procesos[p], NOMBRES_METRICAS_PROCESO[m]);
+            imprimir_fila_estadistica(nombre, &est->proceso[p][m]);
+        }
+    }
+    for (int t = 0; t < NUM_TRAMOS; t++)
+    {
+        snprintf(nombre, sizeof(nombre), "latencia.%s (s)", NOMBRES_TRAMOS[t]);
+        imprimir_fila_estadistica(nombre, &hist[t]);
+    }
+    printf(ANSI_RESET);
+    fflush(stdout);
+}
+
+void actualizar_estadisticas_escenario(const CicloResultado *res)
+{
+    if (res->escenario < 1 || res->escenario > 4)
+        return;
+
+    EstadisticasEscenario *est = &estadisticas_escenario[res->escenario];
+    const ProcesoStats *procesos[3] = {&res->p1_stats, &res->p2_stats, &res->p3_stats};
+
+    registrar_estadistica(&est->tiempo_ciclo, res->tiempo_total_ciclo);
+    registrar_estadistica(&est->tiempo_muerto, res->tiempo_muerto_kernel);
+    registrar_estadistica(&est->cpu_kernel, res->coste.cpu_usuario + res->coste.cpu_sistema);
+
+    for (int p = 0; p < 3; p++)
+    {
+        const ProcesoStats *stats = procesos[p];
+        if (stats->time_real == 0.0)
+            continue;
+
+        registrar_estadistica(&est->proceso[p][METRICA_CPU], stats->tiempo_ejecucion_efectiva);
+        registrar_estadistica(&est->proceso[p][METRICA_MEMORIA_PICO], stats->ru_maxrss);
+        if (stats->quantum_dado_total > 0.0)
+            registrar_estadistica(&est->proceso[p][METRICA_UTILIZACION_QUANTUM],
+                                  stats->quantum_usado_total / stats->quantum_dado_total);
+
+        TotalesProceso *totales = &est->totales[p];
+        totales->cpu += stats->tiempo_ejecucion_efectiva;
+        totales->quantum_dado += stats->quantum_dado_total;
+        totales->quantum_usado += stats->quantum_usado_total;
+        totales->cambios_voluntarios += stats->cambios_contexto_voluntario;
+        totales->cambios_involuntarios += stats->cambios_contexto_involuntario;
+        totales->pausas += stats->num_pausas;
+        totales->instancias += stats->instancias > 0 ? stats->instancias : 1;
+    }
+}
+
 void imprimir_reporte_acumulado()
 {
+    FASE_KERNEL(FASE_INFORME_CONSOLA);
     double cpu_total = acumulador_global.cpu_usuario_total + acumulador_global.cpu_sistema_total;
 
     printf(COLOR_ACUMULADO "\n======================================================\n");
@@ -1074,11 +5359,14 @@ void imprimir_reporte_acumulado()
     printf("• Memoria Total (Suma de Picos): %ld KB\n", acumulador_global.memoria_pico_total_kb);
     printf(COLOR_ACUMULADO "======================================================\n" ANSI_RESET);
 
+    imprimir_estadisticas_escenario();
+
     memset(&acumulador_global, 0, sizeof(AcumuladorMetricas));
 }
 
 void imprimir_metricas_rr()
 {
+    FASE_KERNEL(FASE_INFORME_CONSOLA);
     printf(COLOR_TABLE "\n--- Métricas Avanzadas de Ejecución (E2/E3) ---\n");
 
     if (pid_p1 > 0)
@@ -1101,6 +5389,19 @@ void imprimir_metricas_rr()
     fflush(stdout);
 }
 
+void escribir_json_edf(FILE *fp, const char *sangria, const ProcesoStats *stats)
+{
+    int cumplidos = stats->edf_activaciones - stats->edf_plazos_perdidos;
+
+    fprintf(fp, "%s\"edf_activaciones\": %d,\n", sangria, stats->edf_activaciones);
+    fprintf(fp, "%s\"edf_plazos_perdidos\": %d,\n", sangria, stats->edf_plazos_perdidos);
+    fprintf(fp, "%s\"edf_retraso_max\": %.6f,\n", sangria, stats->edf_retraso_max);
+    fprintf(fp, "%s\"edf_retraso_medio\": %.6f,\n", sangria,
+            stats->edf_plazos_perdidos > 0 ? stats->edf_retraso_total / stats->edf_plazos_perdidos : 0.0);
+    fprintf(fp, "%s\"edf_holgura_min\": %.6f,\n", sangria, stats->edf_holgura_min);
+    fprintf(fp, "%s\"edf_holgura_media\": %.6f", sangria, cumplidos > 0 ? stats->edf_holgura_total / cumplidos : 0.0);
+}
+
 void escribir_json_stats(FILE *fp, const char *nombre, ProcesoStats *stats, int primer_proceso)
 {
     if (!primer_proceso)
@@ -1120,41 +5421,84 @@ void escribir_json_stats(FILE *fp, const char *nombre, ProcesoStats *stats, int
         fprintf(fp, "\t\t\t\"num_pausas\": %d,\n", stats->num_pausas);
         fprintf(fp, "\t\t\t\"tiempo_pausado_total\": %.6f,\n", stats->tiempo_pausado_total);
         fprintf(fp, "\t\t\t\"quantum_dado\": %.6f,\n", stats->quantum_dado_total);
-        fprintf(fp, "\t\t\t\"quantum_usado\": %.6f\n", stats->quantum_usado_total);
+        fprintf(fp, "\t\t\t\"quantum_usado\": %.6f", stats->quantum_usado_total);
     }
-    else
+
+    if (stats->edf_activaciones > 0)
+    {
+        fprintf(fp, ",\n");
+        escribir_json_edf(fp, "\t\t\t", stats);
+    }
+
+    if (stats->completados > 0)
+    {
+        fprintf(fp, ",\n");
+        fprintf(fp, "\t\t\t\"completados\": %d,\n", stats->completados);
+        fprintf(fp, "\t\t\t\"retorno_medio\": %.6f,\n", stats->retorno_total / stats->completados);
+        fprintf(fp, "\t\t\t\"respuesta_media\": %.6f,\n", stats->respuesta_total / stats->completados);
+        fprintf(fp, "\t\t\t\"espera_total\": %.6f", stats->espera_total);
+    }
+
+    if (stats->instancias > 0)
+    {
+        fprintf(fp, ",\n");
+        fprintf(fp, "\t\t\t\"instancias\": %d", stats->instancias);
+    }
+
+    if (stats->turnos_omitidos > 0 || stats->turnos_acortados > 0)
     {
-        fprintf(fp, "\n");
+        fprintf(fp, ",\n");
+        fprintf(fp, "\t\t\t\"turnos_omitidos\": %d,\n", stats->turnos_omitidos);
+        fprintf(fp, "\t\t\t\"turnos_acortados\": %d,\n", stats->turnos_acortados);
+        fprintf(fp, "\t\t\t\"tiempo_ocioso_evitado\": %.6f", stats->tiempo_ocioso_evitado);
     }
 
+    fprintf(fp, "\n");
     fprintf(fp, "\t\t}");
 }
 
+void escribir_json_estadistica(FILE *fp, const char *sangria, const char *nombre, const EstadisticaOnline *e, int primero)
+{
+    if (!primero)
+        fprintf(fp, ",\n");
+
+    fprintf(fp, "%s\"%s\": {\n", sangria, nombre);
+    fprintf(fp, "%s\t\"muestras\": %ld,\n", sangria, e->muestras);
+    fprintf(fp, "%s\t\"media\": %.6f,\n", sangria, e->media);
+    fprintf(fp, "%s\t\"desviacion\": %.6f,\n", sangria, desviacion_estadistica(e));
+    fprintf(fp, "%s\t\"min\": %.6f,\n", sangria, e->minimo);
+    fprintf(fp, "%s\t\"p50\": %.6f,\n", sangria, percentil_estadistica(e, 0.50));
+    fprintf(fp, "%s\t\"p90\": %.6f,\n", sangria, percentil_estadistica(e, 0.90));
+    fprintf(fp, "%s\t\"p99\": %.6f,\n", sangria, percentil_estadistica(e, 0.99));
+    fprintf(fp, "%s\t\"p999\": %.6f,\n", sangria, percentil_estadistica(e, 0.999));
+    fprintf(fp, "%s\t\"max\": %.6f,\n", sangria, e->maximo);
+
+    fprintf(fp, "%s\t\"cubetas\": [", sangria);
+    int primera = 1;
+    for (int i = 0; i < HDR_NUM_CUBETAS; i++)
+    {
+        if (e->cubetas[i] == 0)
+            continue;
+        fprintf(fp, "%s[%g, %ld]", primera ? "" : ", ", valor_cubeta_hdr(i, e->escala), e->cubetas[i]);
+        primera = 0;
+    }
+    fprintf(fp, "]\n");
+    fprintf(fp, "%s}", sangria);
+}
+
 void exportar_reporte_acumulado_a_json()
 {
+    FASE_KERNEL(FASE_EXPORTAR_JSON);
     char nombre_archivo[64];
     snprintf(nombre_archivo, sizeof(nombre_archivo), "metricas_total_%d.json", escenario_actual);
 
-    FILE *fp = fopen(nombre_archivo, "r+");
-
-    if (fp == NULL)
-    {
-        fp = fopen(nombre_archivo, "w");
-        if (!fp)
-        {
-            fprintf(stderr, COLOR_ERROR "Error al abrir %s\n" ANSI_RESET, nombre_archivo);
-            return;
-        }
-        fprintf(fp, "[\n");
-    }
-    else
+    char *elemento = NULL;
+    size_t largo_elemento = 0;
+    FILE *fp = open_memstream(&elemento, &largo_elemento);
+    if (!fp)
     {
-        fseek(fp, 0, SEEK_END);
-        if (ftell(fp) > 2)
-        {
-            fseek(fp, -2, SEEK_END);
-            fprintf(fp, ",\n");
-        }
+        fprintf(stderr, COLOR_ERROR "Error al abrir %s\n" ANSI_RESET, nombre_archivo);
+        return;
     }
 
     double cpu_total = acumulador_global.cpu_usuario_total + acumulador_global.cpu_sistema_total;
@@ -1167,43 +5511,55 @@ void exportar_reporte_acumulado_a_json()
     fprintf(fp, "\t\t\"tiempo_total_cpu\": %.6f,\n", cpu_total);
     fprintf(fp, "\t\t\"cpu_usuario_acumulado\": %.6f,\n", acumulador_global.cpu_usuario_total);
     fprintf(fp, "\t\t\"cpu_sistema_acumulado\": %.6f,\n", acumulador_global.cpu_sistema_total);
-    fprintf(fp, "\t\t\"memoria_pico_total_kb\": %ld\n", acumulador_global.memoria_pico_total_kb);
+    fprintf(fp, "\t\t\"memoria_pico_total_kb\": %ld,\n", acumulador_global.memoria_pico_total_kb);
+
+    fprintf(fp, "\t\t\"latencias\": {\n");
+    for (int t = 0; t < NUM_TRAMOS; t++)
+        escribir_json_estadistica(fp, "\t\t\t", NOMBRES_TRAMOS[t], &latencias_escenario[escenario_actual][t], t == 0);
+    fprintf(fp, "\n\t\t},\n");
+
+    EstadisticasEscenario *est = &estadisticas_escenario[escenario_actual];
+    const char *procesos[3] = {"proceso1", "proceso2", "proceso3"};
+    fprintf(fp, "\t\t\"estadisticas\": {\n");
+    escribir_json_estadistica(fp, "\t\t\t", "tiempo_ciclo", &est->tiempo_ciclo, 1);
+    escribir_json_estadistica(fp, "\t\t\t", "tiempo_muerto_kernel", &est->tiempo_muerto, 0);
+    escribir_json_estadistica(fp, "\t\t\t", "cpu_kernel", &est->cpu_kernel, 0);
+    escribir_json_estadistica(fp, "\t\t\t", "sobrepaso_quantum", &est->sobrepaso_quantum, 0);
+    escribir_json_estadistica(fp, "\t\t\t", "lanzamiento_huesped", &est->lanzamiento, 0);
+    escribir_json_estadistica(fp, "\t\t\t", "arranque_retenido", &est->arranque, 0);
+    for (int p = 0; p < 3; p++)
+    {
+        fprintf(fp, ",\n\t\t\t\"%s\": {\n", procesos[p]);
+        for (int m = 0; m < NUM_METRICAS_PROCESO; m++)
+            escribir_json_estadistica(fp, "\t\t\t\t", NOMBRES_METRICAS_PROCESO[m], &est->proceso[p][m], m == 0);
+        fprintf(fp, "\n\t\t\t}");
+    }
+    fprintf(fp, "\n\t\t}\n");
     fprintf(fp, "\t}\n]");
 
     fclose(fp);
+    if (anexar_json_es(nombre_archivo, elemento, largo_elemento, COLOR_ERROR "Error al escribir metricas_total.json" ANSI_RESET))
+    {
+        fprintf(stderr, COLOR_ERROR "Error al abrir %s\n" ANSI_RESET, nombre_archivo);
+        return;
+    }
 
     printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "REPORTE GLOBAL JSON: Actualizado en '%s'.\n" ANSI_RESET, nombre_archivo);
 }
 
 void exportar_resultados_a_json()
 {
+    FASE_KERNEL(FASE_EXPORTAR_JSON);
     char nombre_archivo[64];
     snprintf(nombre_archivo, sizeof(nombre_archivo), "metricas_mision_%d.json", escenario_actual);
 
-    FILE *fp = fopen(nombre_archivo, "r+");
-
+    char *elemento = NULL;
+    size_t largo_elemento = 0;
+    FILE *fp = open_memstream(&elemento, &largo_elemento);
     if (fp == NULL)
     {
-
-        fp = fopen(nombre_archivo, "w");
-        if (fp == NULL)
-        {
-            perror(COLOR_ERROR "Error al crear metricas_mision.json" ANSI_RESET);
-            return;
-        }
-        fprintf(fp, "[\n");
-    }
-    else
-    {
-
-        fseek(fp, 0, SEEK_END);
-        long tamano = ftell(fp);
-
-        if (tamano > 2)
-        {
-            fseek(fp, -2, SEEK_END);
-            fprintf(fp, ",\n");
-        }
+        perror(COLOR_ERROR "Error al crear metricas_mision.json" ANSI_RESET);
+        return;
     }
 
     for (int i = 0; i < indice_resultados; i++)
@@ -1216,6 +5572,28 @@ void exportar_resultados_a_json()
         fprintf(fp, "\t\t\"speedup_vs_e2\": %.2f,\n", resultados_ciclos[i].speedup);
 
         fprintf(fp, "\t\t\"tiempo_muerto_kernel\": %.6f,\n", resultados_ciclos[i].tiempo_muerto_kernel);
+        fprintf(fp, "\t\t\"throughput\": %.6f,\n", resultados_ciclos[i].throughput);
+        fprintf(fp, "\t\t\"indice_jain\": %.6f,\n", resultados_ciclos[i].indice_jain);
+        escribir_json_ruta_critica(fp, resultados_ciclos[i].ruta_critica);
+        escribir_json_coste_orquestador(fp, &resultados_ciclos[i].coste);
+
+        ProcesoStats edf_ciclo = {0};
+        combinar_stats_edf(&edf_ciclo, &resultados_ciclos[i].p1_stats);
+        combinar_stats_edf(&edf_ciclo, &resultados_ciclos[i].p2_stats);
+        combinar_stats_edf(&edf_ciclo, &resultados_ciclos[i].p3_stats);
+        if (edf_ciclo.edf_activaciones > 0)
+        {
+            escribir_json_edf(fp, "\t\t", &edf_ciclo);
+            fprintf(fp, ",\n");
+        }
+
+        const ResumenLatencia *latencia = &resultados_ciclos[i].latencia;
+        fprintf(fp, "\t\t\"latencia\": {\"lecturas\": %d, \"actuadas\": %d, \"extremo_medio\": %.6f, \"extremo_max\": %.6f, \"criticas\": %d, \"critica_max\": %.6f, "
+                    "\"registros_p3\": %d, \"registros_perdidos\": %d, \"registros_fuera_de_orden\": %d},\n",
+                latencia->lecturas, latencia->actuadas, latencia->extremo_medio, latencia->extremo_max,
+                latencia->criticas, latencia->critica_max,
+                latencia->registros_p3, latencia->registros_perdidos, latencia->registros_fuera_de_orden);
+
         fprintf(fp, "\t\t\"procesos\": {\n");
 
         escribir_json_stats(fp, "proceso1", &resultados_ciclos[i].p1_stats, 1);
@@ -1233,13 +5611,175 @@ void exportar_resultados_a_json()
 
     fprintf(fp, "\n]");
     fclose(fp);
+    if (anexar_json_es(nombre_archivo, elemento, largo_elemento, COLOR_ERROR "Error al crear metricas_mision.json" ANSI_RESET))
+    {
+        perror(COLOR_ERROR "Error al crear metricas_mision.json" ANSI_RESET);
+        return;
+    }
 
     printf(COLOR_KERNEL "\n[Control Central] " ANSI_RESET "REPORTE JSON ACTUALIZADO: Se añadieron %d ciclos a '%s'.\n" ANSI_RESET, indice_resultados, nombre_archivo);
     indice_resultados = 0;
 }
 
+#define MAX_FRANJAS_ABIERTAS 64
+
+static const char *NOMBRES_EVENTOS_LINEA[] = {"lanzamiento", "SIGCONT", "SIGSTOP", "salida", "leer_datos_p3", "quantum"};
+static const char *NOMBRES_PISTAS[] = {"Kernel", "Receptor (P1)", "Escudo (P2)", "Analizador (P3)"};
+
+int pista_linea_tiempo(const EventoLinea *e)
+{
+    return e->pista >= 0 ? e->pista : e->pid;
+}
+
+/* Los hijos anotan su exec cuando el planificador los deja correr, que puede ser después
+   del SIGSTOP que el kernel les envió nada más crearlos: se ordena por instante. */
+int comparar_eventos_linea(const void *a, const void *b)
+{
+    double da = ((const EventoLinea *)a)->instante, db = ((const EventoLinea *)b)->instante;
+    return (da > db) - (da < db);
+}
+
+void escribir_franja_linea_tiempo(FILE *fp, pid_t pid_kernel, const EventoLinea *desde, double hasta)
+{
+    fprintf(fp, ",\n{\"name\":\"ejecutando\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"pid\":%d}}",
+            pid_kernel, pista_linea_tiempo(desde), desde->instante * 1e6, (hasta - desde->instante) * 1e6, desde->pid);
+}
+
+void exportar_linea_tiempo()
+{
+    FASE_KERNEL(FASE_LINEA_TIEMPO);
+    if (!linea_tiempo || escenario_actual < 1 || escenario_actual > 4)
+        return;
+
+    int num_eventos = linea_tiempo->num_eventos < MAX_EVENTOS_LINEA_TIEMPO ? linea_tiempo->num_eventos : MAX_EVENTOS_LINEA_TIEMPO;
+    pid_t pid_kernel = getpid();
+    char nombre_archivo[64];
+    snprintf(nombre_archivo, sizeof(nombre_archivo), "linea_tiempo_escenario_%d.json", escenario_actual);
+    qsort(linea_tiempo->eventos, num_eventos, sizeof(EventoLinea), comparar_eventos_linea);
+
+    FILE *fp = fopen(nombre_archivo, "w");
+    if (!fp)
+    {
+        perror(COLOR_ERROR "Error al crear la línea de tiempo" ANSI_RESET);
+        return;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"escenario\":%d,\"ciclo\":%d,\"eventos_perdidos\":%d},\n\"traceEvents\":[\n",
+            escenario_actual, ciclo_actual, linea_tiempo->perdidos);
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"Kernel (escenario %d, ciclo %d)\"}}",
+            pid_kernel, escenario_actual, ciclo_actual);
+    for (int p = 0; p < 4; p++)
+        fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n"
+                    "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+                pid_kernel, p, NOMBRES_PISTAS[p], pid_kernel, p, p);
+
+    const EventoLinea *abiertas[MAX_FRANJAS_ABIERTAS];
+    int num_abiertas = 0;
+    double ultimo = 0.0;
+
+    for (int i = 0; i < num_eventos; i++)
+    {
+        const EventoLinea *e = &linea_tiempo->eventos[i];
+        if (e->instante + e->duracion > ultimo)
+            ultimo = e->instante + e->duracion;
+
+        if (e->tipo == EVENTO_LECTURA_P3 || e->tipo == EVENTO_QUANTUM)
+        {
+            fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"registros\":%d}}",
+                    NOMBRES_EVENTOS_LINEA[e->tipo], pid_kernel, PISTA_KERNEL, e->instante * 1e6, e->duracion * 1e6, e->dato);
+            continue;
+        }
+
+        if (e->pista < 0)
+            fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"Huésped %d\"}}",
+                    pid_kernel, e->pid, e->pid);
+        fprintf(fp, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"args\":{\"pid\":%d,\"dato\":%d}}",
+                NOMBRES_EVENTOS_LINEA[e->tipo], pid_kernel, pista_linea_tiempo(e), e->instante * 1e6, e->pid, e->dato);
+
+        int abierta = -1;
+        for (int a = 0; a < num_abiertas; a++)
+            if (abiertas[a]->pid == e->pid)
+                abierta = a;
+
+        if ((e->tipo == EVENTO_SIGSTOP || e->tipo == EVENTO_SALIDA) && abierta >= 0)
+        {
+            escribir_franja_linea_tiempo(fp, pid_kernel, abiertas[abierta], e->instante);
+            abiertas[abierta] = abiertas[--num_abiertas];
+        }
+        else if ((e->tipo == EVENTO_LANZAMIENTO || e->tipo == EVENTO_SIGCONT) && abierta < 0 &&
+                 num_abiertas < MAX_FRANJAS_ABIERTAS)
+        {
+            abiertas[num_abiertas++] = e;
+        }
+    }
+
+    /* Huéspedes que siguen vivos (prelanzados o descendientes): su franja llega al final. */
+    for (int a = 0; a < num_abiertas; a++)
+        escribir_franja_linea_tiempo(fp, pid_kernel, abiertas[a], ultimo);
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Línea de tiempo del ciclo: %d eventos en '%s'%s.\n",
+           num_eventos, nombre_archivo, linea_tiempo->perdidos ? " (búfer lleno, eventos perdidos)" : "");
+    linea_tiempo->num_eventos = 0;
+    linea_tiempo->perdidos = 0;
+}
+
+double throughput_ciclo(double tiempo_total_ciclo)
+{
+    int completados = p1_full_stats.completados + p2_full_stats.completados + p3_full_stats.completados;
+    return tiempo_total_ciclo > 0.0 ? completados / tiempo_total_ciclo : 0.0;
+}
+
+/* Índice de Jain sobre la fracción de su retorno que cada proceso no pasó detenido por el
+   planificador: 1 si todos avanzaron al mismo ritmo, 1/n si uno solo acaparó la CPU. */
+double indice_jain_ciclo()
+{
+    const ProcesoStats *procesos[3] = {&p1_full_stats, &p2_full_stats, &p3_full_stats};
+    double suma = 0.0, suma_cuadrados = 0.0;
+    int n = 0;
+
+    for (int p = 0; p < 3; p++)
+    {
+        if (procesos[p]->completados == 0 || procesos[p]->retorno_total <= 0.0)
+            continue;
+        double x = 1.0 - procesos[p]->espera_total / procesos[p]->retorno_total;
+        suma += x;
+        suma_cuadrados += x * x;
+        n++;
+    }
+    return n > 0 && suma_cuadrados > 0.0 ? suma * suma / (n * suma_cuadrados) : 0.0;
+}
+
+void mostrar_fila_metricas_clasicas(const char *nombre, const ProcesoStats *stats)
+{
+    if (stats->completados == 0)
+        return;
+    printf("%s| %-20s | %-4d | %-13.6f | %-13.6f | %-13.6f |" ANSI_RESET "\n", color_proceso(nombre), nombre_legible(nombre),
+           stats->completados, stats->retorno_total / stats->completados,
+           stats->respuesta_total / stats->completados, stats->espera_total);
+}
+
+void mostrar_metricas_clasicas(double tiempo_total_ciclo)
+{
+    FASE_KERNEL(FASE_INFORME_CONSOLA);
+    if (p1_full_stats.completados + p2_full_stats.completados + p3_full_stats.completados == 0)
+        return;
+
+    printf(COLOR_TABLE "\n--- Métricas de Planificación del Ciclo ---\n");
+    printf("| %-20s | %-4s | %-13s | %-13s | %-13s |\n", "Proceso", "N", "Retorno (s)", "Respuesta (s)", "Espera (s)");
+    mostrar_fila_metricas_clasicas("proceso1", &p1_full_stats);
+    mostrar_fila_metricas_clasicas("proceso2", &p2_full_stats);
+    mostrar_fila_metricas_clasicas("proceso3", &p3_full_stats);
+    printf(COLOR_TABLE "  - Throughput: %.3f procesos/s | Índice de Jain: %.3f\n" ANSI_RESET,
+           throughput_ciclo(tiempo_total_ciclo), indice_jain_ciclo());
+    fflush(stdout);
+}
+
 void almacenar_resultado_ciclo(double tiempo_total_ciclo, double speedup)
 {
+    FASE_KERNEL(FASE_ESTADISTICAS);
     if (indice_resultados >= CICLOS_POR_REPORTE)
         return;
 
@@ -1249,41 +5789,361 @@ void almacenar_resultado_ciclo(double tiempo_total_ciclo, double speedup)
     res->tiempo_total_ciclo = tiempo_total_ciclo;
     res->speedup = speedup;
 
-    res->tiempo_muerto_kernel = res->tiempo_total_ciclo - (time_p1 + time_p2 + time_p3);
+    memcpy(res->ruta_critica, ruta_critica.total_ciclo, sizeof(res->ruta_critica));
+    res->tiempo_muerto_kernel = tiempo_kernel_ruta(res->ruta_critica);
+    res->coste = coste_ciclo;
+    res->throughput = throughput_ciclo(tiempo_total_ciclo);
+    res->indice_jain = indice_jain_ciclo();
 
     res->p1_stats = p1_full_stats;
     res->p2_stats = p2_full_stats;
     res->p3_stats = p3_full_stats;
+    res->latencia = resumen_latencia_ciclo;
 
     indice_resultados++;
 
     acumular_metricas_ciclo(tiempo_total_ciclo);
+    actualizar_estadisticas_escenario(res);
+    publicar_fin_ciclo(tiempo_total_ciclo);
 
     if (indice_resultados == CICLOS_POR_REPORTE)
     {
+        TramoKernel previo = entrar_tramo(TRAMO_JSON);
         exportar_resultados_a_json();
         exportar_reporte_acumulado_a_json();
+        salir_tramo(previo);
+        previo = entrar_tramo(TRAMO_CONSOLA);
         imprimir_reporte_acumulado();
+        fflush(stdout);
+        salir_tramo(previo);
     }
 }
 
-int main()
+/* Ctrl+Z y los cambios del canal de control se aplican aquí, con el ciclo anterior ya
+   contabilizado. */
+void aplicar_control_ciclo()
 {
-    printf(COLOR_KERNEL "[Centro de Control] Iniciando Orquestador de Misión." ANSI_RESET "\n");
-    printf(COLOR_YELLOW "El ciclo de monitoreo se repetirá cada 5 segundos.\n Presione Ctrl + Z para reiniciar y seleccionar un nuevo protocolo" ANSI_RESET "\n");
+    if (reinicio_solicitado)
+    {
+        reinicio_solicitado = 0;
+        cambios_control.escenario = 0;
+        reiniciar_escenario();
+    }
+
+    if (cambios_control.politica >= 0)
+    {
+        if (cambios_control.politica != (int)politica_actual)
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Canal de control: política %s -> %s.\n",
+                   NOMBRES_POLITICAS[politica_actual], NOMBRES_POLITICAS[cambios_control.politica]);
+        politica_actual = cambios_control.politica;
+        cambios_control.politica = -1;
+    }
+
+    if (cambios_control.hay_intervalo)
+    {
+        intervalo_ciclo = cambios_control.intervalo_ciclo;
+        cambios_control.hay_intervalo = 0;
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Canal de control: intervalo entre ciclos %.3f s.\n", intervalo_ciclo);
+    }
+
+    if (cambios_control.escenario && cambios_control.escenario != escenario_actual)
+    {
+        /* Los reportes son por escenario: se vuelcan los ciclos pendientes del anterior. */
+        if (escenario_actual != 0 && indice_resultados > 0)
+        {
+            exportar_resultados_a_json();
+            exportar_reporte_acumulado_a_json();
+        }
+        memset(&acumulador_global, 0, sizeof(AcumuladorMetricas));
+        indice_resultados = 0;
+
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Canal de control: escenario %d -> %d.\n",
+               escenario_actual, cambios_control.escenario);
+        escenario_actual = cambios_control.escenario;
+    }
+    cambios_control.escenario = 0;
+}
+
+int esperar_escenario_menu()
+{
+    static char linea[64];
+    static size_t largo = 0;
+    static int stdin_cerrado = 0;
 
-    signal(SIGTSTP, reiniciar_escenario);
+    printf("Seleccione el protocolo de ejecución (1-4): ");
+    fflush(stdout);
+
+    while (1)
+    {
+        struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+        int listo = stdin_cerrado ? 0 : poll(&pfd, 1, INTERVALO_MENU_MS);
+        if (stdin_cerrado)
+            usleep(INTERVALO_MENU_MS * 1000);
+
+        atender_canales();
+        if (cambios_control.escenario || reinicio_solicitado)
+        {
+            printf("\n");
+            return 0;
+        }
+        if (listo <= 0)
+            continue;
+
+        ssize_t n = read(STDIN_FILENO, linea + largo, sizeof(linea) - 1 - largo);
+        if (n <= 0)
+        {
+            stdin_cerrado = 1;
+            if (fd_control == -1)
+            {
+                printf("\n" COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Entrada estándar cerrada y sin canal de control: fin de la misión.\n");
+                exit(0);
+            }
+            continue;
+        }
+        largo += n;
+        linea[largo] = '\0';
+
+        char *salto = strchr(linea, '\n');
+        if (!salto && largo < sizeof(linea) - 1)
+            continue;
+
+        int escenario = 0;
+        if (sscanf(linea, "%d", &escenario) != 1 || escenario < 1 || escenario > 4)
+            escenario = 0;
+        largo = salto ? largo - (salto + 1 - linea) : 0;
+        if (salto)
+            memmove(linea, salto + 1, largo + 1);
+        return escenario;
+    }
+}
+
+void mostrar_uso(const char *programa)
+{
+    fprintf(stderr, "Uso: %s [-p rr|edf|gang|datos] [-m puerto] [-t estados] [-r] [-i uring|clasico] [-e topologia]... [-g rafagas] [-s rafagas [-q Q1:Q2,...]] [-c socket] [-f sensores [-a regla]] [-x ms] [-w prefijo | -y prefijo[:velocidad]]\n", programa);
+    fprintf(stderr, "  -p rr    Round-Robin por quantum fijo (por defecto)\n");
+    fprintf(stderr, "  -p edf   Earliest-Deadline-First en el escenario 3 (plazos por proceso)\n");
+    fprintf(stderr, "  -p gang  Escenarios 2 y 3: P1 y P3 en núcleos distintos, planificados en banda\n");
+    fprintf(stderr, "  -p datos Round-Robin guiado por datos: corta u omite los turnos de quien espera en su tubería\n");
+    fprintf(stderr, "  -m N     Sirve métricas Prometheus en http://127.0.0.1:N/metrics\n");
+    fprintf(stderr, "  -t N     Estados de registros retenidos por proceso en las trazas del escenario 2 (por defecto %d)\n", ESTADOS_ANILLO_TRAZA);
+    fprintf(stderr, "  -r       Modo de baja latencia: SCHED_FIFO en un núcleo reservado, memoria bloqueada y preasignada\n");
+    fprintf(stderr, "  -i uring Backend de E/S io_uring (alimentador, canal de P3, esperas y JSON); sin soporte vuelve al clásico\n");
+    fprintf(stderr, "  -e F     Ejecuta el escenario declarado en el archivo de topología F en lugar del integrado (repetible)\n");
+    fprintf(stderr, "  -g F     Agrega a F las ráfagas de CPU de P1 y P3 de cada ciclo, para el simulador\n");
+    fprintf(stderr, "  -s F     No lanza huéspedes: simula las ráfagas grabadas en F con cada juego de quantums\n");
+    fprintf(stderr, "  -q L     Juegos de quantums del simulador, p. ej. 10:5,2:1 (por defecto escala los de la topología)\n");
+    fprintf(stderr, "  -c F     Canal de control en el socket Unix F (quantum, politica, escenario, intervalo, log, estado)\n");
+    fprintf(stderr, "  -f N     Escenario 2 con N tuberías P1 -> P3 (1-%d) que comparten el Escudo; entradas en %s o medidas.txt\n", MAX_SENSORES, PATRON_ENTRADA_SENSOR);
+    fprintf(stderr, "  -a R     Regla del Escudo compartido: max (por defecto), cualquiera, quorum o quorum=K\n");
+    fprintf(stderr, "  -x MS    Perfila los huéspedes por su gdbstub (qemu -g) cada MS ms: etiquetas calientes y pilas plegadas\n");
+    fprintf(stderr, "  -w P     Captura con tee/splice el tráfico P1->P3 y P3->kernel en P_<ciclo>_p1_p3.cap y P_<ciclo>_p3_kernel.cap\n");
+    fprintf(stderr, "  -y P[:V] Reproduce P_p1_p3.cap y P_p3_kernel.cap en cada ciclo a velocidad V (1 original, 0 sin pausas)\n");
+}
+
+#ifndef KERNEL_SIN_MAIN
+int main(int argc, char *argv[])
+{
+    static const char *NOMBRES_BACKEND_ES[] = {"clásico", "io_uring"};
+    struct timeval ciclo_start = {0};
+    double tiempo_escenario_2 = 0.0;
+    int opcion;
+    int puerto_metricas = 0;
+    const char *ruta_simulacion = NULL;
+    const char *barrido_quantums = NULL;
+    const char *ruta_canal_control = NULL;
+    while ((opcion = getopt(argc, argv, "p:m:t:re:i:g:s:q:c:f:a:x:w:y:")) != -1)
+    {
+        switch (opcion)
+        {
+        case 'p':
+            if (strcmp(optarg, "rr") == 0)
+                politica_actual = POLITICA_RR;
+            else if (strcmp(optarg, "edf") == 0)
+                politica_actual = POLITICA_EDF;
+            else if (strcmp(optarg, "gang") == 0)
+                politica_actual = POLITICA_GANG;
+            else if (strcmp(optarg, "datos") == 0)
+                politica_actual = POLITICA_DATOS;
+            else
+            {
+                mostrar_uso(argv[0]);
+                return 1;
+            }
+            break;
+        case 'r':
+            modo_rt = 1;
+            break;
+        case 'e':
+            cargar_topologia(optarg);
+            break;
+        case 'g':
+            ruta_grabacion_rafagas = optarg;
+            break;
+        case 's':
+            ruta_simulacion = optarg;
+            break;
+        case 'q':
+            barrido_quantums = optarg;
+            break;
+        case 'c':
+            ruta_canal_control = optarg;
+            break;
+        case 'x':
+            periodo_perfil_ms = atoi(optarg);
+            if (periodo_perfil_ms <= 0)
+            {
+                mostrar_uso(argv[0]);
+                return 1;
+            }
+            break;
+        case 'w':
+            prefijo_captura = optarg;
+            break;
+        case 'y':
+        {
+            char *velocidad = strrchr(optarg, ':');
+            if (velocidad)
+            {
+                *velocidad++ = '\0';
+                velocidad_reproduccion = atof(velocidad);
+                if (velocidad_reproduccion < 0.0)
+                {
+                    mostrar_uso(argv[0]);
+                    return 1;
+                }
+            }
+            prefijo_reproduccion = optarg;
+            break;
+        }
+        case 'f':
+            num_sensores = atoi(optarg);
+            if (num_sensores < 1 || num_sensores > MAX_SENSORES)
+            {
+                mostrar_uso(argv[0]);
+                return 1;
+            }
+            break;
+        case 'a':
+            if (strcmp(optarg, "max") == 0)
+                regla_abanico = REGLA_MAX;
+            else if (strcmp(optarg, "cualquiera") == 0)
+                regla_abanico = REGLA_CUALQUIERA;
+            else if (strncmp(optarg, "quorum", 6) == 0 && (optarg[6] == '\0' || optarg[6] == '='))
+            {
+                regla_abanico = REGLA_QUORUM;
+                quorum_abanico = optarg[6] ? atoi(optarg + 7) : 0;
+                if (optarg[6] && quorum_abanico < 1)
+                {
+                    mostrar_uso(argv[0]);
+                    return 1;
+                }
+            }
+            else
+            {
+                mostrar_uso(argv[0]);
+                return 1;
+            }
+            break;
+        case 'i':
+            if (strcmp(optarg, "uring") == 0)
+                backend_es = BACKEND_ES_URING;
+            else if (strcmp(optarg, "clasico") == 0)
+                backend_es = BACKEND_ES_CLASICO;
+            else
+            {
+                mostrar_uso(argv[0]);
+                return 1;
+            }
+            break;
+        case 't':
+            estados_anillo_traza = atoi(optarg);
+            if (estados_anillo_traza <= 0)
+            {
+                mostrar_uso(argv[0]);
+                return 1;
+            }
+            break;
+        case 'm':
+            puerto_metricas = atoi(optarg);
+            if (puerto_metricas <= 0 || puerto_metricas > 65535)
+            {
+                mostrar_uso(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            mostrar_uso(argv[0]);
+            return 1;
+        }
+    }
+
+    if (prefijo_captura && prefijo_reproduccion)
+    {
+        mostrar_uso(argv[0]);
+        return 1;
+    }
+
+    if (ruta_simulacion)
+    {
+        ejecutar_simulador(ruta_simulacion, barrido_quantums);
+        return 0;
+    }
+
+    printf(COLOR_KERNEL "[Centro de Control] Iniciando Orquestador de Misión." ANSI_RESET "\n");
+    if (politica_actual == POLITICA_EDF)
+        printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Política de planificación: EDF (plazo del Escudo %.2f s desde la lectura).\n",
+               EDF_P2.plazo_relativo);
+    else if (politica_actual == POLITICA_GANG)
+        printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Política de planificación: banda (gang) multinúcleo, ranura de %d s.\n",
+               QUANTUM_GANG);
+    else if (politica_actual == POLITICA_DATOS)
+        printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Política de planificación: Round-Robin guiado por datos (turnos ociosos cortados u omitidos).\n");
+    for (int e = 1; e <= 4; e++)
+        if (topologias[e])
+            printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Escenario %d definido por %s (%d nodos, %d tuberías, modo %s).\n",
+                   e, topologias[e]->ruta, topologias[e]->num_nodos, topologias[e]->num_tuberias,
+                   NOMBRES_MODOS_TOPOLOGIA[topologias[e]->modo]);
+    if (prefijo_captura)
+        printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Capturando el tráfico P1->P3 y P3->kernel en %s_<ciclo>_*.cap.\n", prefijo_captura);
+    if (prefijo_reproduccion)
+        printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Reproduciendo el tráfico P1->P3 y P3->kernel de %s_*.cap %s.\n",
+               prefijo_reproduccion, texto_velocidad_reproduccion());
+    if (num_sensores > 0)
+        printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Escenario 2: abanico de %d sensores hacia un Escudo compartido (regla %s).\n",
+               num_sensores, NOMBRES_REGLAS_ABANICO[regla_abanico]);
+    printf(COLOR_YELLOW "El ciclo de monitoreo se repetirá cada %.0f segundos.\n Presione Ctrl + Z para reiniciar y seleccionar un nuevo protocolo" ANSI_RESET "\n",
+           intervalo_ciclo);
+
+    signal(SIGTSTP, solicitar_reinicio);
+    signal(SIGUSR1, solicitar_volcado_trazas);
+
+    inicializar_estadisticas();
+    iniciar_telemetria();
+    iniciar_linea_tiempo();
+    iniciar_perfilador();
+    iniciar_ruta_critica();
+    calibrar_temporizadores_fase();
+    if (modo_rt)
+        iniciar_modo_rt();
+    iniciar_backend_es();
+    iniciar_grabacion_rafagas();
+    if (puerto_metricas > 0)
+        iniciar_endpoint_metricas(puerto_metricas);
+    if (ruta_canal_control)
+        iniciar_canal_control(ruta_canal_control);
+
+    if (prctl(PR_SET_CHILD_SUBREAPER, 1) == -1)
+        perror(COLOR_ERROR "prctl(PR_SET_CHILD_SUBREAPER)" ANSI_RESET);
 
     while (1)
     {
+        aplicar_control_ciclo();
 
         if (escenario_actual == 0)
         {
-            printf("Seleccione el protocolo de ejecución (1-4): ");
-            if (scanf("%d", &escenario_actual) != 1 || escenario_actual < 1 || escenario_actual > 4)
-                escenario_actual = 0;
-            while (fgetc(stdin) != '\n')
-                ;
+            escenario_actual = esperar_escenario_menu();
+            if (escenario_actual == 0)
+                continue;
         }
 
         if (escenario_actual != 0)
@@ -1291,7 +6151,10 @@ int main()
             printf(COLOR_CICLO "\n--- Inicio del ciclo #%d ---\n" ANSI_RESET, ciclo_actual);
 
             gettimeofday(&ciclo_start, NULL);
+            comenzar_ruta_critica();
+            comenzar_coste_orquestador();
 
+            descartar_prelanzamiento();
             inicializar_ciclo();
 
             printf(COLOR_KERNEL "\n[Control Central] " ANSI_RESET "Iniciando protocolo de escenario: %d..." ANSI_RESET "\n", escenario_actual);
@@ -1299,20 +6162,32 @@ int main()
             ejecutar_escenario();
         }
 
+        /* Informe del ciclo: tramo de consola, con fflush para que la escritura caiga dentro. */
+        TramoKernel previo = entrar_tramo(TRAMO_CONSOLA);
         mostrar_tabla_recursos();
+        mostrar_resumen_latencia();
 
         if (escenario_actual == 2 || escenario_actual == 3)
         {
             imprimir_metricas_rr();
         }
+        fflush(stdout);
+        salir_tramo(previo);
 
         struct timeval ciclo_end;
         gettimeofday(&ciclo_end, NULL);
+        cerrar_ciclo_ruta_critica();
+        medir_coste_orquestador(&coste_ciclo);
 
         double tiempo_total_ciclo = timeval_diff(&ciclo_start, &ciclo_end);
         double speedup = 0.0;
 
+        previo = entrar_tramo(TRAMO_CONSOLA);
+        mostrar_metricas_clasicas(tiempo_total_ciclo);
         printf(COLOR_CICLO "Tiempo total del ciclo: %.6f segundos\n" ANSI_RESET, tiempo_total_ciclo);
+        fflush(stdout);
+        salir_tramo(previo);
+        grabar_rafagas_ciclo(tiempo_total_ciclo, cpu_rusage(&usage_p1), cpu_rusage(&usage_p3), time_p2);
 
         if (escenario_actual == 2)
         {
@@ -1336,11 +6211,27 @@ int main()
         }
 
         almacenar_resultado_ciclo(tiempo_total_ciclo, speedup);
+        vaciar_escrituras_es();
+
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "E/S del ciclo (backend %s): %ld llamadas al sistema.\n",
+               NOMBRES_BACKEND_ES[backend_es], llamadas_es_ciclo);
+        previo = entrar_tramo(TRAMO_JSON);
+        exportar_linea_tiempo();
+        exportar_perfil();
+        salir_tramo(previo);
+        informar_grifos(0);
+        mostrar_ruta_critica();
+        mostrar_coste_orquestador();
 
         printf(COLOR_CICLO "--- Fin de ciclo #%d ---\n" ANSI_RESET, ciclo_actual++);
 
-        sleep(5);
+        aplicar_control_ciclo();
+        if (escenario_actual == 0)
+            continue;
+        prelanzar_siguiente_ciclo();
+        dormir_muestreando(intervalo_ciclo);
     }
 
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,324 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <signal.h>
+#include <string.h>
+#include <stdarg.h>
+#include <fcntl.h>
+#include <ctype.h>
+#include <time.h>
+#include <poll.h>
+#include <float.h>
+#include <sys/ioctl.h>
+#include <sched.h>
+#include <dirent.h>
+#include <errno.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <malloc.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include <elf.h>
+
+#include "telemetria.h"
+
+#define ANSI_RESET "\x1B[0m"
+#define ANSI_RED "\x1B[31m"
+#define ANSI_GREEN "\x1B[32m"
+#define ANSI_YELLOW "\x1B[33m"
+#define ANSI_BLUE "\x1B[34m"
+#define ANSI_MAGENTA "\x1B[35m"
+#define ANSI_CYAN "\x1B[36m"
+#define ANSI_WHITE "\x1B[37m"
+#define ANSI_BR_RED "\x1B[91m"
+#define ANSI_BR_GREEN "\x1B[92m"
+#define ANSI_BR_YELLOW "\x1B[93m"
+#define ANSI_BR_CYAN "\x1B[96m"
+
+#define COLOR_KERNEL ANSI_CYAN
+#define COLOR_YELLOW ANSI_YELLOW
+#define COLOR_P1 ANSI_BR_GREEN
+#define COLOR_P2 ANSI_YELLOW
+#define COLOR_P3 ANSI_BLUE
+#define COLOR_ERROR ANSI_BR_RED
+#define COLOR_TABLE ANSI_WHITE
+#define COLOR_CICLO ANSI_BR_YELLOW
+#define COLOR_ACUMULADO ANSI_MAGENTA
+
+typedef struct
+{
+
+    double time_real;
+    long ru_utime_sec, ru_utime_usec;
+    long ru_stime_sec, ru_stime_usec;
+    long ru_maxrss;
+    int exit_status;
+
+    int num_pausas;
+    double tiempo_pausado_total;
+    double tiempo_ejecucion_efectiva;
+    double quantum_dado_total;
+    double quantum_usado_total;
+    int cambios_contexto_voluntario;
+    int cambios_contexto_involuntario;
+    int seniales_recibidas[64];
+    int instancias;
+
+    int edf_activaciones;
+    int edf_plazos_perdidos;
+    double edf_retraso_max;
+    double edf_retraso_total;
+    double edf_holgura_min;
+    double edf_holgura_total;
+
+    double instante_llegada;
+    double instante_primera_ejecucion;
+    double instante_parada;
+    double retorno_total;
+    double respuesta_total;
+    double espera_total;
+    int completados;
+
+    int turnos_omitidos;
+    int turnos_acortados;
+    double tiempo_ocioso_evitado;
+} ProcesoStats;
+
+typedef enum
+{
+    FASE_INICIO_CICLO = 0,
+    FASE_ALIMENTADOR,
+    FASE_LANZAMIENTO,
+    FASE_SENIALES,
+    FASE_LECTURA_P3,
+    FASE_ESCANEO_TRAZA,
+    FASE_ANILLO_TRAZA,
+    FASE_TELEMETRIA,
+    FASE_CANALES,
+    FASE_LATENCIAS,
+    FASE_TABLA_RECURSOS,
+    FASE_INFORME_CONSOLA,
+    FASE_ESTADISTICAS,
+    FASE_EXPORTAR_JSON,
+    FASE_LINEA_TIEMPO,
+    FASE_PERFIL,
+    NUM_FASES
+} FaseKernel;
+
+typedef struct
+{
+    long llamadas;
+    uint64_t total_ns;
+    uint64_t propio_ns;
+    uint64_t max_ns;
+} ContadorFase;
+
+typedef enum
+{
+    POLITICA_RR = 0,
+    POLITICA_EDF,
+    POLITICA_GANG,
+    POLITICA_DATOS
+} PoliticaPlanificacion;
+
+typedef enum
+{
+    NIVEL_LOG_RESUMEN = 0,
+    NIVEL_LOG_NORMAL,
+    NIVEL_LOG_DETALLE
+} NivelLog;
+
+#define MAX_LECTURAS_TRAZADAS 4096
+#define INTERVALO_MUESTREO_US 2000
+#define UMBRAL_ESCUDO 90
+#define MAX_REGISTRO_P3 32
+#define VENTANA_REGISTROS_P3 8
+
+typedef enum
+{
+    ETAPA_ENTRADA = 0,
+    ETAPA_SALIDA_P1,
+    ETAPA_SALIDA_P3,
+    ETAPA_ACTUACION,
+    NUM_ETAPAS
+} EtapaLectura;
+
+typedef struct
+{
+    int valor;
+    long fin_en_flujo;
+    double instante[NUM_ETAPAS];
+    /* -1 si no se midió (solo con -g). */
+    double cpu_emision[NUM_ETAPAS];
+} LecturaTrazada;
+
+/* 2^HDR_BITS_SUBCUBETA subcubetas lineales por potencia de dos: error relativo ~3%. */
+#define HDR_BITS_SUBCUBETA 5
+#define HDR_SUBCUBETAS (1 << HDR_BITS_SUBCUBETA)
+#define HDR_MAGNITUDES 42
+#define HDR_NUM_CUBETAS (HDR_MAGNITUDES * HDR_SUBCUBETAS)
+
+#define ESCALA_SEGUNDOS 1000000.0
+#define ESCALA_FRACCION 1000000.0
+#define ESCALA_KB 1.0
+#define ESCALA_NANOSEGUNDOS 1000000000.0
+
+typedef struct
+{
+    double escala;
+    long muestras;
+    double media;
+    double m2;
+    double minimo;
+    double maximo;
+    long cubetas[HDR_NUM_CUBETAS];
+} EstadisticaOnline;
+
+typedef struct
+{
+    LecturaTrazada lecturas[MAX_LECTURAS_TRAZADAS];
+    int num_lecturas;
+    int siguiente_salida_p1;
+    int siguiente_salida_p3;
+    int siguiente_actuacion;
+    long bytes_recibidos_p3;
+    char registro_p3[MAX_REGISTRO_P3];
+    int largo_registro_p3;
+    int registro_p3_truncado;
+    int siguiente_registro_p3;
+    int fd_p1_a_p3;
+    int fd_p3_a_kernel;
+    int fd_actuaciones;
+} TrazaLecturas;
+
+/* -1 = los del kernel / sin núcleo fijo. */
+typedef struct
+{
+    int entrada;
+    int salida;
+    int nucleo;
+    int retenido;
+} ArranqueHuesped;
+
+typedef enum
+{
+    OCIO_NINGUNO = 0,
+    OCIO_SIN_ENTRADA,
+    OCIO_SALIDA_LLENA,
+    OCIO_TERMINADO
+} MotivoOcio;
+
+#define MAX_PROFUNDIDAD_FASES 16
+
+#ifndef KERNEL_SIN_FASES
+typedef struct
+{
+    int fase;
+    uint64_t inicio;
+} TemporizadorFase;
+
+extern ContadorFase contadores_fase[NUM_FASES];
+extern uint64_t hijos_fase[MAX_PROFUNDIDAD_FASES];
+extern int profundidad_fase;
+extern long activaciones_fase;
+
+static inline uint64_t reloj_fase_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static inline TemporizadorFase abrir_fase(int fase)
+{
+    if (profundidad_fase < MAX_PROFUNDIDAD_FASES)
+        hijos_fase[profundidad_fase] = 0;
+    profundidad_fase++;
+    return (TemporizadorFase){fase, reloj_fase_ns()};
+}
+
+static inline void cerrar_fase(TemporizadorFase *t)
+{
+    uint64_t duracion = reloj_fase_ns() - t->inicio;
+    uint64_t hijos = --profundidad_fase < MAX_PROFUNDIDAD_FASES ? hijos_fase[profundidad_fase] : 0;
+    if (profundidad_fase > 0 && profundidad_fase <= MAX_PROFUNDIDAD_FASES)
+        hijos_fase[profundidad_fase - 1] += duracion;
+    if (t->fase >= NUM_FASES)
+        return;
+
+    ContadorFase *c = &contadores_fase[t->fase];
+    c->llamadas++;
+    c->total_ns += duracion;
+    c->propio_ns += duracion > hijos ? duracion - hijos : 0;
+    if (duracion > c->max_ns)
+        c->max_ns = duracion;
+    activaciones_fase++;
+}
+
+#define FASE_KERNEL(fase) TemporizadorFase temporizador_fase __attribute__((cleanup(cerrar_fase))) = abrir_fase(fase)
+
+#else
+#define FASE_KERNEL(fase) \
+    do                    \
+    {                     \
+    } while (0)
+
+#endif
+
+#define EDF_TRAMO_SONDEO_MS 10
+#define TIMEOUT_PRELANZAMIENTO 2.0
+
+extern PoliticaPlanificacion politica_actual;
+extern NivelLog nivel_log;
+extern double quantum_p1_rr;
+extern double quantum_p3_rr;
+extern double intervalo_ciclo;
+extern int escenario_actual;
+extern int ciclo_actual;
+extern TrazaLecturas traza_lecturas;
+
+double timeval_diff(struct timeval *start, struct timeval *end);
+double cpu_rusage(const struct rusage *uso);
+double tiempo_monotonico();
+void iniciar_estadistica(EstadisticaOnline *e, double escala);
+void registrar_estadistica(EstadisticaOnline *e, double valor);
+double percentil_estadistica(const EstadisticaOnline *e, double fraccion);
+ProcesoStats *stats_por_programa(const char *ruta);
+int slot_telemetria_por_nombre(const char *nombre_proceso);
+void detener_huesped(pid_t pid, ProcesoStats *stats);
+void reanudar_huesped(pid_t pid, ProcesoStats *stats, double quantum);
+void guardar_stats_proceso(const char *nombre_proceso, pid_t pid, double wall_time, struct rusage *usage, int status);
+void vigilar_pipes_lecturas(int fd_p1_a_p3, int fd_p3_a_kernel);
+char estado_huesped(pid_t pid);
+long bytes_pendientes(int fd);
+void muestrear_latencias();
+void registrar_actuacion_escudo();
+const char *nombre_legible(const char *nombre);
+const char *color_proceso(const char *nombre);
+void proceso_terminado(const char *nombre_proceso, pid_t pid);
+void atender_metricas();
+void dormir_quantum(double segundos);
+void esperar_proceso(pid_t pid, const char *nombre_proceso, int timeout_sec, struct timeval *start_time);
+pid_t intentar_lanzar_huesped(char *const argv[], const ArranqueHuesped *arranque, ProcesoStats *stats);
+int leer_datos_p3(int pipe_fd, int *valor);
+void enviar_contenido_archivo_a_pipe(int pipe_fd_escritura, const char *archivo);
+int huesped_tras_exec(pid_t pid);
+int huesped_bloqueado(pid_t pid);
+MotivoOcio dormir_quantum_datos(double segundos, pid_t pid, int fd_entrada, ProcesoStats *stats);
+
+#endif
@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "telemetria.h"
+
+static const char *NOMBRES_PROCESOS[3] = {"Receptor (P1)", "Escudo (P2)", "Analizador (P3)"};
+static const char *NOMBRES_ESTADOS[4] = {"inactivo", "ejecutando", "detenido", "terminado"};
+static const char *NOMBRES_POLITICAS[4] = {"rr", "edf", "gang", "datos"};
+
+double tiempo_monotonico()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+void mostrar_pagina(const PaginaTelemetria *t)
+{
+    double ahora = tiempo_monotonico();
+
+    printf("Kernel PID %d | política %s | escenario %u | ciclo %u | versión %u | publicado hace %.3f s\n",
+           t->pid_kernel, t->politica < 4 ? NOMBRES_POLITICAS[t->politica] : "?",
+           t->escenario, t->ciclo, t->secuencia / 2, ahora - t->instante_publicacion);
+
+    printf("  %-16s %-8s %-11s %-9s %-8s %-8s %-10s %-10s %-10s %-8s\n",
+           "Proceso", "PID", "Estado", "Hace (s)", "Pausas", "Quantum", "Q. dado", "PC", "CPU media", "Util. Q");
+    for (int p = 0; p < 3; p++)
+    {
+        const TelemetriaProceso *proc = &t->procesos[p];
+        printf("  %-16s %-8d %-11s %-9.2f %-8u %-8.2f %-10.2f 0x%-8llx %-10.4f %-8.2f\n",
+               NOMBRES_PROCESOS[p], proc->pid, proc->estado < 4 ? NOMBRES_ESTADOS[proc->estado] : "?",
+               proc->instante_estado > 0.0 ? ahora - proc->instante_estado : 0.0,
+               proc->pausas, proc->quantum_actual, proc->quantum_dado_total,
+               (unsigned long long)proc->ultimo_pc, proc->cpu_media, proc->utilizacion_quantum_media);
+    }
+
+    printf("  Ciclos: %llu | último %.3f s | media %.3f s | p99 %.3f s | t. muerto medio %.3f s | latencia p50/p99 %.3f / %.3f s\n\n",
+           (unsigned long long)t->ciclos_completados, t->tiempo_ciclo_ultimo, t->tiempo_ciclo_media,
+           t->tiempo_ciclo_p99, t->tiempo_muerto_media, t->latencia_extremo_p50, t->latencia_extremo_p99);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    int intervalo_ms = (argc > 1) ? atoi(argv[1]) : 200;
+    if (intervalo_ms <= 0)
+        intervalo_ms = 200;
+
+    int fd = shm_open(TELEMETRIA_NOMBRE, O_RDONLY, 0);
+    if (fd == -1)
+    {
+        perror("Error abriendo la telemetría (¿está corriendo ./kernel?)");
+        return 1;
+    }
+
+    const PaginaTelemetria *pagina = mmap(NULL, sizeof(PaginaTelemetria), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (pagina == MAP_FAILED)
+    {
+        perror("Error mapeando la telemetría");
+        return 1;
+    }
+
+    PaginaTelemetria copia;
+    uint32_t ultima_secuencia = 0;
+
+    while (1)
+    {
+        telemetria_leer(pagina, &copia);
+
+        if (copia.magia != TELEMETRIA_MAGIA || copia.version != TELEMETRIA_VERSION ||
+            copia.tam_pagina != sizeof(PaginaTelemetria))
+        {
+            fprintf(stderr, "Página de telemetría incompatible (versión %u, esperada %u)\n",
+                    copia.version, TELEMETRIA_VERSION);
+            return 1;
+        }
+
+        if (kill(copia.pid_kernel, 0) == -1 && errno == ESRCH)
+        {
+            printf("El kernel (PID %d) ya no está en ejecución.\n", copia.pid_kernel);
+            return 0;
+        }
+
+        if (copia.secuencia != ultima_secuencia)
+        {
+            mostrar_pagina(&copia);
+            ultima_secuencia = copia.secuencia;
+        }
+
+        usleep(intervalo_ms * 1000);
+    }
+}
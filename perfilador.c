@@ -0,0 +1,637 @@
+#include "kernel.h"
+#include "perfilador.h"
+
+/* QEMU intercepta el SIGINT, detiene al huésped y lo avisa por el gdbstub; la señal nunca
+   se le entrega. */
+
+#define MAX_PROGRAMAS_PERFIL 16
+#define MAX_PAQUETE_GDB 1024
+#define INTERVALO_CONEXION_PERFIL_MS 1
+#define VENTANA_CONEXION_RAPIDA 1.0
+#define REGISTROS_GDB_RISCV 33
+#define REGISTRO_PC_RISCV 32
+#define REGISTRO_RA_RISCV 1
+#define SENIAL_GDB_SIGINT 2
+#define MAX_FILAS_PERFIL 10
+
+typedef enum
+{
+    GDB_CONECTANDO = 0,
+    GDB_SALUDO,
+    GDB_CORRIENDO,
+    GDB_ESPERANDO_PARADA,
+    GDB_ESPERANDO_REGISTROS,
+    GDB_CERRADO
+} EstadoGdb;
+
+typedef struct
+{
+    pid_t pid;
+    char ruta_socket[TAM_RUTA_SOCKET_GDB];
+    int programa;
+    int fd;
+    EstadoGdb estado;
+    double alta;
+    char entrada[MAX_PAQUETE_GDB];
+    int largo_entrada;
+} HuespedPerfilado;
+
+typedef struct
+{
+    uint32_t pc;
+    uint32_t ra;
+} MuestraPerfil;
+
+typedef struct
+{
+    uint32_t direccion;
+    int local;
+    char nombre[48];
+} SimboloElf;
+
+typedef struct
+{
+    char ruta[128];
+    SimboloElf *simbolos;
+    int num_simbolos;
+    int simbolos_cargados;
+    MuestraPerfil *muestras;
+    int num_muestras;
+    int capacidad_muestras;
+} ProgramaPerfilado;
+
+int periodo_perfil_ms = 0;
+static pthread_t hilo_perfil;
+static pthread_mutex_t cerrojo_perfil = PTHREAD_MUTEX_INITIALIZER;
+static HuespedPerfilado *huespedes_perfilados = NULL;
+static int num_huespedes_perfilados = 0;
+static int capacidad_huespedes_perfilados = 0;
+static ProgramaPerfilado programas_perfilados[MAX_PROGRAMAS_PERFIL];
+static int num_programas_perfilados = 0;
+static long muestras_perfil_perdidas = 0;
+static char directorio_perfil[] = "/tmp/kernel_gdb_XXXXXX";
+
+int programa_perfilado(const char *ruta)
+{
+    for (int i = 0; i < num_programas_perfilados; i++)
+        if (strcmp(programas_perfilados[i].ruta, ruta) == 0)
+            return i;
+    if (num_programas_perfilados == MAX_PROGRAMAS_PERFIL)
+        return -1;
+
+    ProgramaPerfilado *p = &programas_perfilados[num_programas_perfilados];
+    snprintf(p->ruta, sizeof(p->ruta), "%s", ruta);
+    return num_programas_perfilados++;
+}
+
+/* Un QEMU con -g no arranca al huésped hasta que alguien se conecta, así que el hueco en
+   la tabla se reserva antes de lanzarlo: solo el hilo principal añade huéspedes y el
+   muestreador solo la compacta. Devuelve el programa, o -1 si no se perfila. */
+int reservar_huesped_perfil(const char *ruta_elf)
+{
+    pthread_mutex_lock(&cerrojo_perfil);
+    int programa = programa_perfilado(ruta_elf);
+    if (programa >= 0 && num_huespedes_perfilados == capacidad_huespedes_perfilados)
+    {
+        int capacidad = capacidad_huespedes_perfilados ? 2 * capacidad_huespedes_perfilados : 16;
+        HuespedPerfilado *tabla = realloc(huespedes_perfilados, capacidad * sizeof(HuespedPerfilado));
+        if (tabla)
+        {
+            huespedes_perfilados = tabla;
+            capacidad_huespedes_perfilados = capacidad;
+        }
+        else
+            programa = -1;
+    }
+    pthread_mutex_unlock(&cerrojo_perfil);
+    return programa;
+}
+
+/* El ELF es el primer argumento que no es una opción de QEMU. Devuelve su programa, o -1. */
+int preparar_argv_perfil(char *const argv[], char **argv_perfil, char *ruta_socket, size_t tam)
+{
+    static unsigned secuencia = 0;
+    const char *ruta_elf = NULL;
+    int n = 0;
+    while (argv[n])
+        n++;
+    if (n + 3 > MAX_ARGV_PERFIL || strcmp(argv[0], "qemu-riscv32") != 0)
+        return -1;
+
+    for (int i = 1; i < n && !ruta_elf; i++)
+    {
+        if (strcmp(argv[i], "-d") == 0 || strcmp(argv[i], "-D") == 0 || strcmp(argv[i], "-g") == 0)
+            i++;
+        else if (argv[i][0] != '-')
+            ruta_elf = argv[i];
+    }
+    int programa = ruta_elf ? reservar_huesped_perfil(ruta_elf) : -1;
+    if (programa < 0)
+        return -1;
+
+    snprintf(ruta_socket, tam, "%s/%u.sock", directorio_perfil, secuencia++);
+    argv_perfil[0] = argv[0];
+    argv_perfil[1] = "-g";
+    argv_perfil[2] = ruta_socket;
+    for (int i = 1; i <= n; i++)
+        argv_perfil[i + 2] = argv[i];
+    return programa;
+}
+
+void registrar_huesped_perfil(pid_t pid, const char *ruta_socket, int programa)
+{
+    pthread_mutex_lock(&cerrojo_perfil);
+    HuespedPerfilado *h = &huespedes_perfilados[num_huespedes_perfilados++];
+    *h = (HuespedPerfilado){.pid = pid, .programa = programa, .fd = -1, .estado = GDB_CONECTANDO, .alta = tiempo_monotonico()};
+    snprintf(h->ruta_socket, sizeof(h->ruta_socket), "%s", ruta_socket);
+    pthread_mutex_unlock(&cerrojo_perfil);
+}
+
+void enviar_paquete_gdb(HuespedPerfilado *h, const char *datos)
+{
+    char paquete[MAX_PAQUETE_GDB];
+    unsigned suma = 0;
+
+    for (const char *c = datos; *c; c++)
+        suma += (unsigned char)*c;
+    int largo = snprintf(paquete, sizeof(paquete), "$%s#%02x", datos, suma & 0xff);
+    if (send(h->fd, paquete, largo, MSG_NOSIGNAL) != largo)
+        h->estado = GDB_CERRADO;
+}
+
+/* QEMU solo escucha cuando ya hizo exec (un huésped retenido tarda lo que su compuerta).
+   Se llama sin el cerrojo del perfilador: el socket es no bloqueante y un connect Unix
+   contra un socket que escucha no espera. Devuelve el fd conectado, -1 si hay que
+   reintentar o -2 si el huésped ya terminó. */
+int conectar_gdb(pid_t pid, const char *ruta_socket)
+{
+    struct sockaddr_un dir = {.sun_family = AF_UNIX};
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+
+    snprintf(dir.sun_path, sizeof(dir.sun_path), "%s", ruta_socket);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&dir, sizeof(dir)) == 0)
+        return fd;
+    if (fd >= 0)
+        close(fd);
+
+    char estado = estado_huesped(pid);
+    return (estado == 0 || estado == 'Z') ? -2 : -1;
+}
+
+void cerrar_gdb(HuespedPerfilado *h)
+{
+    if (h->fd >= 0)
+        close(h->fd);
+    h->fd = -1;
+    unlink(h->ruta_socket);
+}
+
+/* Los registros de 'g' llegan en hexadecimal, cada uno en little-endian. */
+uint32_t registro_gdb(const char *registros, int indice)
+{
+    uint32_t valor = 0;
+    for (int b = 3; b >= 0; b--)
+    {
+        char byte[3] = {registros[indice * 8 + b * 2], registros[indice * 8 + b * 2 + 1], '\0'};
+        valor = (valor << 8) | (uint32_t)strtoul(byte, NULL, 16);
+    }
+    return valor;
+}
+
+void anotar_muestra_perfil(HuespedPerfilado *h, const char *registros)
+{
+    ProgramaPerfilado *p = &programas_perfilados[h->programa];
+
+    if (strlen(registros) < REGISTROS_GDB_RISCV * 8)
+    {
+        muestras_perfil_perdidas++;
+        return;
+    }
+    if (p->num_muestras == p->capacidad_muestras)
+    {
+        int capacidad = p->capacidad_muestras ? 2 * p->capacidad_muestras : 1024;
+        MuestraPerfil *muestras = realloc(p->muestras, capacidad * sizeof(MuestraPerfil));
+        if (!muestras)
+        {
+            muestras_perfil_perdidas++;
+            return;
+        }
+        p->muestras = muestras;
+        p->capacidad_muestras = capacidad;
+    }
+    p->muestras[p->num_muestras++] = (MuestraPerfil){
+        .pc = registro_gdb(registros, REGISTRO_PC_RISCV), .ra = registro_gdb(registros, REGISTRO_RA_RISCV)};
+}
+
+void atender_paquete_gdb(HuespedPerfilado *h, const char *paquete)
+{
+    if (paquete[0] == 'W' || paquete[0] == 'X')
+    {
+        h->estado = GDB_CERRADO;
+        return;
+    }
+
+    if (h->estado == GDB_ESPERANDO_REGISTROS)
+    {
+        anotar_muestra_perfil(h, paquete);
+        enviar_paquete_gdb(h, "c");
+        h->estado = GDB_CORRIENDO;
+        return;
+    }
+    if (paquete[0] != 'S' && paquete[0] != 'T')
+        return;
+
+    int senial = (int)strtol((char[]){paquete[1], paquete[2], '\0'}, NULL, 16);
+    if (h->estado == GDB_SALUDO)
+    {
+        enviar_paquete_gdb(h, "c");
+        h->estado = GDB_CORRIENDO;
+    }
+    else if (senial == SENIAL_GDB_SIGINT)
+    {
+        enviar_paquete_gdb(h, "g");
+        h->estado = GDB_ESPERANDO_REGISTROS;
+    }
+    else
+    {
+        /* Una señal propia del huésped: se entrega y el SIGINT pendiente llegará después. */
+        char continuar[8];
+        snprintf(continuar, sizeof(continuar), "C%02x", senial);
+        enviar_paquete_gdb(h, continuar);
+    }
+}
+
+void leer_gdb(HuespedPerfilado *h)
+{
+    ssize_t n = recv(h->fd, h->entrada + h->largo_entrada, sizeof(h->entrada) - 1 - h->largo_entrada, MSG_DONTWAIT);
+    if (n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR))
+    {
+        h->estado = GDB_CERRADO;
+        return;
+    }
+    if (n < 0)
+        return;
+    h->largo_entrada += n;
+    h->entrada[h->largo_entrada] = '\0';
+
+    char *inicio;
+    while ((inicio = strchr(h->entrada, '$')) != NULL)
+    {
+        char *fin = strchr(inicio, '#');
+        if (!fin || fin + 2 >= h->entrada + h->largo_entrada)
+            break;
+        *fin = '\0';
+        if (send(h->fd, "+", 1, MSG_NOSIGNAL) != 1)
+            h->estado = GDB_CERRADO;
+        atender_paquete_gdb(h, inicio + 1);
+
+        int consumido = fin + 3 - h->entrada;
+        memmove(h->entrada, h->entrada + consumido, h->largo_entrada - consumido + 1);
+        h->largo_entrada -= consumido;
+    }
+    if (!inicio && h->largo_entrada > 0)
+        h->largo_entrada = h->entrada[0] = 0;
+    else if (h->largo_entrada >= (int)sizeof(h->entrada) - 1)
+        h->largo_entrada = h->entrada[0] = 0;
+}
+
+void *muestrear_huespedes_perfil(void *arg)
+{
+    struct pollfd *pfds = NULL;
+    int *indices = NULL;
+    int capacidad = 0;
+    double proximo = tiempo_monotonico() + periodo_perfil_ms / 1000.0;
+
+    (void)arg;
+    while (1)
+    {
+        int num_pfds = 0, rapidas = 0;
+        double ahora = tiempo_monotonico();
+
+        /* Las conexiones pendientes se intentan fuera del cerrojo. Solo este hilo compacta
+           la tabla, así que los índices siguen valiendo al volver a tomarlo. */
+        pthread_mutex_lock(&cerrojo_perfil);
+        int num_pendientes = 0;
+        for (int i = 0; i < num_huespedes_perfilados; i++)
+            num_pendientes += huespedes_perfilados[i].estado == GDB_CONECTANDO;
+        HuespedPerfilado *pendientes = num_pendientes > 0 ? malloc(num_pendientes * sizeof(HuespedPerfilado)) : NULL;
+        int *indices_pendientes = num_pendientes > 0 ? malloc(num_pendientes * sizeof(int)) : NULL;
+        num_pendientes = 0;
+        for (int i = 0; pendientes && indices_pendientes && i < num_huespedes_perfilados; i++)
+            if (huespedes_perfilados[i].estado == GDB_CONECTANDO)
+            {
+                pendientes[num_pendientes] = huespedes_perfilados[i];
+                indices_pendientes[num_pendientes++] = i;
+            }
+        pthread_mutex_unlock(&cerrojo_perfil);
+
+        for (int p = 0; p < num_pendientes; p++)
+            pendientes[p].fd = conectar_gdb(pendientes[p].pid, pendientes[p].ruta_socket);
+
+        pthread_mutex_lock(&cerrojo_perfil);
+        for (int p = 0; p < num_pendientes; p++)
+        {
+            HuespedPerfilado *h = &huespedes_perfilados[indices_pendientes[p]];
+            if (h->pid != pendientes[p].pid)
+            {
+                if (pendientes[p].fd >= 0)
+                    close(pendientes[p].fd);
+            }
+            else if (pendientes[p].fd == -2)
+                h->estado = GDB_CERRADO;
+            else if (pendientes[p].fd >= 0)
+            {
+                unlink(h->ruta_socket);
+                h->fd = pendientes[p].fd;
+                h->estado = GDB_SALUDO;
+                enviar_paquete_gdb(h, "?");
+            }
+        }
+        free(pendientes);
+        free(indices_pendientes);
+
+        int vivos = 0;
+        for (int i = 0; i < num_huespedes_perfilados; i++)
+        {
+            HuespedPerfilado *h = &huespedes_perfilados[i];
+            if (h->estado == GDB_CERRADO)
+            {
+                cerrar_gdb(h);
+                continue;
+            }
+            huespedes_perfilados[vivos++] = *h;
+        }
+        num_huespedes_perfilados = vivos;
+
+        if (ahora >= proximo)
+        {
+            for (int i = 0; i < num_huespedes_perfilados; i++)
+            {
+                HuespedPerfilado *h = &huespedes_perfilados[i];
+                if (h->estado == GDB_CORRIENDO && estado_huesped(h->pid) == 'R' && kill(h->pid, SIGINT) == 0)
+                    h->estado = GDB_ESPERANDO_PARADA;
+            }
+            proximo += periodo_perfil_ms / 1000.0;
+            if (proximo < ahora)
+                proximo = ahora + periodo_perfil_ms / 1000.0;
+        }
+
+        if (num_huespedes_perfilados > capacidad)
+        {
+            capacidad = num_huespedes_perfilados;
+            pfds = realloc(pfds, capacidad * sizeof(struct pollfd));
+            indices = realloc(indices, capacidad * sizeof(int));
+            if (!pfds || !indices)
+            {
+                perror("Error reservando el perfilador");
+                exit(1);
+            }
+        }
+        for (int i = 0; i < num_huespedes_perfilados; i++)
+        {
+            HuespedPerfilado *h = &huespedes_perfilados[i];
+            if (h->estado == GDB_CONECTANDO)
+                rapidas += ahora - h->alta < VENTANA_CONEXION_RAPIDA;
+            else
+            {
+                pfds[num_pfds] = (struct pollfd){.fd = h->fd, .events = POLLIN};
+                indices[num_pfds++] = i;
+            }
+        }
+        pthread_mutex_unlock(&cerrojo_perfil);
+
+        /* Recién lanzados, QEMU espera conexión antes de ejecutar: se reintenta cada 1 ms. */
+        int espera = (int)((proximo - ahora) * 1000.0) + 1;
+        if (rapidas > 0 && espera > INTERVALO_CONEXION_PERFIL_MS)
+            espera = INTERVALO_CONEXION_PERFIL_MS;
+        if (poll(pfds, num_pfds, espera) <= 0)
+            continue;
+
+        pthread_mutex_lock(&cerrojo_perfil);
+        for (int p = 0; p < num_pfds; p++)
+            if (pfds[p].revents)
+                leer_gdb(&huespedes_perfilados[indices[p]]);
+        pthread_mutex_unlock(&cerrojo_perfil);
+    }
+    return NULL;
+}
+
+/* Al salir del kernel: los sockets de los huéspedes que siguen en la tabla y el directorio.
+   El cerrojo puede tenerlo el propio muestreador si es él quien sale con exit(1). */
+void finalizar_perfilador()
+{
+    int tomado = pthread_mutex_trylock(&cerrojo_perfil) == 0;
+    for (int i = 0; i < num_huespedes_perfilados; i++)
+        unlink(huespedes_perfilados[i].ruta_socket);
+    rmdir(directorio_perfil);
+    if (tomado)
+        pthread_mutex_unlock(&cerrojo_perfil);
+}
+
+void iniciar_perfilador()
+{
+    if (periodo_perfil_ms <= 0)
+        return;
+    if (!mkdtemp(directorio_perfil))
+    {
+        perror("mkdtemp");
+        exit(1);
+    }
+    atexit(finalizar_perfilador);
+    if (pthread_create(&hilo_perfil, NULL, muestrear_huespedes_perfil, NULL) != 0)
+    {
+        perror("pthread_create");
+        exit(1);
+    }
+    pthread_detach(hilo_perfil);
+    printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Perfilador de huéspedes: gdbstub de QEMU muestreado cada %d ms.\n", periodo_perfil_ms);
+}
+
+int comparar_simbolos_elf(const void *a, const void *b)
+{
+    const SimboloElf *x = a, *y = b;
+    if (x->direccion != y->direccion)
+        return x->direccion < y->direccion ? -1 : 1;
+    return y->local - x->local;
+}
+
+/* Etiquetas de código de la symtab (las de un .S son NOTYPE locales). Con varias en la
+   misma dirección se queda la local: bucle_lectura antes que _start. */
+void cargar_simbolos_elf(ProgramaPerfilado *p)
+{
+    struct stat st;
+    int fd = open(p->ruta, O_RDONLY | O_CLOEXEC);
+
+    p->simbolos_cargados = 1;
+    if (fd == -1 || fstat(fd, &st) == -1 || st.st_size < (off_t)sizeof(Elf32_Ehdr))
+    {
+        if (fd != -1)
+            close(fd);
+        return;
+    }
+    const unsigned char *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+        return;
+
+    const Elf32_Ehdr *eh = (const Elf32_Ehdr *)base;
+    size_t tam = st.st_size;
+    if (memcmp(eh->e_ident, ELFMAG, SELFMAG) != 0 || eh->e_ident[EI_CLASS] != ELFCLASS32 ||
+        eh->e_shoff + (size_t)eh->e_shnum * sizeof(Elf32_Shdr) > tam)
+    {
+        munmap((void *)base, tam);
+        return;
+    }
+
+    const Elf32_Shdr *secciones = (const Elf32_Shdr *)(base + eh->e_shoff);
+    for (int s = 0; s < eh->e_shnum; s++)
+    {
+        const Elf32_Shdr *tabla = &secciones[s];
+        if (tabla->sh_type != SHT_SYMTAB || tabla->sh_link >= eh->e_shnum ||
+            tabla->sh_offset + (size_t)tabla->sh_size > tam)
+            continue;
+        const Elf32_Shdr *cadenas = &secciones[tabla->sh_link];
+        if (cadenas->sh_offset + (size_t)cadenas->sh_size > tam)
+            continue;
+
+        const Elf32_Sym *simbolos = (const Elf32_Sym *)(base + tabla->sh_offset);
+        int num = tabla->sh_size / sizeof(Elf32_Sym);
+        SimboloElf *lista = realloc(p->simbolos, (p->num_simbolos + num) * sizeof(SimboloElf));
+        if (!lista)
+            break;
+        p->simbolos = lista;
+
+        for (int i = 0; i < num; i++)
+        {
+            const Elf32_Sym *sym = &simbolos[i];
+            int tipo = ELF32_ST_TYPE(sym->st_info);
+            if ((tipo != STT_NOTYPE && tipo != STT_FUNC) || sym->st_shndx == SHN_UNDEF ||
+                sym->st_shndx >= eh->e_shnum || !(secciones[sym->st_shndx].sh_flags & SHF_EXECINSTR) ||
+                sym->st_name >= cadenas->sh_size)
+                continue;
+            const char *nombre = (const char *)(base + cadenas->sh_offset + sym->st_name);
+            if (!nombre[0] || nombre[0] == '$')
+                continue;
+
+            SimboloElf *destino = &p->simbolos[p->num_simbolos++];
+            destino->direccion = sym->st_value;
+            destino->local = ELF32_ST_BIND(sym->st_info) == STB_LOCAL;
+            snprintf(destino->nombre, sizeof(destino->nombre), "%.*s", (int)sizeof(destino->nombre) - 1, nombre);
+        }
+    }
+    munmap((void *)base, tam);
+
+    qsort(p->simbolos, p->num_simbolos, sizeof(SimboloElf), comparar_simbolos_elf);
+    int unicos = 0;
+    for (int i = 0; i < p->num_simbolos; i++)
+        if (unicos == 0 || p->simbolos[unicos - 1].direccion != p->simbolos[i].direccion)
+            p->simbolos[unicos++] = p->simbolos[i];
+    p->num_simbolos = unicos;
+}
+
+int simbolo_de(const ProgramaPerfilado *p, uint32_t direccion)
+{
+    int bajo = 0, alto = p->num_simbolos - 1, encontrado = -1;
+    while (bajo <= alto)
+    {
+        int medio = (bajo + alto) / 2;
+        if (p->simbolos[medio].direccion <= direccion)
+        {
+            encontrado = medio;
+            bajo = medio + 1;
+        }
+        else
+            alto = medio - 1;
+    }
+    return encontrado;
+}
+
+const char *nombre_simbolo(const ProgramaPerfilado *p, int indice)
+{
+    return indice >= 0 ? p->simbolos[indice].nombre : "?";
+}
+
+/* Los .S no guardan marcos: el único llamador conocido es el de ra. */
+void exportar_perfil()
+{
+    FASE_KERNEL(FASE_PERFIL);
+    if (periodo_perfil_ms <= 0)
+        return;
+
+    char ruta[64];
+    snprintf(ruta, sizeof(ruta), "perfil_escenario_%d.folded", escenario_actual);
+    FILE *fp = fopen(ruta, "w");
+    long total = 0;
+
+    pthread_mutex_lock(&cerrojo_perfil);
+    for (int g = 0; g < num_programas_perfilados; g++)
+    {
+        ProgramaPerfilado *p = &programas_perfilados[g];
+        if (p->num_muestras == 0)
+            continue;
+        if (!p->simbolos_cargados)
+            cargar_simbolos_elf(p);
+
+        int num_etiquetas = p->num_simbolos + 1;
+        long *por_etiqueta = calloc(num_etiquetas, sizeof(long));
+        long *por_pila = calloc((size_t)num_etiquetas * num_etiquetas, sizeof(long));
+        if (!por_etiqueta || !por_pila)
+        {
+            free(por_etiqueta);
+            free(por_pila);
+            continue;
+        }
+
+        for (int m = 0; m < p->num_muestras; m++)
+        {
+            int pc = simbolo_de(p, p->muestras[m].pc) + 1;
+            int ra = simbolo_de(p, p->muestras[m].ra) + 1;
+            por_etiqueta[pc]++;
+            por_pila[(size_t)ra * num_etiquetas + pc]++;
+        }
+
+        printf(COLOR_TABLE "\n--- Perfil de %s (%d muestras) ---\n", p->ruta, p->num_muestras);
+        printf("| %-28s | %-10s | %-8s |\n", "Etiqueta", "Muestras", "%");
+        for (int fila = 0; fila < MAX_FILAS_PERFIL; fila++)
+        {
+            int mejor = -1;
+            for (int e = 0; e < num_etiquetas; e++)
+                if (por_etiqueta[e] > 0 && (mejor < 0 || por_etiqueta[e] > por_etiqueta[mejor]))
+                    mejor = e;
+            if (mejor < 0)
+                break;
+            printf("| %-28s | %-10ld | %-8.2f |\n", nombre_simbolo(p, mejor - 1), por_etiqueta[mejor],
+                   100.0 * por_etiqueta[mejor] / p->num_muestras);
+            por_etiqueta[mejor] = 0;
+        }
+        printf(ANSI_RESET);
+
+        const char *programa = strrchr(p->ruta, '/') ? strrchr(p->ruta, '/') + 1 : p->ruta;
+        for (int ra = 0; fp && ra < num_etiquetas; ra++)
+        {
+            for (int pc = 0; pc < num_etiquetas; pc++)
+            {
+                long cuenta = por_pila[(size_t)ra * num_etiquetas + pc];
+                if (cuenta == 0)
+                    continue;
+                if (ra == pc || ra == 0)
+                    fprintf(fp, "%s;%s %ld\n", programa, nombre_simbolo(p, pc - 1), cuenta);
+                else
+                    fprintf(fp, "%s;%s;%s %ld\n", programa, nombre_simbolo(p, ra - 1), nombre_simbolo(p, pc - 1), cuenta);
+            }
+        }
+
+        total += p->num_muestras;
+        p->num_muestras = 0;
+        free(por_etiqueta);
+        free(por_pila);
+    }
+    long perdidas = muestras_perfil_perdidas;
+    muestras_perfil_perdidas = 0;
+    pthread_mutex_unlock(&cerrojo_perfil);
+
+    if (fp)
+        fclose(fp);
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Perfil del ciclo: %ld muestras en '%s'%s.\n", total, ruta,
+           perdidas > 0 ? " (con respuestas de registros incompletas descartadas)" : "");
+}
@@ -0,0 +1,14 @@
+#ifndef PERFILADOR_H
+#define PERFILADOR_H
+
+#define MAX_ARGV_PERFIL 32
+#define TAM_RUTA_SOCKET_GDB 64
+
+extern int periodo_perfil_ms;
+
+int preparar_argv_perfil(char *const argv[], char **argv_perfil, char *ruta_socket, size_t tam);
+void registrar_huesped_perfil(pid_t pid, const char *ruta_socket, int programa);
+void iniciar_perfilador();
+void exportar_perfil();
+
+#endif
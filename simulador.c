@@ -0,0 +1,784 @@
+#include "kernel.h"
+#include "simulador.h"
+
+/* El Analizador no puede pasar de la CPU con la que emitió la lectura k-1 hasta que el
+   Receptor emitió la k. */
+
+typedef struct
+{
+    int ciclo;
+    int escenario;
+    double tiempo_real;
+    int num_lecturas;
+    int *valores;
+    double *cpu_emision[2];
+    double cpu_total[2];
+    double duracion_escudo;
+} CicloGrabado;
+
+typedef enum
+{
+    PAPEL_RECEPTOR,
+    PAPEL_ANALIZADOR,
+    PAPEL_FIJO
+} PapelNodoSimulado;
+
+typedef struct
+{
+    PapelNodoSimulado papel;
+    const double *emisiones;
+    int num_emisiones;
+    double cpu_total;
+
+    double cpu;
+    double desde;
+    double objetivo;
+    int permitido;
+    int terminado;
+    int emitidos;
+    unsigned version;
+    double espera;
+} NodoSimulado;
+
+typedef struct
+{
+    double instante;
+    int nodo;
+    unsigned version;
+} EventoSimulado;
+
+typedef struct
+{
+    const CicloGrabado *ciclo;
+    const Topologia *topologia;
+    NodoSimulado nodos[MAX_NODOS_TOPOLOGIA];
+    int receptor;
+    int analizador;
+
+    EventoSimulado *eventos;
+    int num_eventos;
+    int capacidad_eventos;
+    double ahora;
+    long eventos_procesados;
+
+    double *instante_emision;
+    int por_leer;
+    int leidos;
+    int actuados;
+    EstadisticaOnline *decision;
+} Simulacion;
+
+typedef struct
+{
+    double quantums[MAX_NODOS_TOPOLOGIA];
+    int num_quantums;
+    double escala;
+} JuegoQuantums;
+
+#define MAX_BARRIDO_SIMULACION 16
+
+const char *ruta_grabacion_rafagas = NULL;
+GrabacionRafagas grabacion_rafagas;
+
+void iniciar_grabacion_rafagas()
+{
+    if (!ruta_grabacion_rafagas)
+        return;
+
+    grabacion_rafagas.fp = fopen(ruta_grabacion_rafagas, "a");
+    if (!grabacion_rafagas.fp)
+    {
+        perror(ruta_grabacion_rafagas);
+        exit(1);
+    }
+    printf(COLOR_KERNEL "[Centro de Control] " ANSI_RESET "Grabando ráfagas de CPU de los huéspedes en %s.\n", ruta_grabacion_rafagas);
+}
+
+void grabar_rafagas_ciclo(double tiempo_ciclo, double cpu_p1, double cpu_p3, double tiempo_p2)
+{
+    FILE *fp = grabacion_rafagas.fp;
+    if (!fp || escenario_actual == 0 || traza_lecturas.num_lecturas == 0)
+        return;
+
+    fprintf(fp, "ciclo %d escenario %d tiempo %.6f\n", ciclo_actual, escenario_actual, tiempo_ciclo);
+    for (int i = 0; i < traza_lecturas.num_lecturas; i++)
+    {
+        const LecturaTrazada *lectura = &traza_lecturas.lecturas[i];
+        fprintf(fp, "lectura %d %.6f %.6f\n", lectura->valor,
+                lectura->cpu_emision[ETAPA_SALIDA_P1], lectura->cpu_emision[ETAPA_SALIDA_P3]);
+    }
+    fprintf(fp, "fin %.6f %.6f %.6f\n", cpu_p1, cpu_p3, tiempo_p2);
+    fflush(fp);
+    memset(grabacion_rafagas.pids, 0, sizeof(grabacion_rafagas.pids));
+}
+
+/* Las emisiones que no se midieron se reparten entre sus vecinas; el resultado es
+   monótono y no supera la CPU total. */
+void completar_emisiones(double *cpu, int n, double *total)
+{
+    int anterior = -1;
+
+    for (int i = 0; i <= n; i++)
+    {
+        if (i < n && cpu[i] < 0.0)
+            continue;
+
+        double desde = anterior >= 0 ? cpu[anterior] : 0.0;
+        double hasta = i < n ? cpu[i] : (*total > desde ? *total : desde);
+        for (int j = anterior + 1; j < i; j++)
+            cpu[j] = desde + (hasta - desde) * (j - anterior) / (double)(i - anterior);
+        anterior = i;
+    }
+
+    for (int i = 1; i < n; i++)
+        if (cpu[i] < cpu[i - 1])
+            cpu[i] = cpu[i - 1];
+    if (n > 0 && *total < cpu[n - 1])
+        *total = cpu[n - 1];
+}
+
+CicloGrabado *cargar_rafagas(const char *ruta, int *num_ciclos)
+{
+    FILE *fp = fopen(ruta, "r");
+    if (!fp)
+    {
+        perror(ruta);
+        exit(1);
+    }
+
+    CicloGrabado *ciclos = NULL;
+    int capacidad = 0, lecturas_reservadas = 0;
+    CicloGrabado *c = NULL;
+    char linea[256];
+    int num_linea = 0;
+
+    *num_ciclos = 0;
+    while (fgets(linea, sizeof(linea), fp))
+    {
+        int valor;
+        double a, b, d;
+
+        num_linea++;
+        if (linea[0] == '#' || linea[0] == '\n')
+            continue;
+
+        if (strncmp(linea, "ciclo ", 6) == 0)
+        {
+            if (*num_ciclos == capacidad)
+            {
+                capacidad = capacidad ? capacidad * 2 : 16;
+                ciclos = realloc(ciclos, capacidad * sizeof(CicloGrabado));
+                if (!ciclos)
+                {
+                    perror("realloc");
+                    exit(1);
+                }
+            }
+            c = &ciclos[(*num_ciclos)++];
+            memset(c, 0, sizeof(CicloGrabado));
+            lecturas_reservadas = 0;
+            if (sscanf(linea, "ciclo %d escenario %d tiempo %lf", &c->ciclo, &c->escenario, &c->tiempo_real) != 3)
+                error_topologia(ruta, num_linea, "cabecera de ciclo no válida", NULL);
+        }
+        else if (c && sscanf(linea, "lectura %d %lf %lf", &valor, &a, &b) == 3)
+        {
+            if (c->num_lecturas == lecturas_reservadas)
+            {
+                lecturas_reservadas = lecturas_reservadas ? lecturas_reservadas * 2 : 64;
+                c->valores = realloc(c->valores, lecturas_reservadas * sizeof(int));
+                c->cpu_emision[0] = realloc(c->cpu_emision[0], lecturas_reservadas * sizeof(double));
+                c->cpu_emision[1] = realloc(c->cpu_emision[1], lecturas_reservadas * sizeof(double));
+                if (!c->valores || !c->cpu_emision[0] || !c->cpu_emision[1])
+                {
+                    perror("realloc");
+                    exit(1);
+                }
+            }
+            c->valores[c->num_lecturas] = valor;
+            c->cpu_emision[0][c->num_lecturas] = a;
+            c->cpu_emision[1][c->num_lecturas] = b;
+            c->num_lecturas++;
+        }
+        else if (c && sscanf(linea, "fin %lf %lf %lf", &a, &b, &d) == 3)
+        {
+            c->cpu_total[0] = a;
+            c->cpu_total[1] = b;
+            c->duracion_escudo = d;
+            completar_emisiones(c->cpu_emision[0], c->num_lecturas, &c->cpu_total[0]);
+            completar_emisiones(c->cpu_emision[1], c->num_lecturas, &c->cpu_total[1]);
+        }
+        else
+        {
+            error_topologia(ruta, num_linea, "línea no reconocida", NULL);
+        }
+    }
+    fclose(fp);
+    return ciclos;
+}
+
+Topologia *topologia_integrada(int escenario)
+{
+    static Topologia integradas[4];
+    Topologia *t = &integradas[escenario];
+
+    if (escenario < 1 || escenario > 3)
+        return NULL;
+    if (t->num_nodos > 0)
+        return t;
+
+    const char *rutas[3] = {"./code/escenariosBasicos/proceso1", "./code/escenariosBasicos/proceso3", "./code/escenariosBasicos/proceso2"};
+    const char *nombres[3] = {"p1", "p3", "p2"};
+    const double quantums[3] = {10.0, 5.0, 5.0};
+
+    snprintf(t->ruta, sizeof(t->ruta), "escenario %d integrado", escenario);
+    t->escenario = escenario;
+    t->modo = escenario == 1 ? TOPOLOGIA_SECUENCIAL : TOPOLOGIA_RR;
+    for (int i = 0; i < 3; i++)
+    {
+        NodoTopologia *nodo = &t->nodos[t->num_nodos++];
+        snprintf(nodo->nombre, sizeof(nodo->nombre), "%s", nombres[i]);
+        snprintf(nodo->ruta, sizeof(nodo->ruta), "%s", rutas[i]);
+        nodo->quantum = quantums[i];
+        nodo->nucleo = -1;
+        nodo->por_disparo = escenario != 1 && i == 2;
+    }
+    t->tuberias[t->num_tuberias++] = (TuberiaTopologia){.origen = EXTREMO_ARCHIVO, .destino = 0, .archivo = "medidas.txt"};
+    t->tuberias[t->num_tuberias++] = (TuberiaTopologia){.origen = 0, .destino = 1};
+    t->tuberias[t->num_tuberias++] = (TuberiaTopologia){.origen = 1, .destino = EXTREMO_KERNEL};
+
+    if (escenario == 1)
+    {
+        t->orden[t->num_orden++] = 0;
+        t->orden[t->num_orden++] = 2;
+        t->orden[t->num_orden++] = 1;
+    }
+    else
+    {
+        t->orden[t->num_orden++] = 0;
+        t->orden[t->num_orden++] = 1;
+        DisparoTopologia *d = &t->disparos[t->num_disparos++];
+        d->nodo = 2;
+        snprintf(d->operador, sizeof(d->operador), ">");
+        d->umbral = UMBRAL_ESCUDO;
+        snprintf(d->argumento_si, sizeof(d->argumento_si), "1");
+        snprintf(d->argumento_no, sizeof(d->argumento_no), "0");
+        d->diferido = escenario == 3;
+    }
+    return t;
+}
+
+void empujar_evento_simulado(Simulacion *sim, double instante, int nodo, unsigned version)
+{
+    if (sim->num_eventos == sim->capacidad_eventos)
+    {
+        sim->capacidad_eventos = sim->capacidad_eventos ? sim->capacidad_eventos * 2 : 64;
+        sim->eventos = realloc(sim->eventos, sim->capacidad_eventos * sizeof(EventoSimulado));
+        if (!sim->eventos)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+
+    int i = sim->num_eventos++;
+    while (i > 0 && sim->eventos[(i - 1) / 2].instante > instante)
+    {
+        sim->eventos[i] = sim->eventos[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    sim->eventos[i] = (EventoSimulado){instante, nodo, version};
+}
+
+EventoSimulado sacar_evento_simulado(Simulacion *sim)
+{
+    EventoSimulado primero = sim->eventos[0];
+    EventoSimulado ultimo = sim->eventos[--sim->num_eventos];
+    int i = 0;
+
+    while (2 * i + 1 < sim->num_eventos)
+    {
+        int hijo = 2 * i + 1;
+        if (hijo + 1 < sim->num_eventos && sim->eventos[hijo + 1].instante < sim->eventos[hijo].instante)
+            hijo++;
+        if (ultimo.instante <= sim->eventos[hijo].instante)
+            break;
+        sim->eventos[i] = sim->eventos[hijo];
+        i = hijo;
+    }
+    if (sim->num_eventos > 0)
+        sim->eventos[i] = ultimo;
+    return primero;
+}
+
+double limite_nodo_simulado(const Simulacion *sim, const NodoSimulado *n)
+{
+    if (n->papel != PAPEL_ANALIZADOR)
+        return n->cpu_total;
+
+    const NodoSimulado *receptor = &sim->nodos[sim->receptor];
+    if (receptor->terminado && receptor->emitidos >= n->num_emisiones)
+        return n->cpu_total;
+    return receptor->emitidos > 0 ? n->emisiones[receptor->emitidos - 1] : 0.0;
+}
+
+/* CPU al instante actual: avanza a ritmo 1 desde 'desde' sin pasar del objetivo. */
+void actualizar_nodo_simulado(Simulacion *sim, NodoSimulado *n)
+{
+    if (!n->permitido || n->terminado)
+        return;
+    double cpu = n->cpu + (sim->ahora - n->desde);
+    n->cpu = cpu < n->objetivo ? cpu : n->objetivo;
+    n->desde = sim->ahora;
+}
+
+void programar_nodo_simulado(Simulacion *sim, int indice);
+
+void emitir_simulado(Simulacion *sim, int indice)
+{
+    NodoSimulado *n = &sim->nodos[indice];
+
+    n->emitidos++;
+    if (indice == sim->analizador)
+    {
+        sim->instante_emision[n->emitidos - 1] = sim->ahora;
+        sim->por_leer++;
+    }
+    else if (indice == sim->receptor && sim->nodos[sim->analizador].permitido)
+    {
+        actualizar_nodo_simulado(sim, &sim->nodos[sim->analizador]);
+        programar_nodo_simulado(sim, sim->analizador);
+    }
+}
+
+void programar_nodo_simulado(Simulacion *sim, int indice)
+{
+    NodoSimulado *n = &sim->nodos[indice];
+
+    n->version++;
+    if (!n->permitido || n->terminado)
+        return;
+
+    double limite = limite_nodo_simulado(sim, n);
+    while (n->emitidos < n->num_emisiones && n->emisiones[n->emitidos] <= n->cpu &&
+           n->emisiones[n->emitidos] <= limite)
+        emitir_simulado(sim, indice);
+
+    if (n->emitidos == n->num_emisiones && n->cpu >= n->cpu_total && limite >= n->cpu_total)
+    {
+        n->terminado = 1;
+        if (indice == sim->receptor && sim->nodos[sim->analizador].permitido)
+        {
+            actualizar_nodo_simulado(sim, &sim->nodos[sim->analizador]);
+            programar_nodo_simulado(sim, sim->analizador);
+        }
+        return;
+    }
+
+    n->objetivo = n->emitidos < n->num_emisiones ? n->emisiones[n->emitidos] : n->cpu_total;
+    if (n->objetivo > limite)
+        n->objetivo = limite;
+    if (n->objetivo > n->cpu)
+        empujar_evento_simulado(sim, sim->ahora + (n->objetivo - n->cpu), indice, n->version);
+}
+
+void mover_reloj_simulado(Simulacion *sim, double instante)
+{
+    double dt = instante - sim->ahora;
+    if (dt <= 0.0)
+        return;
+
+    for (int i = 0; i < sim->topologia->num_nodos; i++)
+    {
+        NodoSimulado *n = &sim->nodos[i];
+        if (!n->permitido && !n->terminado && n->cpu < limite_nodo_simulado(sim, n))
+            n->espera += dt;
+    }
+    sim->ahora = instante;
+}
+
+void procesar_evento_simulado(Simulacion *sim)
+{
+    EventoSimulado e = sacar_evento_simulado(sim);
+    NodoSimulado *n = &sim->nodos[e.nodo];
+
+    sim->eventos_procesados++;
+    if (e.version != n->version)
+        return;
+    mover_reloj_simulado(sim, e.instante);
+    /* Un evento vigente significa que el huésped llegó a su objetivo; se fija para que el
+       redondeo no deje un resto infinitesimal que se reprograme sin fin. */
+    n->cpu = n->objetivo;
+    n->desde = sim->ahora;
+    programar_nodo_simulado(sim, e.nodo);
+}
+
+void avanzar_simulacion(Simulacion *sim, double instante)
+{
+    while (sim->num_eventos > 0 && sim->eventos[0].instante <= instante)
+        procesar_evento_simulado(sim);
+    mover_reloj_simulado(sim, instante);
+}
+
+void permitir_nodo_simulado(Simulacion *sim, int indice, int permitido)
+{
+    NodoSimulado *n = &sim->nodos[indice];
+
+    actualizar_nodo_simulado(sim, n);
+    n->permitido = permitido;
+    n->desde = sim->ahora;
+    programar_nodo_simulado(sim, indice);
+}
+
+/* El Escudo actúa sobre todo lo leído hasta su lanzamiento, como registrar_actuacion_escudo. */
+void disparar_simulado(Simulacion *sim)
+{
+    int cubiertos = sim->leidos;
+
+    avanzar_simulacion(sim, sim->ahora + sim->ciclo->duracion_escudo);
+    for (; sim->actuados < cubiertos; sim->actuados++)
+        registrar_estadistica(sim->decision, sim->ahora - sim->instante_emision[sim->actuados]);
+}
+
+void atender_registros_simulados(Simulacion *sim, int *pendientes)
+{
+    if (sim->por_leer == 0)
+        return;
+
+    sim->leidos += sim->por_leer;
+    sim->por_leer = 0;
+    int valor = sim->ciclo->valores[sim->leidos - 1];
+
+    for (int i = 0; i < sim->topologia->num_disparos; i++)
+    {
+        const DisparoTopologia *d = &sim->topologia->disparos[i];
+        const char *argumento = disparo_cumple(d, valor) ? d->argumento_si : d->argumento_no;
+        if (argumento[0] == '\0')
+            continue;
+        if (d->diferido && sim->topologia->modo == TOPOLOGIA_RR)
+            pendientes[i] = 1;
+        else
+            disparar_simulado(sim);
+    }
+}
+
+void disparar_diferidos_simulados(Simulacion *sim, int *pendientes)
+{
+    for (int i = 0; i < sim->topologia->num_disparos; i++)
+    {
+        if (pendientes[i])
+        {
+            pendientes[i] = 0;
+            disparar_simulado(sim);
+        }
+    }
+}
+
+/* Devuelve -1 si los huéspedes quedaron bloqueados. */
+double simular_ciclo(Simulacion *sim, const double *quantums)
+{
+    const Topologia *t = sim->topologia;
+    int pendientes[MAX_DISPAROS_TOPOLOGIA] = {0};
+
+    if (t->modo == TOPOLOGIA_SECUENCIAL)
+    {
+        for (int i = 0; i < t->num_orden; i++)
+        {
+            int indice = t->orden[i];
+            permitir_nodo_simulado(sim, indice, 1);
+            while (!sim->nodos[indice].terminado && sim->num_eventos > 0)
+                procesar_evento_simulado(sim);
+            if (!sim->nodos[indice].terminado)
+                return -1.0;
+            permitir_nodo_simulado(sim, indice, 0);
+            atender_registros_simulados(sim, pendientes);
+        }
+    }
+    else if (t->modo == TOPOLOGIA_RR)
+    {
+        int vivos = t->num_orden;
+        int vivo[MAX_NODOS_TOPOLOGIA];
+        for (int i = 0; i < t->num_orden; i++)
+            vivo[i] = 1;
+
+        while (vivos > 0)
+        {
+            int progreso = 0;
+            disparar_diferidos_simulados(sim, pendientes);
+            vivos = 0;
+            for (int i = 0; i < t->num_orden; i++)
+            {
+                int indice = t->orden[i];
+                if (!vivo[i])
+                    continue;
+
+                double cpu_antes = sim->nodos[indice].cpu;
+                permitir_nodo_simulado(sim, indice, 1);
+                avanzar_simulacion(sim, sim->ahora + quantums[i]);
+                permitir_nodo_simulado(sim, indice, 0);
+                progreso |= sim->nodos[indice].cpu > cpu_antes || sim->nodos[indice].terminado;
+                vivo[i] = !sim->nodos[indice].terminado;
+                atender_registros_simulados(sim, pendientes);
+                vivos += vivo[i];
+            }
+            if (!progreso && vivos > 0)
+                return -1.0;
+        }
+        disparar_diferidos_simulados(sim, pendientes);
+    }
+    else
+    {
+        for (int i = 0; i < t->num_orden; i++)
+            permitir_nodo_simulado(sim, t->orden[i], 1);
+
+        int vivos = t->num_orden;
+        while (vivos > 0)
+        {
+            if (sim->num_eventos == 0)
+                return -1.0;
+            procesar_evento_simulado(sim);
+            atender_registros_simulados(sim, pendientes);
+            vivos = 0;
+            for (int i = 0; i < t->num_orden; i++)
+                vivos += !sim->nodos[t->orden[i]].terminado;
+        }
+        atender_registros_simulados(sim, pendientes);
+    }
+    return sim->ahora;
+}
+
+void preparar_simulacion(Simulacion *sim, const CicloGrabado *c, const Topologia *t)
+{
+    EventoSimulado *eventos = sim->eventos;
+    int capacidad = sim->capacidad_eventos;
+    double *instantes = sim->instante_emision;
+    EstadisticaOnline *decision = sim->decision;
+
+    memset(sim, 0, sizeof(Simulacion));
+    sim->eventos = eventos;
+    sim->capacidad_eventos = capacidad;
+    sim->instante_emision = instantes;
+    sim->decision = decision;
+    sim->ciclo = c;
+    sim->topologia = t;
+    sim->receptor = sim->analizador = NODO_DESCONOCIDO;
+
+    for (int i = 0; i < t->num_nodos; i++)
+    {
+        NodoSimulado *n = &sim->nodos[i];
+        switch (slot_telemetria_por_nombre(t->nodos[i].ruta))
+        {
+        case 0:
+            n->papel = PAPEL_RECEPTOR;
+            n->emisiones = c->cpu_emision[0];
+            n->num_emisiones = c->num_lecturas;
+            n->cpu_total = c->cpu_total[0];
+            sim->receptor = i;
+            break;
+        case 2:
+            n->papel = PAPEL_ANALIZADOR;
+            n->emisiones = c->cpu_emision[1];
+            n->num_emisiones = c->num_lecturas;
+            n->cpu_total = c->cpu_total[1];
+            sim->analizador = i;
+            break;
+        default:
+            n->papel = PAPEL_FIJO;
+            n->cpu_total = c->duracion_escudo;
+            break;
+        }
+    }
+}
+
+void validar_topologia_simulable(const Topologia *t)
+{
+    int receptor = NODO_DESCONOCIDO, analizador = NODO_DESCONOCIDO, cadena = 0;
+
+    for (int i = 0; i < t->num_nodos; i++)
+    {
+        int slot = slot_telemetria_por_nombre(t->nodos[i].ruta);
+        if (slot == 0 && !t->nodos[i].por_disparo)
+            receptor = i;
+        else if (slot == 2 && !t->nodos[i].por_disparo)
+            analizador = i;
+    }
+    for (int i = 0; i < t->num_tuberias; i++)
+    {
+        const TuberiaTopologia *tub = &t->tuberias[i];
+        if (receptor >= 0 && analizador >= 0 &&
+            ((tub->origen == EXTREMO_ARCHIVO && tub->destino == receptor) ||
+             (tub->origen == receptor && tub->destino == analizador) ||
+             (tub->origen == analizador && tub->destino == EXTREMO_KERNEL)))
+            cadena++;
+    }
+    if (cadena != 3)
+        error_topologia(t->ruta, 0, "el simulador solo reproduce la cadena medidas.txt -> Receptor -> Analizador -> kernel", NULL);
+}
+
+int leer_barrido_quantums(const char *texto, JuegoQuantums *juegos)
+{
+    int num_juegos = 0;
+    char copia[256];
+    char *guardado = NULL;
+
+    snprintf(copia, sizeof(copia), "%s", texto);
+    for (char *juego = strtok_r(copia, ",", &guardado); juego && num_juegos < MAX_BARRIDO_SIMULACION;
+         juego = strtok_r(NULL, ",", &guardado))
+    {
+        JuegoQuantums *j = &juegos[num_juegos++];
+        char *resto = juego;
+        memset(j, 0, sizeof(JuegoQuantums));
+        while (*resto && j->num_quantums < MAX_NODOS_TOPOLOGIA)
+        {
+            char *fin;
+            double q = strtod(resto, &fin);
+            if (fin == resto || q <= 0.0)
+                return -1;
+            j->quantums[j->num_quantums++] = q;
+            resto = *fin == ':' ? fin + 1 : fin;
+            if (*fin && *fin != ':')
+                return -1;
+        }
+    }
+    return num_juegos;
+}
+
+void ejecutar_simulador(const char *ruta, const char *barrido)
+{
+    static const double ESCALAS_BARRIDO[] = {2.0, 1.0, 0.5, 0.2, 0.1, 0.05, 0.02};
+    JuegoQuantums juegos[MAX_BARRIDO_SIMULACION];
+    int num_juegos = 0;
+    int num_ciclos;
+
+    CicloGrabado *ciclos = cargar_rafagas(ruta, &num_ciclos);
+    if (barrido)
+    {
+        num_juegos = leer_barrido_quantums(barrido, juegos);
+        if (num_juegos <= 0)
+        {
+            fprintf(stderr, COLOR_ERROR "[Simulador] ERROR: barrido de quantums no válido: %s\n" ANSI_RESET, barrido);
+            exit(1);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < sizeof(ESCALAS_BARRIDO) / sizeof(ESCALAS_BARRIDO[0]); i++)
+            juegos[num_juegos++] = (JuegoQuantums){.escala = ESCALAS_BARRIDO[i]};
+    }
+
+    printf(COLOR_KERNEL "[Simulador] " ANSI_RESET "%d ciclos grabados en %s.\n", num_ciclos, ruta);
+
+    Simulacion sim = {0};
+    static EstadisticaOnline decision, tiempo_ciclo, espera[2];
+    int max_lecturas = 1;
+    for (int c = 0; c < num_ciclos; c++)
+        if (ciclos[c].num_lecturas > max_lecturas)
+            max_lecturas = ciclos[c].num_lecturas;
+    sim.instante_emision = malloc(max_lecturas * sizeof(double));
+    sim.decision = &decision;
+    if (!sim.instante_emision)
+    {
+        perror("malloc");
+        exit(1);
+    }
+
+    long eventos_totales = 0;
+    double inicio_simulacion = tiempo_monotonico();
+
+    for (int e = 1; e <= 3; e++)
+    {
+        const Topologia *t = topologias[e] ? topologias[e] : topologia_integrada(e);
+        double tiempo_real = 0.0;
+        int ciclos_escenario = 0;
+
+        for (int c = 0; c < num_ciclos; c++)
+        {
+            if (ciclos[c].escenario == e)
+            {
+                tiempo_real += ciclos[c].tiempo_real;
+                ciclos_escenario++;
+            }
+        }
+        if (ciclos_escenario == 0)
+            continue;
+
+        validar_topologia_simulable(t);
+        printf(COLOR_CICLO "\n--- Escenario %d: %s, modo %s, %d ciclos (real medio %.3f s) ---\n" ANSI_RESET,
+               e, t->ruta, NOMBRES_MODOS_TOPOLOGIA[t->modo], ciclos_escenario, tiempo_real / ciclos_escenario);
+        printf("| %-18s | %-12s | %-12s | %-12s | %-13s | %-13s | %-9s |\n",
+               "Quantums (s)", "Ciclo (s)", "Espera P1", "Espera P3", "Decisión med.", "Decisión p99", "Actuadas");
+
+        for (int j = 0; j < num_juegos; j++)
+        {
+            double quantums[MAX_NODOS_TOPOLOGIA];
+            char etiqueta[64] = "";
+            size_t largo = 0;
+            int actuadas = 0, lecturas = 0, bloqueados = 0;
+
+            for (int i = 0; i < t->num_orden; i++)
+            {
+                double q = t->nodos[t->orden[i]].quantum;
+                if (juegos[j].escala > 0.0)
+                    q *= juegos[j].escala;
+                else if (i < juegos[j].num_quantums)
+                    q = juegos[j].quantums[i];
+                quantums[i] = q;
+                largo += snprintf(etiqueta + largo, sizeof(etiqueta) - largo, "%s%g", i ? ":" : "", q);
+            }
+            if (t->modo != TOPOLOGIA_RR)
+                snprintf(etiqueta, sizeof(etiqueta), "(sin quantum)");
+
+            iniciar_estadistica(&decision, ESCALA_SEGUNDOS);
+            iniciar_estadistica(&tiempo_ciclo, ESCALA_SEGUNDOS);
+            iniciar_estadistica(&espera[0], ESCALA_SEGUNDOS);
+            iniciar_estadistica(&espera[1], ESCALA_SEGUNDOS);
+
+            for (int c = 0; c < num_ciclos; c++)
+            {
+                if (ciclos[c].escenario != e)
+                    continue;
+                preparar_simulacion(&sim, &ciclos[c], t);
+                double duracion = simular_ciclo(&sim, quantums);
+                eventos_totales += sim.eventos_procesados;
+                if (duracion < 0.0)
+                {
+                    bloqueados++;
+                    continue;
+                }
+                registrar_estadistica(&tiempo_ciclo, duracion);
+                registrar_estadistica(&espera[0], sim.nodos[sim.receptor].espera);
+                registrar_estadistica(&espera[1], sim.nodos[sim.analizador].espera);
+                actuadas += sim.actuados;
+                lecturas += ciclos[c].num_lecturas;
+            }
+
+            char decision_media[16] = "-", decision_p99[16] = "-";
+            if (decision.muestras > 0)
+            {
+                snprintf(decision_media, sizeof(decision_media), "%.4f", decision.media);
+                snprintf(decision_p99, sizeof(decision_p99), "%.4f", percentil_estadistica(&decision, 0.99));
+            }
+            printf("| %-18s | %12.3f | %12.3f | %12.3f | %13s | %13s | %4d/%-4d |%s\n",
+                   etiqueta, tiempo_ciclo.media, espera[0].media, espera[1].media,
+                   decision_media, decision_p99, actuadas, lecturas,
+                   bloqueados ? " bloqueo" : "");
+
+            if (t->modo != TOPOLOGIA_RR)
+                break;
+        }
+    }
+
+    double duracion_simulacion = tiempo_monotonico() - inicio_simulacion;
+    printf(COLOR_KERNEL "\n[Simulador] " ANSI_RESET "%ld eventos en %.2f ms (%.2f millones de eventos/s).\n",
+           eventos_totales, duracion_simulacion * 1000.0,
+           duracion_simulacion > 0.0 ? eventos_totales / duracion_simulacion / 1e6 : 0.0);
+
+    for (int c = 0; c < num_ciclos; c++)
+    {
+        free(ciclos[c].valores);
+        free(ciclos[c].cpu_emision[0]);
+        free(ciclos[c].cpu_emision[1]);
+    }
+    free(ciclos);
+    free(sim.instante_emision);
+    free(sim.eventos);
+}
@@ -0,0 +1,20 @@
+#ifndef SIMULADOR_H
+#define SIMULADOR_H
+
+#include "topologia.h"
+
+typedef struct
+{
+    FILE *fp;
+    pid_t pids[3];
+} GrabacionRafagas;
+
+extern GrabacionRafagas grabacion_rafagas;
+extern const char *ruta_grabacion_rafagas;
+
+void iniciar_grabacion_rafagas();
+void grabar_rafagas_ciclo(double tiempo_ciclo, double cpu_p1, double cpu_p3, double tiempo_p2);
+Topologia *topologia_integrada(int escenario);
+void ejecutar_simulador(const char *ruta, const char *barrido);
+
+#endif
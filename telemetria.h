@@ -0,0 +1,88 @@
+#ifndef TELEMETRIA_H
+#define TELEMETRIA_H
+
+#include <stdint.h>
+#include <string.h>
+
+/* Página de telemetría en memoria compartida (/dev/shm) que publica el kernel y leen
+   los monitores externos. Un solo escritor (el kernel) y cualquier número de lectores:
+   la coherencia se garantiza con un seqlock, sin syscalls ni bloqueos en el escritor. */
+
+#define TELEMETRIA_NOMBRE "/kernel_proyecto_telemetria"
+#define TELEMETRIA_MAGIA 0x4B504D54u /* "TMPK" */
+#define TELEMETRIA_VERSION 1
+
+typedef enum
+{
+    TEL_INACTIVO = 0,
+    TEL_EJECUTANDO,
+    TEL_DETENIDO,
+    TEL_TERMINADO
+} EstadoTelemetria;
+
+typedef struct
+{
+    int32_t pid;
+    uint32_t estado;
+    uint32_t pausas;
+    uint32_t reanudaciones;
+    uint64_t ultimo_pc;
+    double quantum_actual;
+    double instante_estado;
+    double quantum_dado_total;
+    double cpu_media;
+    double utilizacion_quantum_media;
+} TelemetriaProceso;
+
+typedef struct
+{
+    uint32_t magia;
+    uint32_t version;
+    uint32_t tam_pagina;
+    int32_t pid_kernel;
+
+    /* Impar mientras el kernel escribe. */
+    uint32_t secuencia;
+    uint32_t escenario;
+    uint32_t ciclo;
+    uint32_t politica;
+    double instante_publicacion;
+
+    TelemetriaProceso procesos[3];
+
+    uint64_t ciclos_completados;
+    double tiempo_ciclo_ultimo;
+    double tiempo_ciclo_media;
+    double tiempo_ciclo_p99;
+    double tiempo_muerto_media;
+    double latencia_extremo_p50;
+    double latencia_extremo_p99;
+} PaginaTelemetria;
+
+static inline void telemetria_comenzar_escritura(PaginaTelemetria *pagina)
+{
+    __atomic_store_n(&pagina->secuencia, pagina->secuencia + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void telemetria_terminar_escritura(PaginaTelemetria *pagina)
+{
+    __atomic_store_n(&pagina->secuencia, pagina->secuencia + 1, __ATOMIC_RELEASE);
+}
+
+/* Copia una instantánea coherente de la página; reintenta si el kernel la modificó
+   durante la lectura. */
+static inline void telemetria_leer(const PaginaTelemetria *pagina, PaginaTelemetria *copia)
+{
+    uint32_t antes, despues;
+    do
+    {
+        while ((antes = __atomic_load_n(&pagina->secuencia, __ATOMIC_ACQUIRE)) & 1u)
+            ;
+        memcpy(copia, (const void *)pagina, sizeof(PaginaTelemetria));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        despues = __atomic_load_n(&pagina->secuencia, __ATOMIC_RELAXED);
+    } while (antes != despues);
+}
+
+#endif
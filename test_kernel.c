@@ -0,0 +1,288 @@
+/* Pruebas de las funciones puras del orquestador: no lanzan huéspedes ni necesitan QEMU.
+   Incluye kernel.c sin su main, como bench_kernel.c.
+
+   make test */
+
+#define KERNEL_SIN_MAIN
+#include "kernel.c"
+
+static int comprobaciones = 0;
+static int fallos = 0;
+static char directorio_temporal[] = "/tmp/test_kernel_XXXXXX";
+
+void comprobar(int condicion, const char *descripcion)
+{
+    comprobaciones++;
+    if (!condicion)
+    {
+        fallos++;
+        printf(COLOR_ERROR "  FALLO: %s\n" ANSI_RESET, descripcion);
+    }
+}
+
+int casi_igual(double a, double b, double tolerancia)
+{
+    return a - b <= tolerancia && b - a <= tolerancia;
+}
+
+void probar_plazos_edf()
+{
+    ProcesoStats s, total;
+    memset(&s, 0, sizeof(s));
+    memset(&total, 0, sizeof(total));
+
+    registrar_trabajo_edf(&s, 1.0, 2.0);
+    registrar_trabajo_edf(&s, 3.0, 2.5);
+    registrar_trabajo_edf(&s, 2.0, 2.2);
+    comprobar(s.edf_activaciones == 3 && s.edf_plazos_perdidos == 1, "EDF: activaciones y plazos perdidos");
+    comprobar(casi_igual(s.edf_retraso_max, 0.5, 1e-9) && casi_igual(s.edf_retraso_total, 0.5, 1e-9), "EDF: retraso del plazo perdido");
+    comprobar(casi_igual(s.edf_holgura_min, 0.2, 1e-9) && casi_igual(s.edf_holgura_total, 1.2, 1e-9), "EDF: holgura de los plazos cumplidos");
+
+    /* Solo pérdidas: la holgura mínima queda sin definir hasta que otro aporte un plazo cumplido. */
+    ProcesoStats perdidos;
+    memset(&perdidos, 0, sizeof(perdidos));
+    registrar_trabajo_edf(&perdidos, 5.0, 3.0);
+    comprobar(perdidos.edf_holgura_min == 0.0 && casi_igual(perdidos.edf_retraso_max, 2.0, 1e-9), "EDF: solo plazos perdidos");
+
+    combinar_stats_edf(&total, &perdidos);
+    combinar_stats_edf(&total, &s);
+    comprobar(total.edf_activaciones == 4 && total.edf_plazos_perdidos == 2, "EDF: combinar activaciones");
+    comprobar(casi_igual(total.edf_retraso_max, 2.0, 1e-9) && casi_igual(total.edf_retraso_total, 2.5, 1e-9), "EDF: combinar retrasos");
+    comprobar(casi_igual(total.edf_holgura_min, 0.2, 1e-9), "EDF: la holgura mínima llega de quien tuvo plazos cumplidos");
+}
+
+void probar_estadistica()
+{
+    EstadisticaOnline e;
+    iniciar_estadistica(&e, 1.0);
+    comprobar(percentil_estadistica(&e, 0.5) == 0.0 && desviacion_estadistica(&e) == 0.0, "estadística vacía");
+
+    for (int i = 1; i <= 1000; i++)
+        registrar_estadistica(&e, i);
+    comprobar(e.muestras == 1000 && e.minimo == 1.0 && e.maximo == 1000.0, "Welford: muestras y extremos");
+    comprobar(casi_igual(e.media, 500.5, 1e-9), "Welford: media");
+    comprobar(casi_igual(desviacion_estadistica(&e), 288.8194360957494, 1e-6), "Welford: desviación muestral");
+    comprobar(casi_igual(percentil_estadistica(&e, 0.50), 500.0, 500.0 * 0.03), "HDR: p50 dentro del 3%");
+    comprobar(casi_igual(percentil_estadistica(&e, 0.99), 990.0, 990.0 * 0.03), "HDR: p99 dentro del 3%");
+    comprobar(percentil_estadistica(&e, 1.0) <= e.maximo && percentil_estadistica(&e, 0.0) >= e.minimo, "HDR: percentiles acotados por los extremos");
+
+    int acotado = 1;
+    for (double v = 1e-6; v < 1e3; v *= 1.37)
+    {
+        double representado = valor_cubeta_hdr(indice_hdr(v, ESCALA_SEGUNDOS), ESCALA_SEGUNDOS);
+        if (v * ESCALA_SEGUNDOS >= HDR_SUBCUBETAS && !casi_igual(representado, v, v * 0.03))
+            acotado = 0;
+    }
+    comprobar(acotado, "HDR: error relativo de cubeta dentro del 3%");
+    comprobar(casi_igual(raiz_cuadrada(2.0), 1.4142135623730951, 1e-12), "raíz cuadrada por Newton");
+}
+
+void probar_indice_jain()
+{
+    ProcesoStats *procesos[3] = {&p1_full_stats, &p2_full_stats, &p3_full_stats};
+    for (int p = 0; p < 3; p++)
+    {
+        memset(procesos[p], 0, sizeof(ProcesoStats));
+        procesos[p]->completados = 1;
+        procesos[p]->retorno_total = 2.0;
+        procesos[p]->espera_total = 0.5;
+    }
+    comprobar(casi_igual(indice_jain_ciclo(), 1.0, 1e-12), "Jain: todos al mismo ritmo");
+
+    p2_full_stats.espera_total = 2.0;
+    p3_full_stats.espera_total = 2.0;
+    comprobar(casi_igual(indice_jain_ciclo(), 1.0 / 3.0, 1e-12), "Jain: uno solo acapara la CPU");
+
+    p3_full_stats.completados = 0;
+    p2_full_stats.espera_total = 1.5;
+    comprobar(casi_igual(indice_jain_ciclo(), 0.8, 1e-12), "Jain: los procesos sin completar no cuentan");
+
+    for (int p = 0; p < 3; p++)
+        memset(procesos[p], 0, sizeof(ProcesoStats));
+    comprobar(indice_jain_ciclo() == 0.0, "Jain: ciclo sin procesos completados");
+}
+
+void probar_anillo_traza()
+{
+    char ruta_volcado[PATH_MAX];
+    snprintf(ruta_volcado, sizeof(ruta_volcado), "%s/volcado.txt", directorio_temporal);
+
+    AnilloTraza a;
+    memset(&a, 0, sizeof(a));
+    a.ruta_volcado = ruta_volcado;
+    a.max_estados = 4;
+    a.tam_arena = (unsigned long)a.max_estados * PALABRAS_MEDIAS_ESTADO_TRAZA + RANURAS_ESTADO_TRAZA + 1;
+    a.arena = malloc(a.tam_arena * sizeof(uint32_t));
+    a.inicio_estado = malloc(a.max_estados * sizeof(unsigned long));
+    pthread_mutex_init(&a.cerrojo, NULL);
+
+    /* x1 solo cambia en el primer estado: tras descartarlo tiene que seguir en la base. */
+    char linea[128];
+    for (int i = 0; i < 7; i++)
+    {
+        snprintf(linea, sizeof(linea), "pc %08x", 0x10000 + 4 * i);
+        procesar_linea_traza(&a, linea);
+        snprintf(linea, sizeof(linea), i == 0 ? "x1/ra 0000abcd x2/sp %08x" : "x2/sp %08x", 0x7fff0 - i);
+        procesar_linea_traza(&a, linea);
+        snprintf(linea, sizeof(linea), "mstatus 00000000 f0 deadbeef");
+        procesar_linea_traza(&a, linea);
+    }
+    comprobar(a.estados_procesados == 6 && a.num_estados == 4 && a.hay_pendiente, "anillo: conserva los últimos estados");
+    comprobar(a.palabras_guardadas == 4 + 5 * 3, "anillo: cada estado guarda solo las ranuras que cambiaron");
+
+    volcar_anillo_traza(&a);
+    FILE *fp = fopen(ruta_volcado, "r");
+    comprobar(fp != NULL, "anillo: volcado");
+    if (!fp)
+        return;
+
+    int estado = 0, en_orden = 1, registros_bien = 1;
+    char texto[256];
+    while (fgets(texto, sizeof(texto), fp))
+    {
+        unsigned int pc, x1, x2;
+        if (sscanf(texto, " pc %x", &pc) == 1)
+        {
+            if (pc != 0x10000u + 4 * (estado + 2))
+                en_orden = 0;
+            estado++;
+        }
+        else if (sscanf(texto, " x0 %*x x1 %x x2 %x", &x1, &x2) == 2)
+        {
+            if (x1 != 0xabcd || x2 != 0x7fff0u - (estado + 1))
+                registros_bien = 0;
+        }
+    }
+    fclose(fp);
+    comprobar(estado == 5 && en_orden, "anillo: volcado del más antiguo al pendiente");
+    comprobar(registros_bien, "anillo: reconstrucción de las diferencias");
+
+    free(a.arena);
+    free(a.inicio_estado);
+}
+
+void escribir_archivo(const char *ruta, const char *contenido)
+{
+    FILE *fp = fopen(ruta, "w");
+    if (!fp)
+    {
+        perror(ruta);
+        exit(1);
+    }
+    fputs(contenido, fp);
+    fclose(fp);
+}
+
+/* error_topologia termina el proceso: cada caso se carga en un hijo y se mira su stderr. */
+int topologia_rechazada(const char *contenido, const char *mensaje_esperado)
+{
+    char ruta[PATH_MAX];
+    snprintf(ruta, sizeof(ruta), "%s/mala.top", directorio_temporal);
+    escribir_archivo(ruta, contenido);
+
+    int tuberia[2];
+    if (pipe(tuberia) == -1)
+    {
+        perror("pipe");
+        exit(1);
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        dup2(tuberia[1], STDERR_FILENO);
+        close(tuberia[0]);
+        cargar_topologia(ruta);
+        _exit(0);
+    }
+    close(tuberia[1]);
+
+    char salida[512];
+    size_t largo = 0;
+    ssize_t n;
+    while ((n = read(tuberia[0], salida + largo, sizeof(salida) - 1 - largo)) > 0)
+        largo += n;
+    salida[largo] = '\0';
+    close(tuberia[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 1 && strstr(salida, mensaje_esperado) != NULL;
+}
+
+void probar_topologias()
+{
+    char ruta[PATH_MAX];
+    snprintf(ruta, sizeof(ruta), "%s/buena.top", directorio_temporal);
+    escribir_archivo(ruta,
+                     "# Escenario 2 declarado\n"
+                     "escenario 2\n"
+                     "modo rr\n"
+                     "nodo p1 ./proceso1 quantum=0.5\n"
+                     "nodo p3 ./proceso3 quantum=0.3 nucleo=1\n"
+                     "nodo p2 ./proceso2 disparo\n"
+                     "entrada medidas.txt p1 capacidad=65536\n"
+                     "tuberia p1 p3\n"
+                     "tuberia p3 kernel\n"
+                     "disparo p2 > 90 1 0 diferido\n"
+                     "orden p3\n");
+    cargar_topologia(ruta);
+
+    const Topologia *t = topologias[2];
+    comprobar(t != NULL && t->escenario == 2 && t->modo == TOPOLOGIA_RR, "topología: escenario y modo");
+    if (!t)
+        return;
+    comprobar(t->num_nodos == 3 && t->nodos[0].quantum == 0.5 && t->nodos[1].nucleo == 1 && t->nodos[2].por_disparo,
+              "topología: nodos y opciones");
+    comprobar(t->num_tuberias == 3 && t->tuberias[0].origen == EXTREMO_ARCHIVO && t->tuberias[0].destino == 0 &&
+                  t->tuberias[0].capacidad == 65536 && t->tuberias[2].destino == EXTREMO_KERNEL,
+              "topología: tuberías y extremos");
+    comprobar(t->num_orden == 2 && t->orden[0] == 1 && t->orden[1] == 0, "topología: el orden explícito va primero");
+
+    const DisparoTopologia *d = &t->disparos[0];
+    comprobar(t->num_disparos == 1 && d->nodo == 2 && d->diferido && strcmp(d->argumento_si, "1") == 0 &&
+                  strcmp(d->argumento_no, "0") == 0,
+              "topología: regla de disparo");
+    comprobar(disparo_cumple(d, 91) && !disparo_cumple(d, 90), "topología: operador de disparo");
+
+    char esperado[PATH_MAX + 32];
+    snprintf(esperado, sizeof(esperado), "%s/mala.top:3:", directorio_temporal);
+    comprobar(topologia_rechazada("escenario 2\nnodo p1 ./p1\nnodo p1 ./p2\n", esperado), "topología: nodo repetido con su línea");
+    snprintf(esperado, sizeof(esperado), "%s/mala.top:2:", directorio_temporal);
+    comprobar(topologia_rechazada("escenario 2\nmodo lote\n", esperado), "topología: modo desconocido con su línea");
+    comprobar(topologia_rechazada("escenario 2\nnodo a ./a\nnodo b ./b\ntuberia a b\ntuberia b a\n", "forman un ciclo"),
+              "topología: ciclo en el grafo");
+    comprobar(topologia_rechazada("escenario 2\nnodo a ./a\nnodo b ./b\ntuberia a kernel\ndisparo b > 1 1\n", "sin la marca"),
+              "topología: disparo sobre un nodo inicial");
+    comprobar(topologia_rechazada("modo rr\nnodo a ./a\n", "falta la directiva"), "topología: sin escenario");
+}
+
+int main()
+{
+    if (!mkdtemp(directorio_temporal))
+    {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    printf(COLOR_TABLE "\n--- Pruebas del orquestador ---\n" ANSI_RESET);
+    probar_plazos_edf();
+    probar_estadistica();
+    probar_indice_jain();
+    probar_anillo_traza();
+    probar_topologias();
+
+    char ruta[PATH_MAX];
+    const char *archivos[] = {"volcado.txt", "buena.top", "mala.top"};
+    for (size_t i = 0; i < sizeof(archivos) / sizeof(archivos[0]); i++)
+    {
+        snprintf(ruta, sizeof(ruta), "%s/%s", directorio_temporal, archivos[i]);
+        unlink(ruta);
+    }
+    rmdir(directorio_temporal);
+
+    printf("%s%d de %d comprobaciones correctas.\n" ANSI_RESET, fallos ? COLOR_ERROR : ANSI_GREEN,
+           comprobaciones - fallos, comprobaciones);
+    return fallos ? 1 : 0;
+}
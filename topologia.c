@@ -0,0 +1,587 @@
+#include "kernel.h"
+#include "topologia.h"
+#include "backend_es.h"
+#include "canal_control.h"
+
+const char *NOMBRES_MODOS_TOPOLOGIA[] = {"secuencial", "rr", "paralelo"};
+Topologia *topologias[5];
+
+/* linea 0 indica un error del grafo completo, detectado al validar. */
+void error_topologia(const char *ruta, int linea, const char *mensaje, const char *detalle)
+{
+    char posicion[32] = "";
+    if (linea > 0)
+        snprintf(posicion, sizeof(posicion), "%d:", linea);
+    fprintf(stderr, COLOR_ERROR "[Control Central] ERROR: %s:%s %s%s%s\n" ANSI_RESET,
+            ruta, posicion, mensaje, detalle ? " " : "", detalle ? detalle : "");
+    exit(1);
+}
+
+int buscar_nodo_topologia(const Topologia *t, const char *nombre)
+{
+    for (int i = 0; i < t->num_nodos; i++)
+        if (strcmp(t->nodos[i].nombre, nombre) == 0)
+            return i;
+    return NODO_DESCONOCIDO;
+}
+
+/* Cada nodo tiene una sola entrada y una sola salida estándar, así que un ciclo en el
+   grafo solo puede ser un anillo: basta con seguir las salidas desde cada nodo. */
+void validar_topologia(Topologia *t)
+{
+    int entradas[MAX_NODOS_TOPOLOGIA] = {0}, salidas[MAX_NODOS_TOPOLOGIA] = {0};
+    int siguiente[MAX_NODOS_TOPOLOGIA];
+    int hacia_kernel = 0;
+
+    if (t->escenario == 0)
+        error_topologia(t->ruta, 0, "falta la directiva", "escenario");
+
+    for (int i = 0; i < t->num_nodos; i++)
+        siguiente[i] = NODO_DESCONOCIDO;
+
+    for (int i = 0; i < t->num_tuberias; i++)
+    {
+        const TuberiaTopologia *tub = &t->tuberias[i];
+        if (tub->destino >= 0)
+            entradas[tub->destino]++;
+        else
+            hacia_kernel++;
+        if (tub->origen >= 0)
+        {
+            salidas[tub->origen]++;
+            siguiente[tub->origen] = tub->destino;
+        }
+    }
+
+    if (hacia_kernel > 1)
+        error_topologia(t->ruta, 0, "solo puede haber una tubería hacia el kernel", NULL);
+    if (t->num_disparos > 0 && hacia_kernel == 0)
+        error_topologia(t->ruta, 0, "las reglas de disparo necesitan una tubería hacia el kernel", NULL);
+
+    for (int i = 0; i < t->num_nodos; i++)
+    {
+        const NodoTopologia *nodo = &t->nodos[i];
+        if (entradas[i] > 1 || salidas[i] > 1)
+            error_topologia(t->ruta, 0, "un nodo admite una sola tubería de entrada y una de salida:", nodo->nombre);
+        if (nodo->por_disparo && (entradas[i] || salidas[i]))
+            error_topologia(t->ruta, 0, "un nodo de disparo no puede tener tuberías:", nodo->nombre);
+
+        int actual = i;
+        for (int pasos = 0; actual >= 0; pasos++)
+        {
+            if (pasos > t->num_nodos)
+                error_topologia(t->ruta, 0, "las tuberías forman un ciclo a través de", nodo->nombre);
+            actual = siguiente[actual];
+        }
+    }
+
+    for (int i = 0; i < t->num_disparos; i++)
+        if (!t->nodos[t->disparos[i].nodo].por_disparo)
+            error_topologia(t->ruta, 0, "la regla de disparo apunta a un nodo sin la marca 'disparo':", t->nodos[t->disparos[i].nodo].nombre);
+
+    int en_orden[MAX_NODOS_TOPOLOGIA] = {0};
+    for (int i = 0; i < t->num_orden; i++)
+    {
+        if (t->nodos[t->orden[i]].por_disparo || en_orden[t->orden[i]])
+            error_topologia(t->ruta, 0, "el orden solo puede nombrar una vez cada nodo inicial:", t->nodos[t->orden[i]].nombre);
+        en_orden[t->orden[i]] = 1;
+    }
+    for (int i = 0; i < t->num_nodos; i++)
+        if (!t->nodos[i].por_disparo && !en_orden[i])
+            t->orden[t->num_orden++] = i;
+
+    if (t->num_orden == 0)
+        error_topologia(t->ruta, 0, "no hay ningún nodo inicial", NULL);
+}
+
+void cargar_topologia(const char *ruta)
+{
+    FILE *fp = fopen(ruta, "r");
+    if (!fp)
+    {
+        perror(ruta);
+        exit(1);
+    }
+
+    Topologia *t = calloc(1, sizeof(Topologia));
+    if (!t)
+    {
+        perror("calloc");
+        exit(1);
+    }
+    snprintf(t->ruta, sizeof(t->ruta), "%s", ruta);
+    t->modo = TOPOLOGIA_RR;
+
+    char linea[512];
+    int num_linea = 0;
+    while (fgets(linea, sizeof(linea), fp))
+    {
+        char *tokens[16];
+        int n = 0;
+        char *guardado = NULL;
+
+        num_linea++;
+        char *comentario = strchr(linea, '#');
+        if (comentario)
+            *comentario = '\0';
+        for (char *token = strtok_r(linea, " \t\r\n", &guardado); token && n < 16; token = strtok_r(NULL, " \t\r\n", &guardado))
+            tokens[n++] = token;
+        if (n == 0)
+            continue;
+
+        if (strcmp(tokens[0], "escenario") == 0 && n == 2)
+        {
+            t->escenario = atoi(tokens[1]);
+            if (t->escenario < 1 || t->escenario > 4)
+                error_topologia(ruta, num_linea, "escenario fuera de rango (1-4):", tokens[1]);
+        }
+        else if (strcmp(tokens[0], "modo") == 0 && n == 2)
+        {
+            int modo = -1;
+            for (int m = 0; m < 3; m++)
+                if (strcmp(tokens[1], NOMBRES_MODOS_TOPOLOGIA[m]) == 0)
+                    modo = m;
+            if (modo < 0)
+                error_topologia(ruta, num_linea, "modo desconocido:", tokens[1]);
+            t->modo = modo;
+        }
+        else if (strcmp(tokens[0], "nodo") == 0 && n >= 3)
+        {
+            if (t->num_nodos == MAX_NODOS_TOPOLOGIA)
+                error_topologia(ruta, num_linea, "demasiados nodos", NULL);
+            if (buscar_nodo_topologia(t, tokens[1]) != NODO_DESCONOCIDO || strcmp(tokens[1], "kernel") == 0)
+                error_topologia(ruta, num_linea, "nombre de nodo repetido o reservado:", tokens[1]);
+
+            NodoTopologia *nodo = &t->nodos[t->num_nodos++];
+            snprintf(nodo->nombre, sizeof(nodo->nombre), "%s", tokens[1]);
+            snprintf(nodo->ruta, sizeof(nodo->ruta), "%s", tokens[2]);
+            nodo->linea = num_linea;
+            nodo->quantum = 5.0;
+            nodo->nucleo = -1;
+            for (int i = 3; i < n; i++)
+            {
+                if (strncmp(tokens[i], "quantum=", 8) == 0)
+                    nodo->quantum = atof(tokens[i] + 8);
+                else if (strncmp(tokens[i], "nucleo=", 7) == 0)
+                    nodo->nucleo = atoi(tokens[i] + 7);
+                else if (strncmp(tokens[i], "arg=", 4) == 0)
+                    snprintf(nodo->argumento, sizeof(nodo->argumento), "%s", tokens[i] + 4);
+                else if (strcmp(tokens[i], "disparo") == 0)
+                    nodo->por_disparo = 1;
+                else
+                    error_topologia(ruta, num_linea, "opción de nodo desconocida:", tokens[i]);
+            }
+            if (nodo->quantum <= 0.0)
+                error_topologia(ruta, num_linea, "quantum no válido en el nodo", nodo->nombre);
+        }
+        else if ((strcmp(tokens[0], "entrada") == 0 || strcmp(tokens[0], "tuberia") == 0) && n >= 3)
+        {
+            if (t->num_tuberias == MAX_TUBERIAS_TOPOLOGIA)
+                error_topologia(ruta, num_linea, "demasiadas tuberías", NULL);
+
+            TuberiaTopologia *tub = &t->tuberias[t->num_tuberias++];
+            if (tokens[0][0] == 'e')
+            {
+                tub->origen = EXTREMO_ARCHIVO;
+                snprintf(tub->archivo, sizeof(tub->archivo), "%s", tokens[1]);
+                tub->destino = buscar_nodo_topologia(t, tokens[2]);
+            }
+            else
+            {
+                tub->origen = buscar_nodo_topologia(t, tokens[1]);
+                if (tub->origen == NODO_DESCONOCIDO)
+                    error_topologia(ruta, num_linea, "nodo de origen desconocido:", tokens[1]);
+                tub->destino = strcmp(tokens[2], "kernel") == 0 ? EXTREMO_KERNEL : buscar_nodo_topologia(t, tokens[2]);
+            }
+            if (tub->destino == NODO_DESCONOCIDO)
+                error_topologia(ruta, num_linea, "nodo de destino desconocido:", tokens[2]);
+
+            for (int i = 3; i < n; i++)
+            {
+                if (strncmp(tokens[i], "capacidad=", 10) == 0 && atoi(tokens[i] + 10) > 0)
+                    tub->capacidad = atoi(tokens[i] + 10);
+                else
+                    error_topologia(ruta, num_linea, "opción de tubería no válida:", tokens[i]);
+            }
+        }
+        else if (strcmp(tokens[0], "disparo") == 0 && n >= 5)
+        {
+            if (t->num_disparos == MAX_DISPAROS_TOPOLOGIA)
+                error_topologia(ruta, num_linea, "demasiadas reglas de disparo", NULL);
+
+            DisparoTopologia *d = &t->disparos[t->num_disparos++];
+            d->nodo = buscar_nodo_topologia(t, tokens[1]);
+            if (d->nodo == NODO_DESCONOCIDO)
+                error_topologia(ruta, num_linea, "nodo de disparo desconocido:", tokens[1]);
+            if (strcmp(tokens[2], ">") && strcmp(tokens[2], ">=") && strcmp(tokens[2], "<") &&
+                strcmp(tokens[2], "<=") && strcmp(tokens[2], "==") && strcmp(tokens[2], "!="))
+                error_topologia(ruta, num_linea, "operador no válido:", tokens[2]);
+            snprintf(d->operador, sizeof(d->operador), "%s", tokens[2]);
+            d->umbral = atoi(tokens[3]);
+            snprintf(d->argumento_si, sizeof(d->argumento_si), "%s", tokens[4]);
+            for (int i = 5; i < n; i++)
+            {
+                if (strcmp(tokens[i], "diferido") == 0)
+                    d->diferido = 1;
+                else if (d->argumento_no[0] == '\0')
+                    snprintf(d->argumento_no, sizeof(d->argumento_no), "%s", tokens[i]);
+                else
+                    error_topologia(ruta, num_linea, "argumento de disparo sobrante:", tokens[i]);
+            }
+        }
+        else if (strcmp(tokens[0], "orden") == 0 && n >= 2)
+        {
+            for (int i = 1; i < n; i++)
+            {
+                int nodo = buscar_nodo_topologia(t, tokens[i]);
+                if (nodo == NODO_DESCONOCIDO || t->num_orden == MAX_NODOS_TOPOLOGIA)
+                    error_topologia(ruta, num_linea, "nodo desconocido en el orden:", tokens[i]);
+                t->orden[t->num_orden++] = nodo;
+            }
+        }
+        else
+        {
+            error_topologia(ruta, num_linea, "directiva no reconocida:", tokens[0]);
+        }
+    }
+    fclose(fp);
+
+    validar_topologia(t);
+    free(topologias[t->escenario]);
+    topologias[t->escenario] = t;
+}
+
+void lanzar_nodo_topologia(const Topologia *t, NodoTopologia *nodo, const char *argumento)
+{
+    char *argv[] = {"qemu-riscv32", nodo->ruta, (char *)argumento, NULL};
+    ArranqueHuesped arranque = {.entrada = nodo->fd_entrada, .salida = nodo->fd_salida, .nucleo = nodo->nucleo};
+    nodo->pid = intentar_lanzar_huesped(argv, &arranque, nodo->stats);
+    if (nodo->pid == -1)
+    {
+        char detalle[64];
+        snprintf(detalle, sizeof(detalle), "%s (%s)", nodo->nombre, strerror(errno));
+        error_topologia(t->ruta, nodo->linea, "no se pudo lanzar el nodo", detalle);
+    }
+    nodo->vivo = 1;
+}
+
+/* Tuberías con O_CLOEXEC: cada hijo solo conserva las que duplica sobre su entrada y su
+   salida estándar. Una entrada desde archivo se agranda hasta que quepa entera. */
+int crear_tuberias_topologia(Topologia *t)
+{
+    int fd_kernel = -1;
+
+    for (int i = 0; i < t->num_nodos; i++)
+    {
+        NodoTopologia *nodo = &t->nodos[i];
+        nodo->fd_entrada = nodo->fd_salida = -1;
+        nodo->pid = 0;
+        nodo->vivo = 0;
+        nodo->tiempo_acumulado = 0.0;
+        nodo->stats = stats_por_programa(nodo->ruta);
+    }
+
+    for (int i = 0; i < t->num_tuberias; i++)
+    {
+        TuberiaTopologia *tub = &t->tuberias[i];
+        if (pipe2(tub->fd, O_CLOEXEC) == -1)
+        {
+            perror(COLOR_ERROR "pipe de la topología" ANSI_RESET);
+            exit(1);
+        }
+
+        int capacidad = tub->capacidad;
+        struct stat st;
+        if (capacidad == 0 && tub->origen == EXTREMO_ARCHIVO && stat(tub->archivo, &st) == 0 &&
+            st.st_size > fcntl(tub->fd[1], F_GETPIPE_SZ))
+            capacidad = st.st_size;
+        if (capacidad > 0 && fcntl(tub->fd[1], F_SETPIPE_SZ, capacidad) == -1)
+            printf(COLOR_ERROR "[Control Central] AVISO: " ANSI_RESET "No se pudo dar %d bytes a la tubería %d de %s (%s).\n",
+                   capacidad, i, t->ruta, strerror(errno));
+
+        if (tub->destino >= 0)
+            t->nodos[tub->destino].fd_entrada = tub->fd[0];
+        else
+            fd_kernel = tub->fd[0];
+        if (tub->origen >= 0)
+            t->nodos[tub->origen].fd_salida = tub->fd[1];
+    }
+
+    if (fd_kernel >= 0)
+        fcntl(fd_kernel, F_SETFL, O_NONBLOCK);
+    return fd_kernel;
+}
+
+/* La latencia por etapas necesita la tubería que alimenta al nodo que escribe al kernel. */
+void vigilar_tuberias_topologia(const Topologia *t, int fd_kernel)
+{
+    if (fd_kernel < 0)
+        return;
+
+    int fd_intermedia = -1;
+    for (int i = 0; i < t->num_tuberias; i++)
+    {
+        const TuberiaTopologia *hacia_kernel = &t->tuberias[i];
+        if (hacia_kernel->destino != EXTREMO_KERNEL)
+            continue;
+        for (int j = 0; j < t->num_tuberias; j++)
+            if (t->tuberias[j].destino == hacia_kernel->origen && t->tuberias[j].origen >= 0)
+                fd_intermedia = t->tuberias[j].fd[0];
+    }
+    vigilar_pipes_lecturas(fd_intermedia, fd_kernel);
+}
+
+/* Los nodos con entrada deben quedar bloqueados leyéndola; el resto, al menos tras su exec. */
+void esperar_nodos_listos(const Topologia *t)
+{
+    double limite = tiempo_monotonico() + TIMEOUT_PRELANZAMIENTO;
+
+    for (int i = 0; i < t->num_orden; i++)
+    {
+        const NodoTopologia *nodo = &t->nodos[t->orden[i]];
+        while (!(nodo->fd_entrada >= 0 ? huesped_bloqueado(nodo->pid) : huesped_tras_exec(nodo->pid)))
+        {
+            if (tiempo_monotonico() >= limite)
+                return;
+            atender_canales();
+            usleep(1000);
+        }
+    }
+}
+
+int disparo_cumple(const DisparoTopologia *d, int valor)
+{
+    if (strcmp(d->operador, ">") == 0)
+        return valor > d->umbral;
+    if (strcmp(d->operador, ">=") == 0)
+        return valor >= d->umbral;
+    if (strcmp(d->operador, "<") == 0)
+        return valor < d->umbral;
+    if (strcmp(d->operador, "<=") == 0)
+        return valor <= d->umbral;
+    if (strcmp(d->operador, "==") == 0)
+        return valor == d->umbral;
+    return valor != d->umbral;
+}
+
+void lanzar_disparo_topologia(const Topologia *t, NodoTopologia *nodo, const char *argumento)
+{
+    struct timeval inicio;
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Lanzando %s%s con argumento: %s (regla de disparo).\n",
+           color_proceso(nodo->ruta), nombre_legible(nodo->ruta), argumento);
+
+    gettimeofday(&inicio, NULL);
+    lanzar_nodo_topologia(t, nodo, strcmp(argumento, "-") == 0 ? NULL : argumento);
+    esperar_proceso(nodo->pid, nodo->ruta, 0, &inicio);
+    nodo->vivo = 0;
+    registrar_actuacion_escudo();
+}
+
+void lanzar_disparos_diferidos(Topologia *t)
+{
+    for (int i = 0; i < t->num_disparos; i++)
+    {
+        DisparoTopologia *d = &t->disparos[i];
+        if (d->pendiente)
+        {
+            d->pendiente = 0;
+            lanzar_disparo_topologia(t, &t->nodos[d->nodo], d->argumento_pendiente);
+        }
+    }
+}
+
+void atender_registros_topologia(Topologia *t, int fd_kernel)
+{
+    int valor;
+
+    if (fd_kernel < 0 || leer_datos_p3(fd_kernel, &valor) == 0)
+        return;
+
+    for (int i = 0; i < t->num_disparos; i++)
+    {
+        DisparoTopologia *d = &t->disparos[i];
+        const char *argumento = disparo_cumple(d, valor) ? d->argumento_si : d->argumento_no;
+        if (argumento[0] == '\0')
+            continue;
+
+        if (d->diferido && t->modo == TOPOLOGIA_RR)
+        {
+            d->pendiente = 1;
+            snprintf(d->argumento_pendiente, sizeof(d->argumento_pendiente), "%s", argumento);
+        }
+        else
+        {
+            lanzar_disparo_topologia(t, &t->nodos[d->nodo], argumento);
+        }
+    }
+}
+
+void turno_nodo_topologia(NodoTopologia *nodo)
+{
+    struct rusage uso;
+    int status;
+    struct timeval inicio, fin;
+
+    aplicar_quantums_control();
+    if (nivel_log >= NIVEL_LOG_NORMAL)
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Activando %s%s (PID %d) por %.2f s...\n",
+               color_proceso(nodo->ruta), nombre_legible(nodo->ruta), nodo->pid, nodo->quantum);
+
+    gettimeofday(&inicio, NULL);
+    nodo->stats->tiempo_pausado_total += timeval_diff(&nodo->ultima_parada, &inicio);
+    reanudar_huesped(nodo->pid, nodo->stats, nodo->quantum);
+    if (politica_actual == POLITICA_DATOS)
+        dormir_quantum_datos(nodo->quantum, nodo->pid, -1, nodo->stats);
+    else
+        dormir_quantum(nodo->quantum);
+    gettimeofday(&fin, NULL);
+
+    double turno = timeval_diff(&inicio, &fin);
+    nodo->tiempo_acumulado += turno;
+    nodo->stats->quantum_dado_total += nodo->quantum;
+    nodo->stats->quantum_usado_total += turno;
+
+    if (sondear_hijo(nodo->pid, &status, &uso) == nodo->pid)
+    {
+        nodo->vivo = 0;
+        printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "%s%s (PID %d) terminó." ANSI_RESET "\n",
+               color_proceso(nodo->ruta), nombre_legible(nodo->ruta), nodo->pid);
+        guardar_stats_proceso(nodo->ruta, nodo->pid, nodo->tiempo_acumulado, &uso, status);
+    }
+    else
+    {
+        if (nivel_log >= NIVEL_LOG_NORMAL)
+            printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Deteniendo %s%s (PID %d). Tiempo agotado.\n",
+                   color_proceso(nodo->ruta), nombre_legible(nodo->ruta), nodo->pid);
+        detener_huesped(nodo->pid, nodo->stats);
+        gettimeofday(&nodo->ultima_parada, NULL);
+        nodo->stats->num_pausas++;
+    }
+}
+
+void ejecutar_topologia(Topologia *t)
+{
+    int fd_kernel = crear_tuberias_topologia(t);
+
+    for (int i = 0; i < t->num_orden; i++)
+    {
+        NodoTopologia *nodo = &t->nodos[t->orden[i]];
+        lanzar_nodo_topologia(t, nodo, nodo->argumento[0] ? nodo->argumento : NULL);
+    }
+
+    vigilar_tuberias_topologia(t, fd_kernel);
+    for (int i = 0; i < t->num_tuberias; i++)
+    {
+        if (t->tuberias[i].destino >= 0)
+            close(t->tuberias[i].fd[0]);
+        if (t->tuberias[i].origen >= 0)
+            close(t->tuberias[i].fd[1]);
+    }
+
+    if (t->modo != TOPOLOGIA_PARALELA)
+    {
+        esperar_nodos_listos(t);
+        for (int i = 0; i < t->num_orden; i++)
+        {
+            NodoTopologia *nodo = &t->nodos[t->orden[i]];
+            detener_huesped(nodo->pid, nodo->stats);
+            gettimeofday(&nodo->ultima_parada, NULL);
+            nodo->stats->num_pausas++;
+        }
+    }
+
+    for (int i = 0; i < t->num_tuberias; i++)
+    {
+        if (t->tuberias[i].origen == EXTREMO_ARCHIVO)
+        {
+            enviar_contenido_archivo_a_pipe(t->tuberias[i].fd[1], t->tuberias[i].archivo);
+        }
+    }
+    enviar_escrituras_es();
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Topología %s: %d nodos iniciales, modo %s. Iniciando...\n",
+           t->ruta, t->num_orden, NOMBRES_MODOS_TOPOLOGIA[t->modo]);
+
+    if (t->modo == TOPOLOGIA_SECUENCIAL)
+    {
+        for (int i = 0; i < t->num_orden; i++)
+        {
+            NodoTopologia *nodo = &t->nodos[t->orden[i]];
+            struct timeval inicio;
+
+            gettimeofday(&inicio, NULL);
+            nodo->stats->tiempo_pausado_total += timeval_diff(&nodo->ultima_parada, &inicio);
+            reanudar_huesped(nodo->pid, nodo->stats, 0.0);
+            esperar_proceso(nodo->pid, nodo->ruta, 0, &inicio);
+            nodo->vivo = 0;
+            atender_registros_topologia(t, fd_kernel);
+        }
+    }
+    else if (t->modo == TOPOLOGIA_RR)
+    {
+        int vivos = t->num_orden;
+        while (vivos > 0)
+        {
+            lanzar_disparos_diferidos(t);
+            vivos = 0;
+            for (int i = 0; i < t->num_orden; i++)
+            {
+                NodoTopologia *nodo = &t->nodos[t->orden[i]];
+                if (!nodo->vivo)
+                    continue;
+                turno_nodo_topologia(nodo);
+                atender_registros_topologia(t, fd_kernel);
+                vivos += nodo->vivo;
+            }
+        }
+        lanzar_disparos_diferidos(t);
+    }
+    else
+    {
+        struct timeval inicio;
+        int vivos = t->num_orden;
+        int canal_abierto = fd_kernel >= 0;
+
+        gettimeofday(&inicio, NULL);
+        while (vivos > 0)
+        {
+            if (canal_abierto)
+            {
+                struct pollfd pfd = {.fd = fd_kernel, .events = POLLIN};
+                if (poll(&pfd, 1, EDF_TRAMO_SONDEO_MS) > 0 && !(pfd.revents & POLLIN))
+                    canal_abierto = 0;
+            }
+            else
+            {
+                usleep(EDF_TRAMO_SONDEO_MS * 1000);
+            }
+
+            atender_registros_topologia(t, fd_kernel);
+            muestrear_latencias();
+            atender_canales();
+
+            for (int i = 0; i < t->num_orden; i++)
+            {
+                NodoTopologia *nodo = &t->nodos[t->orden[i]];
+                struct rusage uso;
+                struct timeval fin;
+                int status;
+
+                if (!nodo->vivo || sondear_hijo(nodo->pid, &status, &uso) != nodo->pid)
+                    continue;
+                gettimeofday(&fin, NULL);
+                nodo->vivo = 0;
+                vivos--;
+                proceso_terminado(nodo->ruta, nodo->pid);
+                guardar_stats_proceso(nodo->ruta, nodo->pid, timeval_diff(&inicio, &fin), &uso, status);
+            }
+        }
+    }
+
+    atender_registros_topologia(t, fd_kernel);
+    if (fd_kernel >= 0)
+        close(fd_kernel);
+
+    printf(COLOR_KERNEL "[Control Central] " ANSI_RESET "Topología %s finalizada.\n", t->ruta);
+}
@@ -0,0 +1,83 @@
+#ifndef TOPOLOGIA_H
+#define TOPOLOGIA_H
+
+#define MAX_NODOS_TOPOLOGIA 8
+#define MAX_TUBERIAS_TOPOLOGIA 16
+#define MAX_DISPAROS_TOPOLOGIA 4
+#define NODO_DESCONOCIDO -1
+#define EXTREMO_KERNEL -2
+#define EXTREMO_ARCHIVO -3
+
+typedef enum
+{
+    TOPOLOGIA_SECUENCIAL = 0,
+    TOPOLOGIA_RR,
+    TOPOLOGIA_PARALELA
+} ModoTopologia;
+
+typedef struct
+{
+    char nombre[16];
+    char ruta[128];
+    char argumento[16];
+    double quantum;
+    int nucleo;
+    int por_disparo;
+    int linea;
+
+    pid_t pid;
+    int vivo;
+    int fd_entrada;
+    int fd_salida;
+    ProcesoStats *stats;
+    double tiempo_acumulado;
+    struct timeval ultima_parada;
+} NodoTopologia;
+
+typedef struct
+{
+    int origen;
+    int destino;
+    char archivo[128];
+    int capacidad;
+    int fd[2];
+} TuberiaTopologia;
+
+typedef struct
+{
+    int nodo;
+    char operador[3];
+    int umbral;
+    char argumento_si[16];
+    char argumento_no[16];
+    int diferido;
+    int pendiente;
+    char argumento_pendiente[16];
+} DisparoTopologia;
+
+typedef struct
+{
+    char ruta[PATH_MAX];
+    int escenario;
+    ModoTopologia modo;
+    NodoTopologia nodos[MAX_NODOS_TOPOLOGIA];
+    int num_nodos;
+    TuberiaTopologia tuberias[MAX_TUBERIAS_TOPOLOGIA];
+    int num_tuberias;
+    DisparoTopologia disparos[MAX_DISPAROS_TOPOLOGIA];
+    int num_disparos;
+    int orden[MAX_NODOS_TOPOLOGIA];
+    int num_orden;
+} Topologia;
+
+extern const char *NOMBRES_MODOS_TOPOLOGIA[];
+extern Topologia *topologias[5];
+
+void error_topologia(const char *ruta, int linea, const char *mensaje, const char *detalle);
+int buscar_nodo_topologia(const Topologia *t, const char *nombre);
+void validar_topologia(Topologia *t);
+void cargar_topologia(const char *ruta);
+int disparo_cumple(const DisparoTopologia *d, int valor);
+void ejecutar_topologia(Topologia *t);
+
+#endif